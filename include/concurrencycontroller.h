@@ -0,0 +1,94 @@
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QString>
+#include <functional>
+
+class QThreadPool;
+
+// 受控的工作负载类型
+enum class WorkloadKind {
+    PosterExtraction,   // FFmpeg 提取封面/雪碧图
+    CoverDecode,        // 图片解码
+    ContentHash         // 读取文件内容计算哈希（查找重复）
+};
+
+// 自适应并发控制器：按存储设备和负载类型分别维护线程池，
+// 根据每个任务的耗时和吞吐量用 AIMD（加性增、乘性减）调整并发数。
+// USB 机械硬盘上会收敛到 1-2 个并发，NVMe 上可以增长到 8 个以上。
+class ConcurrencyController : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ConcurrencyController* instance();
+    ~ConcurrencyController();
+
+    // 提交任务；path 用于确定任务所在的存储设备。可在任意线程调用。
+    // owner 不为空时记录任务的归属，所有者析构前用 cancel() 和 waitFor() 收回自己的任务
+    void submit(const QString &path, WorkloadKind kind, std::function<void()> job,
+                const QObject *owner = nullptr);
+
+    // 丢弃 owner 尚未开始的任务；已开始的任务不受影响
+    void cancel(const QObject *owner);
+    // 等待 owner 已开始的任务全部结束（先 cancel，否则还要等排队的任务）。
+    // 任务中不能阻塞等待调用线程，例如不能用 BlockingQueuedConnection 回到界面线程
+    void waitFor(const QObject *owner);
+
+    // 当前并发水平的简要文本（用于状态栏）和详细文本（用于提示）
+    QString statusText() const;
+    QString detailText() const;
+
+signals:
+    void levelChanged(const QString &device, WorkloadKind kind, int limit);
+
+private:
+    struct Lane {
+        QString device;
+        WorkloadKind kind;
+        QThreadPool *pool = nullptr;
+        int limit = 2;
+        int minLimit = 1;
+        int maxLimit = 8;
+        int pending = 0;            // 已提交未完成的任务数
+        bool backlogged = false;    // 本窗口内是否出现过排队（只在有积压时调整）
+        bool lastWasIncrease = false;
+
+        // 当前统计窗口
+        int windowCount = 0;
+        double windowLatencySum = 0;
+        QElapsedTimer windowTimer;
+
+        double bestLatency = 0;     // 观测到的最佳平均耗时（毫秒），作为延迟基线
+        double lastLatency = 0;
+        double lastThroughput = 0;  // 每秒完成的任务数
+    };
+
+    class Task;
+
+    explicit ConcurrencyController(QObject *parent = nullptr);
+
+    Lane* laneFor(const QString &path, WorkloadKind kind);
+    QString deviceFor(const QString &path);
+    void recordCompletion(Lane *lane, qint64 elapsedMs);
+    void taskStarted(Task *task);
+    void taskFinished(Task *task);
+    static QString kindName(WorkloadKind kind);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Lane*> m_lanes;          // "设备|类型" -> 通道
+    QHash<QString, QString> m_deviceCache;  // 文件夹 -> 设备根路径
+
+    // 有所有者的任务：尚未开始的（可以从线程池取回）和未结束的数量
+    QHash<const QObject*, QSet<Task*>> m_queuedByOwner;
+    QHash<const QObject*, int> m_activeByOwner;
+    QWaitCondition m_ownerIdle;
+};
+
+#endif // CONCURRENCYCONTROLLER_H
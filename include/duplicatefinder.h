@@ -0,0 +1,97 @@
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QAtomicInteger>
+#include <QImage>
+#include <memory>
+
+// 一组内容相同（或封面相似）的视频
+struct DuplicateGroup {
+    qint64 fileSize = 0;       // 内容相同时的文件大小；封面相似的组为 0（各文件大小不同）
+    bool verified = false;     // 已按完整内容确认；否则只是抽样一致
+    bool similarCover = false; // 按封面感知哈希找到（不同编码的同一作品）
+    QVector<quint32> videoIds;
+};
+
+// 封面相似查找支持的最大汉明距离：哈希分为 4 段 16 位，距离不超过 7 时
+// 至少有一段最多相差 1 位，每段只需查找原值和 16 个单位翻转
+const int MAX_COVER_DISTANCE = 7;
+
+// 重复视频查找：先按文件大小分组，只有大小相同的文件才读取内容；
+// 同组内对文件头、尾和中间几块抽样计算哈希，需要时再对抽样一致的文件计算完整哈希。
+// 读取任务按所在存储设备提交给 ConcurrencyController，各设备的并发分别控制。
+// 哈希保存在 VideoCatalog 中，重新扫描后再次查找只读取新增或变化的文件。
+// 重新编码的同一作品字节不同，改为比较封面的感知哈希（dHash），
+// 用多索引哈希表找出汉明距离不超过给定值的所有封面对。
+// 在主线程中使用
+class DuplicateFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DuplicateFinder(QObject *parent = nullptr);
+    ~DuplicateFinder();
+
+    // 在给定的视频中查找重复；verifyFull 为 true 时对抽样一致的文件再计算完整哈希。
+    // 正在查找时先取消上一次
+    void start(const QVector<quint32> &videoIds, bool verifyFull);
+    // 查找封面相似的视频（距离上限不超过 MAX_COVER_DISTANCE）；没有封面哈希或封面文件变化过的视频先读取封面
+    void startSimilarCovers(const QVector<quint32> &videoIds, int maxDistance);
+    void cancel();
+    bool isRunning() const { return m_pending > 0; }
+
+    // 抽样哈希：文件大小、文件头、尾和中间几块；小文件直接计算完整哈希（结果与 fullHash 相同）
+    static bool sampledHash(const QString &path, qint64 fileSize, quint64 *hash, QString *errorReason = nullptr);
+    // 完整哈希：顺序读取整个文件
+    static bool fullHash(const QString &path, quint64 *hash, QString *errorReason = nullptr);
+
+    // 抽样覆盖整个文件的大小上限，不超过此大小的文件抽样哈希即完整哈希
+    static qint64 sampleCoverage();
+
+    // 64 位差值哈希（dHash）：缩小为 9x8 灰度图，每行相邻像素比较得到 8 位
+    static quint64 coverHash(const QImage &image);
+    // 在按缩略图尺寸解码的封面上计算 dHash，找不到或无法解码封面时返回 false
+    static bool readCoverHash(const QString &coverPath, quint64 *hash);
+
+    // 所有汉明距离不超过 maxDistance 的哈希对（下标 i < j）。多索引哈希：
+    // 哈希分为 4 段，按每段的值建立桶（计数排序后的连续数组），查找时只比较共享桶中的候选
+    static QVector<QPair<int, int>> similarPairs(const QVector<quint64> &hashes, int maxDistance);
+
+signals:
+    void progress(int done, int total);
+    void finished(const QVector<DuplicateGroup> &groups);
+
+private:
+    enum class Phase { Idle, Sample, Full, Cover };
+
+    // 为没有缓存哈希的视频提交计算任务，全部完成（或都已缓存）时进入下一阶段
+    void runPhase(Phase phase);
+    void onHashed(quint64 generation);
+    void finish();
+    // 在工作线程中按封面哈希聚类，完成后发送 finished
+    void groupSimilarCovers();
+
+    static bool cachedHash(Phase phase, quint32 id, quint64 *hash);
+    // 在工作线程中计算并写入 VideoCatalog
+    static void computeHash(Phase phase, quint32 id, const QString &path, qint64 size);
+
+    // 按 (大小, 哈希) 重新分组，只保留两个以上的组
+    QVector<QVector<quint32>> regroup(Phase phase) const;
+
+    QVector<QVector<quint32>> m_groups;  // 当前阶段的候选组
+    std::shared_ptr<const QVector<quint32>> m_entries; // 本次查找持有目录引用的视频，任务也各持一份
+    bool m_verifyFull = false;
+    int m_maxCoverDistance = 0;
+    Phase m_phase = Phase::Idle;
+    int m_pending = 0;
+    int m_done = 0;
+    int m_total = 0;
+    // 每次 start 或 cancel 递增，工作线程据此放弃已过时的任务
+    std::shared_ptr<QAtomicInteger<quint64>> m_generation;
+};
+
+#endif // DUPLICATEFINDER_H
@@ -0,0 +1,74 @@
+#ifndef FACETINDEX_H
+#define FACETINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include "roaringbitmap.h"
+#include "videosearch.h"
+#include "nforeader.h"
+
+// 分面的一个取值及其视频数
+struct FacetCount {
+    QString value;
+    int count = 0;
+};
+
+// 分面过滤索引：演员、类别和片商的每个取值对应一个视频 ID 位图，
+// 发行日期、文件大小和评分各有一个按值排序的列（值与 ID 并列存放），范围条件用二分查找截取。
+// 过滤条件求值为位图的交、并、差，全库过滤不逐个读取元数据。
+// 只在主线程中维护和查询，不加锁
+class FacetIndex
+{
+public:
+    FacetIndex() = default;
+
+    // 添加或更新视频（同一 id 重复添加时先移除旧内容）
+    void insert(quint32 id, const VideoMetadata &metadata, qint64 fileSize);
+    void remove(quint32 id);
+    void clear();
+
+    // 全部已索引的视频
+    const RoaringBitmap& all() const { return m_all; }
+
+    // 满足全部过滤条件的视频。取值条件按子串匹配（与 VideoSearchQuery::matchesFilters 一致）
+    RoaringBitmap evaluate(const QVector<FacetFilter> &filters) const;
+
+    // 取值分面在 within 中视频数最多的 limit 个取值，按视频数降序
+    QVector<FacetCount> counts(FacetField field, const RoaringBitmap &within, int limit) const;
+
+private:
+    // 一个取值分面：取值表（原文和折叠大小写后的文字）与各取值的位图
+    struct ValueFacet {
+        QVector<QString> names;
+        QVector<QString> folded;
+        QVector<RoaringBitmap> bitmaps;
+        QHash<QString, int> index; // 折叠后的取值 -> 下标
+    };
+
+    // 一个范围分面：按 ID 存放的值，以及按值排序的列（修改后在下次查询时重建）
+    struct RangeColumn {
+        QVector<qint64> valueById;          // 没有值的位置为 NO_VALUE
+        mutable QVector<qint64> values;     // 升序
+        mutable QVector<quint32> ids;       // 与 values 一一对应
+        mutable bool dirty = false;
+
+        void set(quint32 id, qint64 value);
+        void sort() const;
+    };
+
+    static const qint64 NO_VALUE;
+
+    void addValue(FacetField field, quint32 id, const QString &name);
+    RoaringBitmap valueBitmap(const FacetFilter &filter) const;
+    RoaringBitmap rangeBitmap(const FacetFilter &filter) const;
+
+    ValueFacet m_values[VALUE_FACET_COUNT];
+    RangeColumn m_ranges[RANGE_FACET_COUNT];
+    // 各视频所在的取值（分面 << 24 | 取值下标），用于移除
+    QHash<quint32, QVector<quint32>> m_valuesById;
+    RoaringBitmap m_all;
+};
+
+#endif // FACETINDEX_H
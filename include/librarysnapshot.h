@@ -0,0 +1,26 @@
+#ifndef LIBRARYSNAPSHOT_H
+#define LIBRARYSNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <memory>
+#include "videoitem.h"
+
+// 媒体库快照：上次扫描得到的各目录视频列表及其目录条目（大小、时间、NFO 元数据和内容哈希）。
+// 启动时先由快照显示网格，再在后台重新扫描并按差异更新；文件未变化的视频沿用原 ID，
+// NFO 和哈希在重启后也不必重新读取。二进制格式，写入时原子替换
+class LibrarySnapshot
+{
+public:
+    // 读取快照并创建视频（条目写入 VideoCatalog），只保留 directories 中的目录。
+    // 在工作线程中调用；文件不存在或格式不符时返回空
+    static QHash<QString, QVector<std::shared_ptr<VideoItem>>> load(const QString &filePath,
+                                                                    const QStringList &directories);
+
+    // 写出各目录的视频（按 ID 从 VideoCatalog 读取条目，条目不会被清除）。可在工作线程调用
+    static bool save(const QString &filePath, const QHash<QString, QVector<quint32>> &videoIdsByDirectory);
+};
+
+#endif // LIBRARYSNAPSHOT_H
@@ -7,31 +7,24 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QProgressBar>
-#include <QScrollArea>
-#include <QGridLayout>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QSettings>
 #include <QCloseEvent>
 #include <QMenu>
 #include <QAction>
 #include <QLineEdit>
 #include <QTabWidget>
 #include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <memory>
 #include "videolibrary.h"
+#include "videolistmodel.h"
+#include "duplicatefinder.h"
 
-class VideoWidget;
-
-// 定义排序方式枚举
-enum class SortOrder {
-    CreationTimeAsc,    // 创建时间升序
-    CreationTimeDesc,   // 创建时间降序
-    ModifiedTimeAsc,    // 修改时间升序
-    ModifiedTimeDesc,   // 修改时间降序
-    NameAsc,            // 文件名升序
-    NameDesc            // 文件名降序
-};
+class VideoGridView;
+class MergedVideoModel;
+class SettingsStore;
 
 class MainWindow : public QMainWindow
 {
@@ -43,12 +36,13 @@ public:
 
 protected:
     void closeEvent(QCloseEvent *event) override;
-    void resizeEvent(QResizeEvent *event) override;
 
 private slots:
     void onAddDirectory();
     void onScanLibrary();
-    void onVideoAdded(const QString& directory, std::shared_ptr<VideoItem> video);
+    void onVideosAdded(const QString& directory, const QVector<quint32>& videoIds);
+    void onVideosRemoved(const QString& directory, const QVector<quint32>& videoIds);
+    void onSnapshotLoaded(int videoCount); // 快照已显示，开始后台扫描
     void onScanStarted();
     void onScanProgress(int current, int total);
     void onScanFinished();
@@ -57,18 +51,25 @@ private slots:
     void onIncreaseThumbnailSize();
     void onDecreaseThumbnailSize();
     void onToggleSortOrder();    // 新增：切换排序方式
+    void onToggleHoverScrub();   // 切换悬停预览模式
     void onSearchTextChanged(const QString &text); // 新增：处理搜索文本变化
-    void onVideoPosterReady(std::shared_ptr<VideoItem> video); // 新增：处理封面生成完成
+    void onVideoPosterReady(quint32 videoId); // 新增：处理封面生成完成
+    void onVideoSpriteSheetReady(quint32 videoId); // 悬停预览雪碧图生成完成
+    void onVideoPosterFailed(quint32 videoId); // 封面提取失败
+    void onFindDuplicates(bool verifyFull);    // 在全库中查找重复视频
+    void onFindSimilarCovers();                // 在全库中查找封面相似的视频（不同编码）
+    void onDuplicateProgress(int done, int total);
+    void onDuplicatesFound(const QVector<DuplicateGroup> &groups);
+    void updateConcurrencyStatus(); // 更新自适应并发状态显示
     void updateDirectoryList();
-    void clearVideoWidgets();
-    void clearVideoWidgetsInTab(QWidget* tabContentWidget);
     void adjustGridColumns();
-    void reLayoutVideos();
-    void reLayoutFilteredVideos();
     void sortVideos();
     void updateSortButtonText();
     void filterVideos();
-    void refreshVideoDisplay();
+    void updateTabTitles();
+    void updateFacetToolTip();  // 搜索框提示中显示当前结果的分面计数
+    void onCurrentTabChanged(int index);
+    void releaseIdleTabViews();
 
 private:
     void createUI();
@@ -76,14 +77,52 @@ private:
     void createMenus();
     void saveSettings();
     void loadSettings();
-    int calculateColumnsForTab(QWidget* tabContentWidget);
-    void reLayoutVideosInTab(QWidget* tabContentWidget);
+
+    // 一个媒体库目录的标签页。模型和视图在标签页首次显示时才创建（排序和布局也推迟到此时），
+    // 之前只保存视频列表，标签上的数量直接由列表或搜索匹配数得出；
+    // 长时间未显示的标签页会释放模型和视图，回到这一状态
+    struct LibraryTab {
+        QWidget *page = nullptr;                    // 加入 TabWidget 的容器
+        QVector<std::shared_ptr<VideoItem>> videos; // 该目录的全部视频（模型绘制时读取封面图，因此持有对象）
+        int matchCount = 0;                         // 当前搜索条件下的匹配数
+        VideoListModel *model = nullptr;            // 未创建时为空
+        VideoGridView *view = nullptr;
+        qint64 hiddenSinceMs = 0;                   // 切换到其他标签页的时间
+    };
+
+    // 获取或创建目录对应的标签页（只创建容器，不创建视图）
+    QWidget* createTabPage();
+    LibraryTab& ensureTab(const QString& directory);
+    void removeTab(const QString& directory);
+
+    // 创建 / 释放标签页的模型和视图
+    VideoListModel* ensureTabModel(const QString& directory);
+    VideoGridView* createGridView(AbstractVideoModel* model, QWidget* page);
+    VideoGridView* materializeTab(const QString& directory);
+    void releaseTabView(LibraryTab &tab);
+
+    // “全部”标签页：归并各目录的模型，需要时为未显示的目录创建模型（不创建视图）
+    VideoGridView* materializeAllTab();
+    void updateAllTabSources();
+    void releaseAllTabView();
+
+    // 当前标签页的目录和视图（视图未创建时为空），以及所有已创建的视图
+    QString currentTabDirectory() const;
+    VideoGridView* currentTabView() const;
+    QVector<VideoGridView*> tabViews() const;
+
+    // 标签上显示的视频数（过滤后）
+    int visibleCount(const LibraryTab &tab) const;
+
+    // 按目录名顺序计算新标签页的插入位置
+    int tabInsertIndex(const QString& directory) const;
 
     // 视频库
     VideoLibrary *m_library;
 
     // 配置文件路径
     QString m_configFile;
+    SettingsStore *m_settings;   // 内存中的配置，延迟在后台写盘
 
     // UI组件
     QWidget *m_centralWidget;
@@ -98,8 +137,11 @@ private:
     QPushButton *m_increaseButton;
     QPushButton *m_decreaseButton;
     QPushButton *m_sortButton;   // 新增：排序按钮
+    QPushButton *m_hoverScrubButton; // 悬停预览开关
+    QPushButton *m_duplicateButton;  // 查找重复视频（菜单：抽样比较 / 完整校验）
     QLineEdit *m_searchEdit;     // 新增：搜索框
     QLabel *m_statusLabel;
+    QLabel *m_concurrencyLabel;  // 自适应并发状态
     QProgressBar *m_progressBar;
     
     // 底部状态栏
@@ -107,12 +149,18 @@ private:
     
     // 视频显示区域 - 修改为 QTabWidget
     QTabWidget *m_tabWidget;
-    // 使用 QHash 管理每个标签页的内容 (QWidget 包含 QScrollArea 和 QGridLayout)
-    QHash<QString, QWidget*> m_tabContents;
-    // 使用 QHash 管理每个标签页的网格布局
-    QHash<QString, QGridLayout*> m_tabGridLayouts;
-    // 使用 QHash 管理每个标签页的视频小部件列表
-    QHash<QString, QList<VideoWidget*>> m_tabVideoWidgets;
+    // 每个媒体库目录一个标签页，视图只绘制可见的单元格
+    QHash<QString, LibraryTab> m_tabs;
+    QHash<QWidget*, QString> m_directoryOfPage;
+    // 视频 ID -> 所在标签页的目录，封面完成等回调据此 O(1) 定位单元格
+    QHash<quint32, QString> m_directoryOfVideo;
+    QWidget *m_currentPage;
+    QTimer *m_tabReleaseTimer;   // 定期释放长时间未显示的标签页视图
+    // “全部”标签页：按当前排序方式归并显示所有目录，共用一个滚动位置
+    QWidget *m_allPage;
+    MergedVideoModel *m_allModel;
+    VideoGridView *m_allView;
+    qint64 m_allHiddenSinceMs;
     
     // 目录列表
     QMenu *m_dirMenu;
@@ -124,42 +172,16 @@ private:
     bool m_useFanartMode;
     SortOrder m_sortOrder;       // 新增：当前排序方式
     QString m_searchText;        // 新增：当前搜索文本
-};
-
-// 视频小部件，显示单个视频项目
-class VideoWidget : public QWidget
-{
-    Q_OBJECT
-
-public:
-    VideoWidget(std::shared_ptr<VideoItem> video, int thumbnailSize, bool useFanart, QWidget *parent = nullptr);
-    
-    std::shared_ptr<VideoItem> video() const { return m_video; }
-    void setThumbnailSize(int size);
-    void updateThumbnail();
-    
-    // 新增：设置封面模式
-    void setUseFanartMode(bool useFanart);
-    bool useFanartMode() const { return m_useFanartMode; }
-    
-    // 新增：选中状态管理
-    bool isSelected() const { return m_selected; }
-    void setSelected(bool selected) { m_selected = selected; update(); }
-
-protected:
-    void mousePressEvent(QMouseEvent *event) override;
-    void mouseDoubleClickEvent(QMouseEvent *event) override; // 新增：双击事件
-    void paintEvent(QPaintEvent *event) override;
-    void enterEvent(QEnterEvent *event) override;
-    void leaveEvent(QEvent *event) override;
-
-private:
-    std::shared_ptr<VideoItem> m_video;
-    QLabel *m_titleLabel;
-    int m_thumbnailSize;
-    bool m_hover;
-    bool m_useFanartMode; // 现在在构造函数中初始化
-    bool m_selected;      // 新增：是否被选中
+    VideoSearchQuery m_searchQuery; // 当前生效的搜索条件
+    QVector<SearchMatch> m_searchMatches; // 当前搜索的全库匹配结果，新建的模型直接应用
+    QTimer *m_searchTimer;       // 搜索输入防抖，停止输入后才应用过滤
+    bool m_hoverScrubEnabled;    // 是否启用悬停预览
+    DuplicateFinder *m_duplicateFinder; // 重复视频查找，哈希缓存在 VideoCatalog 中
+
+    // 启动计时：从构造窗口到第一次显示出视频网格
+    QElapsedTimer m_startupTimer;
+    QElapsedTimer m_scanTimer;
+    bool m_firstGridShown;
 };
 
 #endif // MAINWINDOW_H 
\ No newline at end of file
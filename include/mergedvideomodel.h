@@ -0,0 +1,75 @@
+#ifndef MERGEDVIDEOMODEL_H
+#define MERGEDVIDEOMODEL_H
+
+#include <QVector>
+#include "videolistmodel.h"
+
+// “全部视频”标签页的模型：把各媒体库目录的模型（已按相同排序方式和搜索排名有序）
+// 做 k 路归并后呈现，不复制合并后的列表。
+// 归并是惰性的：按需从最近的检查点（每 MERGE_CHECKPOINT_INTERVAL 行记录一次
+// 各源的游标）向前推进，顺序绘制可见行时每行只推进一步。
+// 源模型插入或移除行时换算为合并后的行号转发（视图的选择、悬停等状态得以保留），
+// 并丢弃检查点；排序、过滤等整体变化才重置本模型
+class MergedVideoModel : public AbstractVideoModel
+{
+    Q_OBJECT
+
+public:
+    explicit MergedVideoModel(QObject *parent = nullptr);
+
+    // 设置参与归并的源模型，顺序即排序键相同时的先后顺序
+    void setSources(const QVector<VideoListModel*> &sources);
+    QVector<VideoListModel*> sources() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    std::shared_ptr<VideoItem> videoAt(int row) const override;
+    // 在各源中逐个二分查找排在该视频之前的行数：O(k log n)
+    int rowOf(quint32 videoId) const override;
+
+private:
+    // 合并后的第 row 行来自哪个源的哪一行
+    bool locate(int row, int *source, int *sourceRow) const;
+
+    // 把游标推进一行（取出当前最小的源头部），返回被取出的源，全部取完时返回 -1
+    int advance(QVector<int> &cursor) const;
+    int minHead(const QVector<int> &cursor) const;
+
+    // 源 a 的第 rowA 行是否排在源 b 的第 rowB 行之前
+    bool headLess(int a, int rowA, int b, int rowB) const;
+
+    // 源 source 中排在（源 other 的第 otherRow 行）之前的行数
+    int countBefore(int source, int other, int otherRow) const;
+
+    // 源 source 的第 sourceRow 行在合并后的行号
+    int mergedRow(int source, int sourceRow) const;
+
+    // 源 source 的 first..last 行在合并后的行号（升序）
+    QVector<int> mergedRows(int source, int first, int last) const;
+
+    void sourceRowsInserted(int source, int first, int last);
+    void sourceRowsAboutToBeRemoved(int source, int first, int last);
+    void sourceRowsRemoved(int source);
+    void sourceAboutToChange();
+    void sourceChanged();
+    void invalidate();
+    void resetCursor();
+
+    QVector<VideoListModel*> m_sources;
+    QVector<int> m_counts;   // 各源的可见行数
+    int m_rowCount;
+    SortOrder m_sortOrder;   // 各源共同的排序方式
+    bool m_resetting;
+
+    // 检查点：第 c 个检查点为合并行 c * MERGE_CHECKPOINT_INTERVAL 处各源的游标，
+    // 按源依次平铺保存
+    mutable QVector<int> m_checkpoints;
+    mutable int m_checkpointCount;
+
+    // 最近一次定位的位置，顺序访问时从这里继续推进
+    mutable QVector<int> m_cursor;
+    mutable int m_cursorRow;
+};
+
+#endif // MERGEDVIDEOMODEL_H
@@ -0,0 +1,32 @@
+#ifndef NFOREADER_H
+#define NFOREADER_H
+
+#include <QString>
+#include <QStringList>
+#include <QDate>
+
+// 从 NFO 中读取的视频元数据
+struct VideoMetadata {
+    QString title;         // 标题
+    QStringList actors;    // 演员
+    QStringList genres;    // 类别
+    QString studio;        // 片商
+    QDate releaseDate;     // 发行日期
+    float rating = 0;      // 评分（0-10），0 表示没有评分
+
+    bool isEmpty() const { return title.isEmpty() && actors.isEmpty() && genres.isEmpty() && studio.isEmpty(); }
+};
+
+// JavSP 等刮削工具生成的 Kodi 格式 NFO（<movie> 根元素）的流式读取器。
+// 用 QXmlStreamReader 一次顺序读取，不建 DOM；无状态，可在多个工作线程中同时调用
+class NfoReader
+{
+public:
+    // 视频对应的 NFO 候选文件名：与视频同名的 .nfo，以及一个视频一个文件夹时的 movie.nfo
+    static QStringList candidateNames(const QString &videoFileName);
+
+    // 读取 NFO，失败时通过 errorReason 返回原因
+    static bool read(const QString &nfoPath, VideoMetadata *metadata, QString *errorReason = nullptr);
+};
+
+#endif // NFOREADER_H
@@ -0,0 +1,55 @@
+#ifndef POSTERFAILURECACHE_H
+#define POSTERFAILURECACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QDateTime>
+#include <QMutex>
+
+// 单个视频的封面提取失败记录
+struct PosterFailure {
+    QString reason;          // 最近一次失败原因
+    int attempts = 0;        // 连续失败次数
+    qint64 fileSize = 0;     // 失败时的文件大小
+    QDateTime fileModified;  // 失败时的文件修改时间
+    QDateTime lastAttempt;   // 最近一次尝试时间
+    QDateTime nextRetry;     // 指数退避后允许再次尝试的时间
+};
+
+// 封面提取失败的负缓存，持久化到配置目录下的 poster_failures.ini
+// 文件大小或修改时间变化后记录自动失效；可在工作线程中调用。
+// 记录和清除只修改内存，由调用者合并后调用 save() 写盘
+class PosterFailureCache
+{
+public:
+    PosterFailureCache() = default;
+
+    void setFilePath(const QString &filePath);
+    void load();
+    // 有修改时写盘；写文件时不持有锁，不阻塞工作线程
+    void save();
+
+    // 记录一次失败并计算下次重试时间，返回更新后的记录
+    PosterFailure recordFailure(const QString &videoPath, qint64 fileSize,
+                                const QDateTime &fileModified, const QString &reason);
+
+    // 提取成功或文件被移除时清除记录
+    void clear(const QString &videoPath);
+
+    // 查询记录；文件已变化的记录视为不存在
+    bool lookup(const QString &videoPath, qint64 fileSize,
+                const QDateTime &fileModified, PosterFailure *failure = nullptr) const;
+
+    // 是否仍处于退避期内，应跳过本次提取
+    bool shouldSkip(const QString &videoPath, qint64 fileSize, const QDateTime &fileModified) const;
+
+    int count() const;
+
+private:
+    QString m_filePath;
+    mutable QMutex m_mutex;
+    QHash<QString, PosterFailure> m_failures; // 视频路径 -> 失败记录
+    bool m_dirty = false;                     // 上次写盘后有修改
+};
+
+#endif // POSTERFAILURECACHE_H
@@ -0,0 +1,68 @@
+#ifndef POSTERJOBQUEUE_H
+#define POSTERJOBQUEUE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <functional>
+
+// 封面提取任务状态
+enum class PosterJobState {
+    Pending,    // 等待执行
+    Running     // 已分派给工作线程
+};
+
+struct PosterJob {
+    QString videoPath;   // 视频完整路径
+    QString outputPath;  // 最终封面路径 picture/*.jpg
+    PosterJobState state = PosterJobState::Pending;
+    qint64 sequence = 0; // 入队顺序，保证重启后按原顺序继续
+};
+
+// 持久化的封面提取队列，保存在配置目录下的 poster_queue.ini
+// 重启后未完成的任务（包括中断时正在执行的）会按原顺序恢复；可在工作线程中调用
+class PosterJobQueue
+{
+public:
+    PosterJobQueue() = default;
+
+    void setFilePath(const QString &filePath);
+    void load();
+    void save() const;
+
+    // 加入队列；已在队列中的视频不会重复加入
+    bool enqueue(const QString &videoPath, const QString &outputPath);
+
+    // 取出所有等待中的任务并标记为执行中
+    QVector<PosterJob> takePending();
+
+    // 任务结束（成功或失败）后移出队列
+    void finish(const QString &videoPath);
+
+    // 移除某个目录下的所有任务
+    void removeUnder(const QString &dirPath);
+
+    // 只保留位于给定目录下的任务（丢弃已从库中移除的目录）
+    void retainUnder(const QStringList &dirPaths);
+
+    // 移除满足条件的任务，返回移除的数量
+    int removeIf(const std::function<bool(const QString &videoPath)> &predicate);
+
+    bool contains(const QString &videoPath) const;
+    int size() const;
+
+    // 提取时使用的临时文件路径，完成后原子替换为最终文件
+    static QString tempPathFor(const QString &outputPath);
+
+private:
+    void saveLocked() const;
+
+    QString m_filePath;
+    mutable QMutex m_mutex;
+    QHash<QString, PosterJob> m_jobs; // 视频路径 -> 任务
+    qint64 m_nextSequence = 0;
+};
+
+#endif // POSTERJOBQUEUE_H
@@ -0,0 +1,64 @@
+#ifndef ROARINGBITMAP_H
+#define ROARINGBITMAP_H
+
+#include <QVector>
+
+// 压缩位图（Roaring 方式）：按 32 位整数的高 16 位分桶，
+// 每个桶（容器）元素不多于 ARRAY_MAX 个时保存为低 16 位的升序数组，否则保存为 65536 位的位图。
+// 稀疏集合只占 2 字节/元素，稠密集合每桶固定 8 KB；
+// 交、并、差按桶进行，数组与位图之间直接按位运算或逐个查找。
+// 用作视频 ID 集合（视频 ID 连续分配，同一桶中通常很稠密）
+class RoaringBitmap
+{
+public:
+    RoaringBitmap() = default;
+
+    void add(quint32 value);
+    void remove(quint32 value);
+    bool contains(quint32 value) const;
+
+    int cardinality() const;
+    bool isEmpty() const { return m_keys.isEmpty(); }
+    void clear();
+
+    // 升序的全部元素
+    QVector<quint32> toVector() const;
+
+    // 由任意顺序的元素批量构造：先逐桶置位，再把稀疏的桶转为数组，O(n)
+    static RoaringBitmap fromValues(const quint32 *values, int count);
+
+    static RoaringBitmap intersect(const RoaringBitmap &a, const RoaringBitmap &b);
+    static RoaringBitmap unite(const RoaringBitmap &a, const RoaringBitmap &b);
+    static RoaringBitmap subtract(const RoaringBitmap &a, const RoaringBitmap &b);
+    // 交集的元素数，不生成交集
+    static int intersectionCount(const RoaringBitmap &a, const RoaringBitmap &b);
+
+    // 占用的堆内存（字节），用于统计
+    qint64 bytes() const;
+
+private:
+    struct Container {
+        QVector<quint16> values; // 数组容器：升序的低 16 位
+        QVector<quint64> words;  // 位图容器：1024 个 64 位字（非空即为位图容器）
+        int cardinality = 0;
+
+        bool isBitmap() const { return !words.isEmpty(); }
+        bool contains(quint16 low) const;
+        void add(quint16 low);
+        void remove(quint16 low);
+        void toBitmap();
+        void toArrayIfSparse();
+    };
+
+    static Container intersect(const Container &a, const Container &b);
+    static Container unite(const Container &a, const Container &b);
+    static Container subtract(const Container &a, const Container &b);
+    static int intersectionCount(const Container &a, const Container &b);
+
+    int indexOf(quint16 key) const;
+
+    QVector<quint16> m_keys;           // 各容器对应的高 16 位，升序
+    QVector<Container> m_containers;
+};
+
+#endif // ROARINGBITMAP_H
@@ -0,0 +1,62 @@
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <QObject>
+#include <QMap>
+#include <QVariant>
+#include <QTimer>
+#include <QThreadPool>
+#include <QMutex>
+
+// 内存中的配置（javark.ini），界面修改只更新内存并安排一次延迟写盘。
+// 写盘在后台线程中进行：先写临时文件，再用 QSaveFile 原子替换配置文件，
+// 中途断电或拔出U盘时配置文件要么是旧的要么是新的。
+// 键使用 QSettings 的 "组/键" 形式，数组为 "组/size" 和 "组/序号/键"
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SettingsStore(const QString &filePath, QObject *parent = nullptr);
+    ~SettingsStore();
+
+    QString filePath() const { return m_filePath; }
+
+    // 从磁盘读取全部配置
+    void load();
+
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+    void setValue(const QString &key, const QVariant &value);
+    void remove(const QString &key);
+
+    // 删除整个组（例如重写数组前）
+    void removeGroup(const QString &group);
+
+    // 数组读写，格式与 QSettings::beginReadArray/beginWriteArray 相同
+    QStringList readArray(const QString &group, const QString &key) const;
+    void writeArray(const QString &group, const QString &key, const QStringList &values);
+
+    // 立即同步写盘并等待完成（关闭窗口时调用）
+    void sync();
+
+private:
+    // 把当前快照交给后台线程写盘
+    void scheduleFlush();
+    void flushAsync();
+
+    // 在调用线程中写出快照；写入的版本不比已写出的新时跳过
+    bool writeSnapshot(const QMap<QString, QVariant> &values, quint64 generation);
+
+    QString m_filePath;
+    QMap<QString, QVariant> m_values;
+    quint64 m_generation;        // 每次修改递增
+    quint64 m_flushedGeneration; // 已交给写盘的版本（主线程）
+
+    QTimer m_flushTimer;         // 合并连续修改
+    QThreadPool m_writer;        // 单线程，保证写盘顺序
+
+    QMutex m_writeMutex;         // 保护磁盘写入和 m_writtenGeneration
+    quint64 m_writtenGeneration; // 已写到磁盘的版本
+};
+
+#endif // SETTINGSSTORE_H
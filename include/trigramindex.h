@@ -0,0 +1,36 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+
+// 文件名的三字符组（trigram）倒排索引，用于子串搜索。
+// 每个文档用调用方分配的整数 id 表示，倒排表按 id 升序保存；
+// 查询时求各 trigram 倒排表的交集得到候选，再逐个验证子串。
+// 只在主线程中维护和查询，不加锁
+class TrigramIndex
+{
+public:
+    TrigramIndex() = default;
+
+    // 添加或更新文档（同一 id 重复添加时先移除旧内容）
+    void insert(quint32 id, const QString &text);
+    void remove(quint32 id);
+    void clear();
+
+    int size() const { return m_texts.size(); }
+
+    // 查询包含 query 的文档（不区分大小写），结果为升序 id。
+    // query 少于3个字符时无法使用索引，返回 false，由调用方线性过滤
+    bool search(const QString &query, QVector<quint32> *results) const;
+
+private:
+    static QVector<quint64> trigramsOf(const QString &foldedText);
+    static void intersect(QVector<quint32> &target, const QVector<quint32> &other);
+
+    QHash<quint64, QVector<quint32>> m_postings; // trigram -> 升序文档 id
+    QHash<quint32, QString> m_texts;             // 文档 id -> 折叠大小写后的文本，用于验证和移除
+};
+
+#endif // TRIGRAMINDEX_H
@@ -0,0 +1,147 @@
+#ifndef VIDEOCATALOG_H
+#define VIDEOCATALOG_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <QHash>
+#include <QMultiHash>
+#include <QReadWriteLock>
+#include <memory>
+#include <vector>
+#include <functional>
+#include "nforeader.h"
+
+// 紧凑的视频目录（结构数组），同时负责分配视频 ID。
+// 文件夹路径去重后只存一份，文件名存放在定长的 UTF-16 块中（按偏移和长度引用），
+// 文件大小和时间按列存放。NFO 元数据同样按列存放：标题与文件名共用文字块，
+// 片商、演员和类别去重后只存下标。条目下标即视频 ID：从 0 开始分配，
+// 同一路径、大小和修改时间都未变的文件在重新扫描后仍得到原来的 ID，
+// 封面缓存和视图中以 ID 为键的状态因此不会失效。
+// 不再被引用的条目由 reclaimUnused 回收后复用，废弃的文字和下标列表超过一半时整理。
+// 条目按块（CATALOG_CHUNK_SIZE 个一块）分配，增长时不搬动已有数据；
+// 扫描线程添加条目，界面线程读取，读写都经过读写锁
+class VideoCatalog
+{
+public:
+    static VideoCatalog* instance();
+
+    // 取得文件对应的视频 ID（未变化的已知文件复用原 ID），并增加其引用。可在任意线程调用
+    quint32 acquire(const QString &folderPath, QStringView fileName,
+                    qint64 fileSize, qint64 creationMs, qint64 modifiedMs);
+    // VideoItem 析构时释放引用；条目保留到 reclaimUnused，其间的扫描仍可沿用 ID
+    void release(quint32 id);
+    // 只保存 ID 的后台任务为仍被引用的条目再增加一个引用，完成后 release，期间条目不会被回收
+    void retain(quint32 id);
+    // 回收所有不再被引用的条目（之后 find 找不到，ID 留待 acquire 复用），返回回收的 ID。
+    // 在界面线程中没有扫描进行时调用，以便清理以 ID 为键的状态
+    QVector<quint32> reclaimUnused();
+    // 条目被复用的次数，与 ID 一起作为缓存键，复用后旧的缓存不会被误用
+    quint32 generation(quint32 id) const;
+    // 只查找已知且未变化的文件的 ID，不分配条目也不增加引用；找不到时返回 false。可在任意线程调用
+    bool find(const QString &folderPath, QStringView fileName,
+              qint64 fileSize, qint64 modifiedMs, quint32 *id) const;
+
+    QString folderPath(quint32 id) const;
+    QString fileName(quint32 id) const;
+    QString filePath(quint32 id) const;
+    qint64 fileSize(quint32 id) const;
+    qint64 creationMs(quint32 id) const;
+    qint64 modifiedMs(quint32 id) const;
+
+    // 搜索和排序键，与文件名一起存放在文字块中，每个条目只计算一次（沿用 ID 时直接复用）：
+    // 折叠大小写的“文件名 + 换行 + 番号”（番号在末尾，codeLength 为其长度）和自然顺序的文件名键
+    bool hasSearchKeys(quint32 id) const;
+    void setSearchKeys(quint32 id, QStringView searchText, int codeLength, QStringView nameSortKey);
+    QString searchText(quint32 id) const;
+    QString codeKey(quint32 id) const;   // 规范化番号（大写），没有时为空
+    QString nameSortKey(quint32 id) const;
+    // 比较两个条目的文件名键，不复制字符串
+    int compareNameSortKeys(quint32 a, quint32 b) const;
+    // 在一次读锁内依次访问多个条目的搜索文本（不复制），用于全库的子串和近似匹配。
+    // visitor 中不要再调用目录的其他方法
+    void visitSearchText(const QVector<quint32> &ids,
+                         const std::function<void(quint32 id, QStringView searchText)> &visitor) const;
+
+    // NFO 元数据。nfoModifiedMs 为读取时 NFO 的修改时间，从未读取过时为 0，
+    // 扫描时据此跳过未变化的 NFO（条目在重新扫描后保留，元数据随之保留）
+    void setMetadata(quint32 id, const VideoMetadata &metadata, qint64 nfoModifiedMs);
+    VideoMetadata metadata(quint32 id) const;
+    QString title(quint32 id) const;
+    qint64 nfoModifiedMs(quint32 id) const;
+
+    // 内容哈希（查找重复视频用）：抽样哈希和完整哈希，没有计算过时返回 false。
+    // 条目只对应大小和修改时间都未变的文件，哈希在重新扫描后仍然有效
+    bool sampleHash(quint32 id, quint64 *hash) const;
+    bool fullHash(quint32 id, quint64 *hash) const;
+    void setSampleHash(quint32 id, quint64 hash);
+    void setFullHash(quint32 id, quint64 hash);
+    // 封面的感知哈希（dHash），用于查找重新编码的相似视频。coverModifiedMs 为计算时封面文件的修改时间，
+    // 封面被替换后据此重新计算
+    bool coverHash(quint32 id, quint64 *hash, qint64 *coverModifiedMs = nullptr) const;
+    void setCoverHash(quint32 id, quint64 hash, qint64 coverModifiedMs);
+    void clearCoverHash(quint32 id);
+
+    // 内存占用统计（按已分配的块计算）
+    struct Stats {
+        int entries = 0;       // 已分配的条目（即最大 ID + 1）
+        int liveEntries = 0;   // 仍被 VideoItem 或后台任务引用的条目
+        int freeEntries = 0;   // 已回收、等待复用的条目
+        int folders = 0;       // 去重后的文件夹数
+        int terms = 0;         // 去重后的片商、演员和类别数
+        qint64 bytes = 0;      // 目录本身占用的字节数
+    };
+    Stats stats() const;
+
+private:
+    VideoCatalog();
+
+    // 去重的字符串表
+    struct StringTable {
+        QVector<QString> strings;
+        QHash<QString, quint32> index;
+
+        quint32 intern(const QString &text);
+        qint64 bytes() const;
+    };
+
+    struct Chunk;
+    Chunk& chunkOf(quint32 id) const;
+    QStringView textAt(quint32 offset, int length) const;
+    QStringView nameOf(quint32 id) const;
+    QStringView searchTextOf(quint32 id) const;
+    QStringView nameSortKeyOf(quint32 id) const;
+    quint32 storeName(QStringView name);
+    // 把仍在使用的文字和下标列表复制到新的存储中，丢弃废弃部分（调用方持有写锁）
+    void compactText();
+    void compactTermLists();
+    // 在 m_idsByPath 中查找路径、大小和修改时间都相同的条目（调用方持有锁）
+    bool findLocked(quint32 folder, QStringView name, qint64 fileSize, qint64 modifiedMs, quint32 *id) const;
+
+    mutable QReadWriteLock m_lock;
+
+    // 文件夹表：去重后的路径及其下标
+    StringTable m_folders;
+
+    // 片商、演员和类别共用的词表，以及各条目的演员和类别下标（先演员后类别，连续存放）
+    StringTable m_terms;
+    QVector<quint32> m_termLists;
+
+    // 文字块（文件名、标题、搜索和排序键），偏移为 块号 * NAME_BLOCK_SIZE + 块内位置，一段文字不跨块
+    std::vector<std::unique_ptr<char16_t[]>> m_nameBlocks;
+    int m_nameBlockUsed;
+    qint64 m_textChars;      // 已写入的字符数
+    qint64 m_deadTextChars;  // 其中已不再使用的字符数
+    int m_deadTerms;         // m_termLists 中已不再使用的下标数
+
+    // 条目块
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    quint32 m_count;
+    int m_liveEntries;
+    QVector<quint32> m_freeIds;  // 已回收、等待复用的条目
+
+    // 路径（文件夹下标和文件名的哈希）-> ID，用于重新扫描时沿用 ID
+    QMultiHash<size_t, quint32> m_idsByPath;
+};
+
+#endif // VIDEOCATALOG_H
@@ -0,0 +1,65 @@
+#ifndef VIDEODELEGATE_H
+#define VIDEODELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QPixmap>
+#include <QSet>
+#include <memory>
+#include "videoitem.h"
+
+// 绘制单个视频单元格：封面、悬停/选中边框、标题和失败标记。
+// 只有可见的单元格会被绘制，缩放后的封面缓存在 QPixmapCache 中。
+// 尚未解码的封面先画占位图，在 CoverDecode 通道中按缩略图尺寸解码，完成后发出 coverDecoded
+class VideoDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit VideoDelegate(QObject *parent = nullptr);
+    ~VideoDelegate();
+
+    void setThumbnailSize(int size);
+    int thumbnailSize() const { return m_thumbnailSize; }
+
+    void setUseFanartMode(bool useFanart);
+    bool useFanartMode() const { return m_useFanartMode; }
+
+    // 单元格尺寸（封面加上边框和标题）
+    QSize cellSize() const { return QSize(m_thumbnailSize + 10, m_thumbnailSize + 30); }
+
+    // 悬停预览：设置当前预览的视频及雪碧图中要显示的帧
+    void setScrubFrame(const VideoItem *video, const QPixmap &sheet, const QRect &source, int frame);
+    void clearScrubFrame();
+
+    // 视频封面更新后丢弃缓存的缩放图（静态版本用于尚未创建视图的标签页）
+    void invalidate(quint32 videoId);
+    static void invalidate(quint32 videoId, int thumbnailSize);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+signals:
+    // 封面已在后台解码完成，需要重绘该视频
+    void coverDecoded(quint32 videoId);
+
+private:
+    QPixmap scaledCover(const std::shared_ptr<VideoItem> &video) const;
+    // 在工作线程中解码封面；同一视频同一种图片只有一个请求
+    void requestCover(const std::shared_ptr<VideoItem> &video, bool fanart) const;
+    QPixmap placeholder() const;
+    static QString cacheKey(quint32 videoId, bool fanart, int thumbnailSize);
+
+    int m_thumbnailSize;
+    bool m_useFanartMode;
+
+    // 悬停预览状态
+    const VideoItem *m_scrubVideo;
+    QPixmap m_scrubSheet;
+    QRect m_scrubSource;
+    int m_scrubFrame;
+
+    // 正在解码的封面：视频 ID * 2 + 是否背景图
+    mutable QSet<quint64> m_decoding;
+};
+
+#endif // VIDEODELEGATE_H
@@ -0,0 +1,136 @@
+#ifndef VIDEOGRIDVIEW_H
+#define VIDEOGRIDVIEW_H
+
+#include <QAbstractItemView>
+#include <QCache>
+#include <QPersistentModelIndex>
+#include <QSet>
+#include <QTimer>
+#include <memory>
+#include "videoitem.h"
+
+class AbstractVideoModel;
+class VideoDelegate;
+
+// 单个标签页的视频网格视图。
+// 所有单元格尺寸相同，几何位置由行号和列数直接算出，
+// 布局、命中测试和绘制的开销只与可见单元格数有关；
+// 同时负责悬停预览、双击播放和多选（单选 / Shift 连续选择 / Ctrl 多选）
+class VideoGridView : public QAbstractItemView
+{
+    Q_OBJECT
+
+public:
+    explicit VideoGridView(AbstractVideoModel *model, QWidget *parent = nullptr);
+
+    AbstractVideoModel* videoModel() const { return m_model; }
+    VideoDelegate* videoDelegate() const { return m_delegate; }
+
+    // 显示设置
+    void setThumbnailSize(int size);
+    void setUseFanartMode(bool useFanart);
+    void setHoverScrubEnabled(bool enabled);
+
+    // 行条缓存模式（默认开启）：每一行单元格预先绘制到一张缓存图中，
+    // 滚动时只拼接几张行条；单元格内容或选中状态变化时只重绘该单元格，
+    // 悬停中的单元格始终实时绘制在行条之上
+    void setStripCacheEnabled(bool enabled);
+    bool stripCacheEnabled() const { return m_stripCacheEnabled; }
+
+    // 当前列数和每个网格（单元格加间距）的尺寸
+    int columnCount() const { return m_columns; }
+    QSize gridSize() const;
+
+    // 选中的视频：按视频 ID 记录，排序和过滤后仍然有效；
+    // 判断和计数为 O(1)，selectedVideos() 按当前显示顺序返回，供批量操作使用
+    bool isVideoSelected(quint32 videoId) const { return m_selectedIds.contains(videoId); }
+    int selectedCount() const { return m_selectedIds.size(); }
+    QVector<std::shared_ptr<VideoItem>> selectedVideos() const;
+
+    // 视频封面或状态更新后重绘对应单元格
+    void refreshVideo(quint32 videoId);
+
+    // 雪碧图生成完成后重新加载（仅当该视频正在预览时）
+    void reloadSpriteSheet(quint32 videoId);
+
+    // QAbstractItemView
+    QRect visualRect(const QModelIndex &index) const override;
+    void scrollTo(const QModelIndex &index, ScrollHint hint = EnsureVisible) override;
+    QModelIndex indexAt(const QPoint &point) const override;
+
+signals:
+    void spriteSheetRequested(quint32 videoId);
+    void selectedCountChanged(int count);
+
+protected:
+    QModelIndex moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers) override;
+    int horizontalOffset() const override;
+    int verticalOffset() const override;
+    bool isIndexHidden(const QModelIndex &index) const override;
+    void setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command) override;
+    QRegion visualRegionForSelection(const QItemSelection &selection) const override;
+    void updateGeometries() override;
+    void selectionChanged(const QItemSelection &selected, const QItemSelection &deselected) override;
+
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+
+private:
+    // 可见范围内的第一个和最后一个行号（模型行）
+    void visibleRange(int *first, int *last) const;
+    QRect cellRect(int row) const;
+    // 离某点最近的行（用于连续选择的端点），没有视频时返回 -1
+    int nearestRow(const QPoint &point) const;
+
+    // 选中集合与模型行同步
+    void updateSelectedIds(const QItemSelection &selection, bool selected);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onModelReset();
+
+    // 合并同一帧内的多次尺寸/内容变化，只重新计算一次列数和滚动范围
+    void scheduleLayout();
+    void doLayout();
+
+    void setHoverIndex(const QModelIndex &index);
+
+    // 行条缓存
+    QPixmap* stripPixmap(int line);
+    void paintCell(QPainter *painter, int row, const QRect &rect, bool hover) const;
+    void invalidateRows(int first, int last);
+    void clearStripCache();
+
+    void resetScrub();
+    void applyScrubFrame();
+    void startSpriteDecode();
+    void onSpriteSheetDecoded(const VideoItem *video, const QImage &sheet, const QSize &frameSize, int thumbnailSize);
+
+    AbstractVideoModel *m_model;
+    VideoDelegate *m_delegate;
+
+    // 布局
+    int m_columns;
+    QTimer m_layoutTimer;
+    QPersistentModelIndex m_hoverIndex;
+
+    // 选中的视频 ID，与 selectionModel() 同步，绘制时 O(1) 判断
+    QSet<quint32> m_selectedIds;
+
+    // 行号（第几行单元格）-> 已绘制的行条；m_dirtyRows 中的单元格在下次绘制前重绘到行条上
+    bool m_stripCacheEnabled;
+    QCache<int, QPixmap> m_strips;
+    QSet<int> m_dirtyRows;
+
+    // 悬停预览状态（同一时间只有一个单元格处于预览中）
+    bool m_hoverScrubEnabled;
+    std::shared_ptr<VideoItem> m_scrubVideo;
+    QPersistentModelIndex m_scrubIndex;
+    bool m_spriteRequested;  // 已请求生成雪碧图，等待完成通知
+    bool m_spriteLoading;    // 正在工作线程中解码雪碧图
+    QPixmap m_spriteSheet;   // 按缩略图尺寸解码的雪碧图，拖动时只做贴图
+    QSize m_spriteFrameSize; // 雪碧图中单帧的尺寸
+    int m_scrubFrame;        // 当前显示的帧，-1表示显示封面
+};
+
+#endif // VIDEOGRIDVIEW_H
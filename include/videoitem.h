@@ -2,33 +2,93 @@
 #define VIDEOITEM_H
 
 #include <QString>
+#include <QStringList>
 #include <QPixmap>
+#include <QImage>
+#include <QAtomicInt>
 #include <QFileInfo>
 #include <QPainter>
 #include <QDateTime>
+#include <memory>
+#include "nforeader.h"
 
+// 悬停预览雪碧图的帧数与每帧宽度（像素）
+const int SPRITE_FRAME_COUNT = 10;
+const int SPRITE_FRAME_WIDTH = 320;
+
+// 单个视频。路径、大小和时间保存在 VideoCatalog 中，这里只记录条目下标（即视频 ID）；
+// 图片在首次使用时才分配。QPixmap 只能在界面线程中创建和读取，界面线程也不解码图片：
+// 封面由 readCover() 在工作线程中按缩略图尺寸解码，生成的封面经 setExtractedPoster() 暂存，
+// 界面线程取图时再转换
 class VideoItem {
 public:
-    VideoItem(const QString &filePath, bool loadImagesNow = true);
-    ~VideoItem() = default;
-
-    // 获取视频信息
-    QString filePath() const { return m_filePath; }
-    QString fileName() const { return m_fileName; }
-    QString folderPath() const { return m_folderPath; }
-    qint64 fileSize() const { return m_fileSize; }
-    QDateTime creationTime() const { return m_creationTime; }
-    QDateTime modifiedTime() const { return m_modifiedTime; }
-
-    // 获取图片
+    explicit VideoItem(const QString &filePath);
+    // 由已知的文件信息创建（媒体库快照），不访问磁盘
+    VideoItem(const QString &folderPath, const QString &fileName,
+              qint64 fileSize, qint64 creationMs, qint64 modifiedMs);
+    ~VideoItem();
+    VideoItem(const VideoItem &) = delete;
+    VideoItem& operator=(const VideoItem &) = delete;
+
+    // 视频 ID：由 VideoCatalog 连续分配，文件未变化时重新扫描后保持不变，用于索引和界面查找
+    quint32 id() const { return m_id; }
+
+    // 获取视频信息（路径按需由文件夹表和文件名区拼接）
+    QString filePath() const;
+    QString fileName() const;
+    QString folderPath() const;
+    qint64 fileSize() const;
+    QDateTime creationTime() const;
+    QDateTime modifiedTime() const;
+
+    // NFO 元数据（扫描时读取并保存在 VideoCatalog 中，没有 NFO 时为空）
+    VideoMetadata metadata() const;
+    QString title() const;
+
+    // 搜索用：规范化番号（如 ABP123）和折叠大小写后的“文件名 + 番号”，
+    // 条目创建时计算一次，保存在 VideoCatalog 中
+    QString codeKey() const;
+    QString searchText() const;
+
+    // 排序用的预计算键：自然顺序的文件名键（ABP-2 排在 ABP-10 之前）和毫秒时间戳。
+    // 比较文件名键时用 VideoCatalog::compareNameSortKeys()，不必复制
+    QString nameSortKey() const;
+    qint64 creationSortKey() const;
+    qint64 modifiedSortKey() const;
+
+    // 已解码的海报和背景图（仅限界面线程），尚未解码时为空图：
+    // 绘制方先画占位图，用 readCover() 在工作线程中解码后交给 setCover()
     const QPixmap& posterImage() const;
     const QPixmap& fanartImage() const;
+    // 当前图片解码时的长边上限，0 表示尚未解码（仅限界面线程）
+    int coverSize(bool fanart) const;
+
+    // 按长边不超过 maxSize 解码海报（poster.jpg，否则为 picture 中提取的封面）或背景图
+    // （没有 poster.jpg 时为提取的封面，否则为 fanart.jpg）。没有或无法解码时返回空图。可在工作线程调用
+    static QImage readCover(const QString &folderPath, const QString &fileName, bool fanart, int maxSize);
+    // 设置 readCover() 的结果（仅限界面线程），空图使用默认图片；不替换解码尺寸更大的图片
+    void setCover(bool fanart, const QImage &image, int decodedSize);
 
     // 检查是否有封面图
     bool hasPoster() const;
+    // 同上，只按文件夹检查 poster.jpg 和 fanart.jpg 是否存在，不需要 VideoItem。可在工作线程调用
+    static bool hasPosterFile(const QString &folderPath);
 
-    // 检查并使用提取的封面图
-    bool checkExtractedPoster(const QString &pictureDir);
+    // 视频的封面图文件：同文件夹的 poster.jpg，否则为上级目录 picture 中提取的封面，都没有时为空。
+    // 只检查文件是否存在，可在工作线程调用
+    static QString coverFilePath(const QString &folderPath, const QString &fileName);
+
+    // 解码 pictureDir 中提取的封面图，找不到或无法解码时返回空图。可在工作线程调用
+    QImage readExtractedPoster(const QString &pictureDir) const;
+    // pictureDir 中是否有提取的封面图（只检查文件是否存在，不解码）。可在工作线程调用
+    static bool hasExtractedPoster(const QString &pictureDir, const QString &fileName);
+
+    // 交付提取的封面图（同时作为海报和背景图）。可在任意线程调用，只暂存 QImage，
+    // 界面线程下次取图时一次性转换并替换两张图
+    void setExtractedPoster(const QImage &image);
+
+    // 悬停预览雪碧图路径（位于缩略图缓存 picture/sprites 目录下）
+    QString spriteSheetPath() const;
 
     // 播放视频
     bool play() const;
@@ -37,28 +97,48 @@ public:
     void setNeedsPosterGeneration(bool needs);
     bool needsPosterGeneration() const;
 
+    // 封面提取失败信息（用于界面显示）
+    void setPosterFailure(const QString &reason, int attempts);
+    void clearPosterFailure();
+    bool hasPosterFailure() const { return m_posterFailureAttempts > 0; }
+    QString posterFailureReason() const { return m_posterFailureReason; }
+    int posterFailureAttempts() const { return m_posterFailureAttempts; }
+
+    // 本对象在目录之外占用的堆内存（字符串和已加载的图片对象，不含像素数据），用于统计
+    qint64 heapBytes() const;
+
 private:
-    // 从文件夹加载海报和背景图
-    void loadImages();
+    // pictureDir 中提取的封面图的候选路径，按查找顺序排列
+    static QStringList extractedPosterCandidates(const QString &pictureDir, const QString &fileName);
+
+    // 取得视频 ID；新条目同时计算排序键和搜索键
+    void initialize(const QString &folderPath, const QString &fileName,
+                    qint64 fileSize, qint64 creationMs, qint64 modifiedMs);
 
-    // 加载提取的封面图
-    bool loadExtractedPoster(const QString &posterPath);
+    // 界面线程中把暂存的封面图转换为 QPixmap
+    void publishPendingPoster() const;
 
     // 创建默认图片
     void createDefaultPoster();
     void createDefaultFanart();
 
-    QString m_filePath;    // 视频完整路径
-    QString m_fileName;    // 视频文件名
-    QString m_folderPath;  // 视频所在文件夹
-    qint64 m_fileSize;     // 文件大小
-    QDateTime m_creationTime; // 文件创建时间
-    QDateTime m_modifiedTime; // 文件修改时间
+    // 海报和背景图及其解码尺寸，首次使用时分配
+    struct Images {
+        QPixmap poster;
+        QPixmap fanart;
+        int posterSize = 0;
+        int fanartSize = 0;
+    };
+    Images& images();
+
+    quint32 m_id;          // 视频 ID（VideoCatalog 条目下标）
 
-    mutable QPixmap m_posterImage;
-    mutable QPixmap m_fanartImage;
-    mutable bool m_imagesLoaded;
+    std::unique_ptr<Images> m_images;
+    mutable QImage m_pendingPoster;        // 工作线程交付、尚未转换的封面图，由 s_pendingLock 保护
+    mutable QAtomicInt m_hasPendingPoster; // 界面线程取图时不加锁地检查
     bool m_needsPosterGeneration; // 新增：标记是否需要生成封面
+    QString m_posterFailureReason; // 最近一次封面提取失败原因
+    int m_posterFailureAttempts;   // 连续提取失败次数，0表示没有失败记录
 };
 
 #endif // VIDEOITEM_H
\ No newline at end of file
@@ -9,8 +9,53 @@
 #include <QFutureWatcher>
 #include <QProcess>
 #include <QHash>
+#include <QMutex>
 #include <memory>
 #include "videoitem.h"
+#include "posterfailurecache.h"
+#include "posterjobqueue.h"
+#include "trigramindex.h"
+#include "facetindex.h"
+#include "videosearch.h"
+
+class QTimer;
+class SettingsStore;
+
+// 库中全部视频的轻量视图：直接遍历按 ID 排列的视频表（跳过空位），不复制列表。
+// 只在库的视频表不变期间有效，不要跨越扫描保存
+class VideoRange
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator(const std::shared_ptr<VideoItem> *it, const std::shared_ptr<VideoItem> *end)
+            : m_it(it), m_end(end) { skipEmpty(); }
+        const std::shared_ptr<VideoItem>& operator*() const { return *m_it; }
+        const_iterator& operator++() { ++m_it; skipEmpty(); return *this; }
+        bool operator==(const const_iterator &other) const { return m_it == other.m_it; }
+        bool operator!=(const const_iterator &other) const { return m_it != other.m_it; }
+
+    private:
+        void skipEmpty() { while (m_it != m_end && !*m_it) ++m_it; }
+
+        const std::shared_ptr<VideoItem> *m_it;
+        const std::shared_ptr<VideoItem> *m_end;
+    };
+
+    VideoRange(const QVector<std::shared_ptr<VideoItem>> &table, int count)
+        : m_begin(table.constData()), m_end(table.constData() + table.size()), m_count(count) {}
+
+    const_iterator begin() const { return const_iterator(m_begin, m_end); }
+    const_iterator end() const { return const_iterator(m_end, m_end); }
+    int size() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+
+private:
+    const std::shared_ptr<VideoItem> *m_begin;
+    const std::shared_ptr<VideoItem> *m_end;
+    int m_count;
+};
 
 class VideoLibrary : public QObject
 {
@@ -27,31 +72,88 @@ public:
 
     // 获取视频列表
     const QHash<QString, QVector<std::shared_ptr<VideoItem>>>& videosByDirectory() const;
-    QVector<std::shared_ptr<VideoItem>> allVideosFlattened() const;
+    // 全库视频的视图（按 ID 顺序）和按 ID 查找（O(1)，不存在时返回空）
+    VideoRange videos() const;
+    std::shared_ptr<VideoItem> video(quint32 videoId) const;
+
+    // 搜索全库：番号精确匹配走番号索引，子串匹配走 trigram 索引，
+    // 再用 Bitap 做容错的近似匹配；过滤条件先由分面位图求出候选集合。结果带排名，未排序
+    void searchVideos(const VideoSearchQuery &query, QVector<SearchMatch> *matches);
 
-    // 扫描视频库
+    // 上一次搜索结果（没有搜索时为全库）中某个取值分面的前 limit 个取值及视频数
+    QVector<FacetCount> facetCounts(FacetField field, int limit) const;
+
+    // 在后台读取上次保存的媒体库快照，完成后逐目录发送 videosAdded 和 snapshotLoaded；
+    // 之后的扫描只把变化的部分通知界面
+    void loadSnapshot();
+
+    // 扫描视频库。与现有列表按视频 ID 对比，只通知新增和消失的视频
     void scanLibrary();
 
-    // 保存和加载库配置
-    void saveLibraryConfig(const QString &filePath);
-    void loadLibraryConfig(const QString &filePath);
+    // 保存和加载库配置（与主窗口共用同一个延迟写盘的配置存储）
+    void saveLibraryConfig(SettingsStore *settings);
+    void loadLibraryConfig(SettingsStore *settings);
+
+    // 悬停预览：异步生成视频的雪碧图，完成后发送 videoSpriteSheetReady
+    void requestSpriteSheet(quint32 videoId);
+
+    // 封面提取失败（负缓存）记录数
+    int posterFailureCount() const;
 
 signals:
     void scanStarted();
     void scanProgress(int current, int total);
     void scanFinished();
-    void videoAdded(const QString& directory, std::shared_ptr<VideoItem> video);
-    void videoPosterReady(std::shared_ptr<VideoItem> video);
+    // 一个目录扫描完成后整批发送新增视频的 ID（没有新增时也会发送，用于创建标签页），
+    // 接收方通过 video() 取得视频对象
+    void videosAdded(const QString& directory, const QVector<quint32>& videoIds);
+    // 重新扫描后已不存在（或已变化而换了 ID）的视频，在 videosAdded 之前发送
+    void videosRemoved(const QString& directory, const QVector<quint32>& videoIds);
+    // 快照已显示（videoCount 为快照中的视频数，没有快照时为 0）
+    void snapshotLoaded(int videoCount);
+    // 单个视频的状态变化只发送视频 ID，接收方按 ID 查找所在的标签页和单元格
+    void videoPosterReady(quint32 videoId);
+    void videoSpriteSheetReady(quint32 videoId);
+    void videoPosterFailed(quint32 videoId);
 
 private slots:
-    void processGeneratedPoster(std::shared_ptr<VideoItem> video);
+    // 交付工作线程解码好的封面并通知界面
+    void processGeneratedPoster(std::shared_ptr<VideoItem> video, const QImage &poster);
+
+    // 执行持久化队列中所有等待中的封面提取任务
+    void runPendingPosterJobs();
 
 private:
     // 多线程扫描单个目录
     void scanDirectory(const QString &path);
 
-    // 扫描指定目录下的视频文件
-    QVector<std::shared_ptr<VideoItem>> findVideosInDirectory(const QString &path);
+    // 库中已有、文件未变化的视频：只带 ID 和本次检查到的封面状态
+    struct KeptVideo {
+        quint32 id;
+        bool needsPosterGeneration;
+        QString failureReason;
+        int failureAttempts;
+    };
+
+    // 一个目录的扫描结果
+    struct ScanResult {
+        QVector<std::shared_ptr<VideoItem>> added;   // 新出现或有变化的文件
+        QVector<KeptVideo> kept;
+    };
+
+    // 扫描指定目录下的视频文件。knownIds 为该目录当前已有的视频 ID，
+    // 其中未变化的文件只查目录和检查封面文件是否存在，不创建 VideoItem，也不解码封面
+    ScanResult findVideosInDirectory(const QString &path, const QSet<quint32> &knownIds);
+
+    // 把一个目录的扫描结果合并到现有列表：未变化的视频沿用原对象，只索引和通知差异
+    void mergeScanResults(const QString &dir, const ScanResult &result);
+
+    // 写出媒体库快照；background 为 true 时在线程池中写盘
+    void saveSnapshot(bool background);
+
+    // 在扫描线程中并行读取修改时间有变化的 NFO，结果存入 VideoCatalog
+    void readChangedNfos(const QVector<quint32> &videoIds,
+                         const QHash<QString, qint64> &nfoModified);
 
     // 检查是否是视频文件
     bool isVideoFile(const QString &filePath) const;
@@ -63,7 +165,14 @@ private:
     void removeDirectoryCovers(const QString &dirPath);
 
     // 从视频中提取随机帧作为封面图
-    bool extractFrameFromVideo(const QString &videoPath, const QString &outputPath);
+    // 失败时通过 errorReason 返回原因
+    bool extractFrameFromVideo(const QString &videoPath, const QString &outputPath, QString *errorReason = nullptr);
+
+    // 一次顺序的关键帧解码生成横向拼接的雪碧图
+    bool extractSpriteSheet(const QString &videoPath, const QString &outputPath);
+
+    // 使用ffprobe获取视频时长（秒），失败时返回-1
+    double probeVideoDuration(const QString &videoPath);
 
     // 确保picture文件夹存在
     QString ensurePictureDirectory(const QString &rootDir);
@@ -71,13 +180,63 @@ private:
     // 异步生成封面
     void startPosterGeneration();
 
+    // 在工作线程中执行单个封面提取任务（输出先写临时文件再原子替换）
+    void runPosterJob(const PosterJob &job);
+
+    // 库中全部视频的 ID（按 ID 顺序）
+    QVector<quint32> allIds() const;
+
+    // 维护文件名搜索索引
+    void indexVideo(const std::shared_ptr<VideoItem> &video);
+    void unindexVideo(const std::shared_ptr<VideoItem> &video);
+
+    // 扫描完成后输出每个视频的平均内存占用（VideoItem 加上目录的已分配容量）
+    void logMemoryFootprint() const;
+    // 扫描全部完成后回收目录中不再被引用的条目，并清除以这些 ID 为键的状态
+    void reclaimUnusedVideos();
+
+    // 主线程中处理任务完成
+    void onPosterJobFinished(const QString &videoPath, bool ok, const PosterFailure &failure,
+                             const QImage &poster);
+
     QSet<QString> m_directories;  // 视频库目录集合
     QHash<QString, QVector<std::shared_ptr<VideoItem>>> m_videosByDirectory;
     QVector<std::shared_ptr<VideoItem>> m_videosNeedingPoster;
+    QSet<quint32> m_spriteRequests; // 已排队或生成失败的雪碧图（按视频 ID）
+    PosterFailureCache m_failureCache; // 封面提取失败的负缓存（带指数退避）
+    PosterJobQueue m_posterQueue;      // 持久化的封面提取队列，重启后继续
+    QHash<QString, quint32> m_posterJobVideos; // 队列任务（视频路径）对应的视频 ID
+    QTimer *m_queueSaveTimer;          // 合并队列和失败记录的写盘
+
+    // 文件名搜索索引，扫描时增量维护
+    TrigramIndex m_searchIndex;
+    // 视频表：下标为视频 ID（VideoCatalog 连续分配），已移除的位置为空；
+    // 同时是搜索索引的文档表（索引文档 id 即视频 ID）
+    QVector<std::shared_ptr<VideoItem>> m_videoById;
+    int m_videoCount;
+    QHash<QString, QVector<quint32>> m_codeIndex;  // 规范化番号 -> 索引文档 id
+    FacetIndex m_facetIndex;                       // 演员、类别、片商、日期、大小和评分的过滤索引
+
+    // 上一次搜索的条件和全部结果，搜索词扩展时近似匹配只在其中细化
+    VideoSearchQuery m_lastQuery;
+    QVector<quint32> m_lastSearchIds;
+    // 上一次搜索结果的位图，用于分面计数；没有搜索时为空，计数按全库
+    RoaringBitmap m_lastResultSet;
+    bool m_hasLastResult = false;
+
+    // 媒体库快照（与配置文件放在同一目录）
+    QString m_snapshotPath;
+    bool m_scanStarted = false;   // 本次运行已开始扫描，之后读完的快照不再使用
+    bool m_scanCompleted = false; // 本次运行完成过扫描，退出时才覆盖快照
+
+    // 扫描线程中重新读取了 NFO 的视频，合并时据此更新分面索引
+    QMutex m_changedMetadataLock;
+    QSet<quint32> m_changedMetadata;
 
     // 多线程支持
     QFutureWatcher<QVector<std::shared_ptr<VideoItem>>> *m_watcher;
     int m_pendingScanCount;
+    int m_runningScanTasks;  // 尚未合并结果的目录扫描（可能来自之前的 scanLibrary）
 };
 
 #endif // VIDEOLIBRARY_H
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef VIDEOLISTMODEL_H
+#define VIDEOLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QHash>
+#include <memory>
+#include "videoitem.h"
+#include "videosearch.h"
+
+// 定义排序方式枚举
+enum class SortOrder {
+    CreationTimeAsc,    // 创建时间升序
+    CreationTimeDesc,   // 创建时间降序
+    ModifiedTimeAsc,    // 修改时间升序
+    ModifiedTimeDesc,   // 修改时间降序
+    NameAsc,            // 文件名升序
+    NameDesc            // 文件名降序
+};
+
+// 视频网格视图使用的模型接口：按行取视频、按视频 ID 查行
+class AbstractVideoModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    using QAbstractListModel::QAbstractListModel;
+
+    virtual std::shared_ptr<VideoItem> videoAt(int row) const = 0;
+    // 视频 ID -> 可见行，不可见时返回 -1
+    virtual int rowOf(quint32 videoId) const = 0;
+
+    // 视频的封面或状态变化后通知视图重绘该行
+    void videoChanged(quint32 videoId);
+};
+
+// 单个媒体库目录（一个标签页）的视频列表模型。
+// 模型始终持有该目录的全部视频（按加入顺序保存，另维护一个始终按当前
+// 排序方式有序的排列，新视频按序插入），过滤只改变可见行：
+// 搜索条件变化时计算新旧可见集合的差异，只插入/移除变化的行，
+// 不会重建整个列表。搜索时可见行先按匹配排名、再按排序方式排列
+class VideoListModel : public AbstractVideoModel
+{
+    Q_OBJECT
+
+public:
+    explicit VideoListModel(const QString &directory, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    QString directory() const { return m_directory; }
+    std::shared_ptr<VideoItem> videoAt(int row) const override;
+    // 视频 ID -> 可见行，不可见时返回 -1；均摊 O(1)
+    int rowOf(quint32 videoId) const override;
+    int rowOf(const std::shared_ptr<VideoItem> &video) const;
+
+    // 供合并视图逐行比较：可见行的视频（不增加引用计数）和匹配排名
+    const VideoItem* itemAt(int row) const { return m_videos.at(m_rows.at(row).source).get(); }
+    int rankAt(int row) const { return m_rows.at(row).rank; }
+
+    // 按排序方式比较两个视频的排序键（已考虑升降序），<0 表示 a 排在前面，键相同时返回 0
+    static int compareVideos(const VideoItem &a, const VideoItem &b, SortOrder order);
+
+    // 未过滤时的视频总数（rowCount() 为过滤后的可见行数）
+    int totalCount() const { return m_videos.size(); }
+
+    // 修改列表内容。新视频按当前排序方式直接插入到最终位置
+    void appendVideo(std::shared_ptr<VideoItem> video);
+    void insertVideos(const QVector<std::shared_ptr<VideoItem>> &videos);
+    // 移除视频（重新扫描后已不存在的），只通知被移除的可见行
+    void removeVideos(const QVector<quint32> &videoIds);
+    void setVideos(const QVector<std::shared_ptr<VideoItem>> &videos);
+    void clear();
+    void sortBy(SortOrder order);
+    SortOrder sortOrder() const { return m_sortOrder; }
+
+    // 应用搜索结果。matches 为全库的匹配结果（VideoLibrary::searchVideos），
+    // 只取属于本模型的视频；查询为空时显示全部
+    void setSearch(const VideoSearchQuery &query, const QVector<SearchMatch> &matches);
+
+private:
+    // 可见行：先按排名，再按当前排序方式排列（见 rowLess）
+    struct VisibleRow {
+        int rank;
+        int source; // m_videos 下标
+        bool operator==(const VisibleRow &other) const {
+            return rank == other.rank && source == other.source;
+        }
+    };
+
+    // 按当前排序方式比较两个视频（m_videos 下标），键相同时按下标保证顺序确定
+    bool sourceLess(int a, int b) const;
+    bool rowLess(const VisibleRow &a, const VisibleRow &b) const;
+
+    // 排序键的种类，升序和降序共用同一个缓存的排列
+    enum SortKeyKind {
+        SortKeyName = 0,
+        SortKeyCreation,
+        SortKeyModified,
+        SortKeyKindCount
+    };
+    static SortKeyKind keyKindOf(SortOrder order);
+    static bool isDescending(SortOrder order);
+
+    // 按预计算的排序键计算升序排列（m_videos 下标），大列表并行排序
+    QVector<int> ascendingPermutation(SortKeyKind kind) const;
+    void invalidateSortCache();
+
+    // 按新的可见行（已排序）增量更新 m_rows，只通知变化的区间
+    void applyVisibleRows(const QVector<VisibleRow> &rows);
+    QVector<VisibleRow> visibleRowsFromRanks() const;
+
+    QString m_directory;
+    SortOrder m_sortOrder;
+    QVector<std::shared_ptr<VideoItem>> m_videos; // 全部视频
+    QVector<int> m_ranks;                         // 与 m_videos 对应的匹配排名，-1 表示不匹配
+    QVector<int> m_order;                         // 按当前排序方式排列的 m_videos 下标
+    QVector<VisibleRow> m_rows;                   // 可见行，已排序
+    QHash<quint32, int> m_sourceRowOf;            // 视频 ID -> m_videos 下标
+    mutable QVector<int> m_visibleRowOf;          // m_videos 下标 -> 可见行，按需重建
+    mutable bool m_visibleRowOfDirty;
+    VideoSearchQuery m_query;                     // 当前搜索条件，用于扫描中新增的视频
+    QVector<int> m_sortCache[SortKeyKindCount];   // 各排序键的升序排列，视频集合变化时失效
+};
+
+#endif // VIDEOLISTMODEL_H
@@ -0,0 +1,106 @@
+#ifndef VIDEOSEARCH_H
+#define VIDEOSEARCH_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <limits>
+
+class VideoItem;
+
+// 搜索结果排名：数值越小越靠前
+enum SearchRank {
+    SearchRankCode = 0,      // 番号完全一致（忽略大小写、分隔符和前导零）
+    SearchRankSubstring = 1, // 文件名或番号包含搜索词
+    SearchRankFuzzy = 2      // 近似匹配，实际排名为 SearchRankFuzzy + 错误数 - 1
+};
+
+// 一条搜索结果
+struct SearchMatch {
+    const VideoItem *video = nullptr;
+    int rank = SearchRankSubstring;
+};
+
+// 可过滤的分面：前三个按取值建位图，其余按有序列做范围查找
+enum class FacetField {
+    Actor,
+    Genre,
+    Studio,
+    Date,    // 发行日期（儒略日），year 条件也转换为日期范围
+    Size,    // 文件大小（字节）
+    Rating   // 评分 * 10
+};
+
+const int VALUE_FACET_COUNT = 3; // Actor、Genre、Studio
+const int RANGE_FACET_COUNT = 3; // Date、Size、Rating
+
+// 一个过滤条件。取值分面：values 中任一值匹配即可（“或”）；范围分面：min <= 值 <= max。
+// 多个条件之间为“与”，negated 的条件取反
+struct FacetFilter {
+    FacetField field = FacetField::Actor;
+    bool negated = false;
+    QStringList values; // 折叠大小写后的取值
+    // 加括号避免与 Windows.h 的 min/max 宏冲突
+    qint64 min = (std::numeric_limits<qint64>::min)();
+    qint64 max = (std::numeric_limits<qint64>::max)();
+
+    bool isRange() const { return int(field) >= VALUE_FACET_COUNT; }
+    bool operator==(const FacetFilter &other) const {
+        return field == other.field && negated == other.negated && values == other.values
+            && min == other.min && max == other.max;
+    }
+};
+
+// 一次搜索的查询条件：预先计算规范化番号和 Bitap 字符掩码，
+// 之后对每个视频的匹配只做位运算。
+// 搜索框支持简单的过滤语法，其余文字照常按文件名和番号搜索：
+//   actor:名字  genre:类别  studio:片商    取值分面，逗号分隔多个值表示“或”，值可加双引号
+//   year>=2020  date<2021-06-01  size>2G  rating>=8    范围分面，比较符为 : = > >= < <=
+//   条件前加 - 表示排除，例如 -genre:VR
+class VideoSearchQuery
+{
+public:
+    VideoSearchQuery() = default;
+    explicit VideoSearchQuery(const QString &text);
+
+    bool isEmpty() const { return m_text.isEmpty() && m_filters.isEmpty(); }
+    const QVector<FacetFilter>& filters() const { return m_filters; }
+    QString text() const { return m_text; }  // 折叠大小写后的搜索词
+    QString code() const { return m_code; }  // 规范化番号，搜索词不像番号时为空
+    int maxErrors() const { return m_maxErrors; }
+
+    // 返回视频的排名，不匹配（包括不满足过滤条件）返回 -1
+    int rank(const VideoItem &video) const;
+
+    // 逐个检查视频是否满足全部过滤条件（读取元数据，只用于少量新加入的视频；
+    // 全库过滤由 FacetIndex 的位图完成）
+    bool matchesFilters(const VideoItem &video) const;
+
+    // 在视频的搜索文本中近似查找搜索词，返回最少错误数（1..maxErrors），否则返回 -1
+    int fuzzyDistance(QStringView searchText) const;
+
+    // 本次查询的结果是否一定是 previous 结果的子集（可只在上次结果中细化）
+    bool refines(const VideoSearchQuery &previous) const;
+
+    // 从文件名或搜索词中提取规范化番号：字母前缀大写 + 去掉前导零的数字，
+    // 例如 ABP-123、abp00123、ABP123 都得到 ABP123；没有番号时返回空字符串
+    static QString normalizeCode(const QString &text);
+
+private:
+    quint64 maskFor(QChar c) const;
+
+    // 解析一个 key:value 形式的过滤条件，不是过滤条件时返回 false
+    static bool parseFilter(const QString &token, FacetFilter *filter);
+
+    QVector<FacetFilter> m_filters;
+    QString m_text;
+    QString m_code;
+    int m_maxErrors = 0;
+
+    // Bitap 字符掩码：第 i 位表示搜索词第 i 个字符等于该字符
+    quint64 m_asciiMasks[128] = {};
+    QHash<ushort, quint64> m_otherMasks;
+};
+
+#endif // VIDEOSEARCH_H
@@ -0,0 +1,26 @@
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <QtGlobal>
+
+// XXH64 的流式实现（与官方 xxHash 的 XXH64 结果一致）。
+// 结果只取决于输入和种子，与 CPU 和 Qt 版本无关，可以随媒体库快照在不同电脑间沿用
+class XxHash64
+{
+public:
+    explicit XxHash64(quint64 seed = 0);
+
+    void update(const void *data, qsizetype length);
+    quint64 digest() const;
+
+    // 一次性计算
+    static quint64 hash(const void *data, qsizetype length, quint64 seed = 0);
+
+private:
+    quint64 m_acc[4];
+    quint64 m_totalLength;
+    unsigned char m_buffer[32];  // 不足一组（32 字节）的输入
+    int m_bufferSize;
+};
+
+#endif // XXHASH64_H
@@ -0,0 +1,313 @@
+#include "concurrencycontroller.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QThread>
+#include <QStorageInfo>
+#include <QFileInfo>
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+
+// 平均耗时超过基线的倍数时视为设备拥塞
+static const double LATENCY_TOLERANCE = 2.0;
+// 增加并发后吞吐量下降超过该比例时回退
+static const double THROUGHPUT_DROP = 0.9;
+// 每个统计窗口至少包含的任务数
+static const int MIN_WINDOW = 4;
+
+// 线程池中的一个任务；有所有者时可以在开始前用 QThreadPool::tryTake 取回
+class ConcurrencyController::Task : public QRunnable
+{
+public:
+    Task(ConcurrencyController *controller, Lane *lane, std::function<void()> job, const QObject *owner)
+        : lane(lane), owner(owner), m_controller(controller), m_job(std::move(job))
+    {
+    }
+
+    void run() override
+    {
+        m_controller->taskStarted(this);
+        QElapsedTimer timer;
+        timer.start();
+        m_job();
+        // 捕获的对象在通知所有者之前释放，waitFor() 返回后任务不再持有任何东西
+        m_job = nullptr;
+        m_controller->recordCompletion(lane, timer.elapsed());
+        m_controller->taskFinished(this);
+    }
+
+    Lane *const lane;
+    const QObject *const owner;
+
+private:
+    ConcurrencyController *m_controller;
+    std::function<void()> m_job;
+};
+
+ConcurrencyController* ConcurrencyController::instance()
+{
+    static ConcurrencyController *controller = new ConcurrencyController(QCoreApplication::instance());
+    return controller;
+}
+
+ConcurrencyController::ConcurrencyController(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ConcurrencyController::~ConcurrencyController()
+{
+    // 丢弃尚未开始的任务并等待执行中的任务结束，之后才能释放通道
+    for (Lane *lane : qAsConst(m_lanes)) {
+        lane->pool->clear();
+        lane->pool->waitForDone();
+    }
+    qDeleteAll(m_lanes);
+    m_lanes.clear();
+}
+
+QString ConcurrencyController::kindName(WorkloadKind kind)
+{
+    switch (kind) {
+        case WorkloadKind::PosterExtraction:
+            return tr("提取");
+        case WorkloadKind::CoverDecode:
+            return tr("解码");
+        case WorkloadKind::ContentHash:
+            return tr("校验");
+    }
+    return QString();
+}
+
+QString ConcurrencyController::deviceFor(const QString &path)
+{
+    // 调用方已持有 m_mutex
+    QString folder = QFileInfo(path).path();
+    auto it = m_deviceCache.constFind(folder);
+    if (it != m_deviceCache.constEnd()) {
+        return it.value();
+    }
+
+    QStorageInfo storage(folder);
+    QString device = storage.isValid() ? storage.rootPath() : QStringLiteral("?");
+    m_deviceCache.insert(folder, device);
+    return device;
+}
+
+ConcurrencyController::Lane* ConcurrencyController::laneFor(const QString &path, WorkloadKind kind)
+{
+    // 调用方已持有 m_mutex
+    QString device = deviceFor(path);
+    QString key = device + "|" + QString::number(static_cast<int>(kind));
+    Lane *lane = m_lanes.value(key);
+    if (lane) {
+        return lane;
+    }
+
+    lane = new Lane;
+    lane->device = device;
+    lane->kind = kind;
+    lane->pool = new QThreadPool(this);
+    if (kind == WorkloadKind::PosterExtraction) {
+        // FFmpeg 是独立进程，受限于存储而不是CPU核数
+        lane->limit = 2;
+        lane->maxLimit = 16;
+    } else if (kind == WorkloadKind::ContentHash) {
+        // 顺序读取大文件，机械硬盘上并发读只会增加寻道
+        lane->limit = 1;
+        lane->maxLimit = 4;
+    } else {
+        lane->limit = std::max(2, QThread::idealThreadCount() / 2);
+        lane->maxLimit = std::max(2, QThread::idealThreadCount());
+    }
+    lane->pool->setMaxThreadCount(lane->limit);
+    lane->windowTimer.start();
+    m_lanes.insert(key, lane);
+
+    qInfo() << "并发控制: 新建通道" << device << kindName(kind) << "初始并发" << lane->limit;
+    return lane;
+}
+
+void ConcurrencyController::submit(const QString &path, WorkloadKind kind, std::function<void()> job)
+{
+    Lane *lane = nullptr;
+    bool created = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        int laneCount = m_lanes.size();
+        lane = laneFor(path, kind);
+        created = m_lanes.size() != laneCount;
+        lane->pending++;
+        if (lane->pending > lane->limit) {
+            lane->backlogged = true;
+        }
+    }
+
+    if (created) {
+        emit levelChanged(lane->device, lane->kind, lane->limit);
+    }
+
+    // 登记和入池在同一把锁内完成，cancel() 看到的任务一定已在线程池中
+    Task *task = new Task(this, lane, std::move(job), owner);
+    QMutexLocker locker(&m_mutex);
+    if (owner) {
+        m_queuedByOwner[owner].insert(task);
+        m_activeByOwner[owner]++;
+    }
+    lane->pool->start(task);
+}
+
+void ConcurrencyController::taskStarted(Task *task)
+{
+    if (!task->owner) {
+        return;
+    }
+    // 开始执行后不能再取回；任务对象在 run() 返回后才由线程池删除
+    QMutexLocker locker(&m_mutex);
+    auto it = m_queuedByOwner.find(task->owner);
+    if (it != m_queuedByOwner.end()) {
+        it->remove(task);
+        if (it->isEmpty()) {
+            m_queuedByOwner.erase(it);
+        }
+    }
+}
+
+void ConcurrencyController::taskFinished(Task *task)
+{
+    if (!task->owner) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    if (--m_activeByOwner[task->owner] <= 0) {
+        m_activeByOwner.remove(task->owner);
+        m_ownerIdle.wakeAll();
+    }
+}
+
+void ConcurrencyController::cancel(const QObject *owner)
+{
+    QMutexLocker locker(&m_mutex);
+    const QSet<Task*> queued = m_queuedByOwner.take(owner);
+    int removed = 0;
+    for (Task *task : queued) {
+        // 已被线程取走但还没登记为开始的任务取不回，由 taskStarted/taskFinished 正常收尾
+        if (!task->lane->pool->tryTake(task)) {
+            m_queuedByOwner[owner].insert(task);
+            continue;
+        }
+        task->lane->pending--;
+        delete task;
+        removed++;
+    }
+    if (removed > 0 && (m_activeByOwner[owner] -= removed) <= 0) {
+        m_activeByOwner.remove(owner);
+        m_ownerIdle.wakeAll();
+    }
+}
+
+void ConcurrencyController::waitFor(const QObject *owner)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_activeByOwner.value(owner) > 0) {
+        m_ownerIdle.wait(&m_mutex);
+    }
+}
+
+void ConcurrencyController::recordCompletion(Lane *lane, qint64 elapsedMs)
+{
+    int newLimit = 0;
+    QString device;
+    WorkloadKind kind;
+    {
+        QMutexLocker locker(&m_mutex);
+        lane->pending--;
+        lane->windowCount++;
+        lane->windowLatencySum += elapsedMs;
+
+        if (lane->windowCount < std::max(MIN_WINDOW, lane->limit * 2)) {
+            return;
+        }
+
+        double avgLatency = lane->windowLatencySum / lane->windowCount;
+        double throughput = lane->windowCount * 1000.0 / std::max<qint64>(1, lane->windowTimer.elapsed());
+        bool backlogged = lane->backlogged || lane->pending >= lane->limit;
+
+        // 基线取观测到的最佳耗时，并缓慢漂移以适应不同大小的文件
+        if (lane->bestLatency <= 0 || avgLatency < lane->bestLatency) {
+            lane->bestLatency = avgLatency;
+        } else {
+            lane->bestLatency = lane->bestLatency * 0.95 + avgLatency * 0.05;
+        }
+
+        bool congested = avgLatency > lane->bestLatency * LATENCY_TOLERANCE
+                         || (lane->lastWasIncrease && throughput < lane->lastThroughput * THROUGHPUT_DROP);
+
+        int limit = lane->limit;
+        if (congested && limit > lane->minLimit) {
+            // 乘性减
+            limit = std::max(lane->minLimit, limit / 2);
+        } else if (!congested && backlogged && limit < lane->maxLimit) {
+            // 加性增：只有存在积压时增加并发才有意义
+            limit = limit + 1;
+        }
+
+        lane->lastWasIncrease = limit > lane->limit;
+        lane->lastLatency = avgLatency;
+        lane->lastThroughput = throughput;
+
+        // 开始新的统计窗口
+        lane->windowCount = 0;
+        lane->windowLatencySum = 0;
+        lane->backlogged = false;
+        lane->windowTimer.restart();
+
+        if (limit == lane->limit) {
+            return;
+        }
+
+        qInfo() << "并发控制:" << lane->device << kindName(lane->kind)
+                << "并发" << lane->limit << "->" << limit
+                << "平均耗时" << qRound(avgLatency) << "ms"
+                << "基线" << qRound(lane->bestLatency) << "ms"
+                << "吞吐" << QString::number(throughput, 'f', 2) << "个/秒";
+
+        lane->limit = limit;
+        lane->pool->setMaxThreadCount(limit);
+        newLimit = limit;
+        device = lane->device;
+        kind = lane->kind;
+    }
+
+    emit levelChanged(device, kind, newLimit);
+}
+
+QString ConcurrencyController::statusText() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList parts;
+    for (const Lane *lane : m_lanes) {
+        parts << QString("%1 %2×%3").arg(lane->device, kindName(lane->kind)).arg(lane->limit);
+    }
+    parts.sort();
+    return parts.isEmpty() ? QString() : tr("并发: %1").arg(parts.join("  "));
+}
+
+QString ConcurrencyController::detailText() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList lines;
+    for (const Lane *lane : m_lanes) {
+        lines << tr("%1 %2: %3 个并发 (上限 %4)，平均耗时 %5 ms，吞吐 %6 个/秒，排队 %7")
+                     .arg(lane->device, kindName(lane->kind))
+                     .arg(lane->limit)
+                     .arg(lane->maxLimit)
+                     .arg(qRound(lane->lastLatency))
+                     .arg(lane->lastThroughput, 0, 'f', 2)
+                     .arg(std::max(0, lane->pending - lane->limit));
+    }
+    lines.sort();
+    return lines.join("\n");
+}
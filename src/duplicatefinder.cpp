@@ -0,0 +1,531 @@
+#include "duplicatefinder.h"
+#include "concurrencycontroller.h"
+#include "videocatalog.h"
+#include "videoitem.h"
+#include "xxhash64.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QtEndian>
+#include <QPointer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QtAlgorithms>
+#include <algorithm>
+
+// 抽样：头、尾和中间三块，每块 64 KB
+static const qint64 SAMPLE_BLOCK_SIZE = 64 * 1024;
+static const int SAMPLE_BLOCK_COUNT = 5;
+// 完整哈希每次读取的大小
+static const qint64 FULL_READ_SIZE = 1024 * 1024;
+// 固定种子。内容哈希用 XXH64，结果与机器无关，随媒体库快照保存后在其他电脑上仍然有效
+static const quint64 HASH_SEED = 0x4a6176417226b51fULL;
+// 读取封面计算感知哈希时的解码尺寸（JPEG 可按比例直接解码为小图）
+static const QSize COVER_DECODE_SIZE(72, 64);
+// 多索引哈希的分段：4 段，每段 16 位
+static const int COVER_HASH_SEGMENTS = 4;
+static const int COVER_SEGMENT_BITS = 16;
+
+// 为一次查找中的视频增加目录引用，最后一个持有者（查找本身或尚在执行的任务）释放时归还，
+// 期间视频被移除也不会回收条目、把 ID 分给其他文件
+static std::shared_ptr<const QVector<quint32>> retainEntries(const QVector<quint32> &ids)
+{
+    VideoCatalog *catalog = VideoCatalog::instance();
+    for (quint32 id : ids) {
+        catalog->retain(id);
+    }
+    return std::shared_ptr<const QVector<quint32>>(new QVector<quint32>(ids), [](const QVector<quint32> *ids) {
+        VideoCatalog *catalog = VideoCatalog::instance();
+        for (quint32 id : *ids) {
+            catalog->release(id);
+        }
+        delete ids;
+    });
+}
+
+DuplicateFinder::DuplicateFinder(QObject *parent)
+    : QObject(parent),
+      m_generation(std::make_shared<QAtomicInteger<quint64>>(0))
+{
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    // 尚未开始的任务看到代数变化后直接返回
+    cancel();
+}
+
+qint64 DuplicateFinder::sampleCoverage()
+{
+    return SAMPLE_BLOCK_SIZE * SAMPLE_BLOCK_COUNT;
+}
+
+bool DuplicateFinder::fullHash(const QString &path, quint64 *hash, QString *errorReason)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorReason) *errorReason = file.errorString();
+        return false;
+    }
+
+    QByteArray buffer(FULL_READ_SIZE, Qt::Uninitialized);
+    XxHash64 hasher(HASH_SEED);
+    for (;;) {
+        const qint64 n = file.read(buffer.data(), buffer.size());
+        if (n < 0) {
+            if (errorReason) *errorReason = file.errorString();
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        hasher.update(buffer.constData(), n);
+    }
+    *hash = hasher.digest();
+    return true;
+}
+
+bool DuplicateFinder::sampledHash(const QString &path, qint64 fileSize, quint64 *hash, QString *errorReason)
+{
+    if (fileSize <= sampleCoverage()) {
+        return fullHash(path, hash, errorReason);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorReason) *errorReason = file.errorString();
+        return false;
+    }
+
+    // 各块均匀分布：第一块在文件头，最后一块在文件尾
+    QByteArray buffer(SAMPLE_BLOCK_SIZE, Qt::Uninitialized);
+    XxHash64 hasher(HASH_SEED);
+    const quint64 sizeBytes = qToLittleEndian(quint64(fileSize));
+    hasher.update(&sizeBytes, sizeof(sizeBytes));
+    for (int i = 0; i < SAMPLE_BLOCK_COUNT; ++i) {
+        const qint64 offset = (fileSize - SAMPLE_BLOCK_SIZE) * i / (SAMPLE_BLOCK_COUNT - 1);
+        if (!file.seek(offset) || file.read(buffer.data(), SAMPLE_BLOCK_SIZE) != SAMPLE_BLOCK_SIZE) {
+            if (errorReason) *errorReason = file.errorString();
+            return false;
+        }
+        hasher.update(buffer.constData(), SAMPLE_BLOCK_SIZE);
+    }
+    *hash = hasher.digest();
+    return true;
+}
+
+quint64 DuplicateFinder::coverHash(const QImage &image)
+{
+    // 平滑缩放相当于按区域取平均，对重新编码、缩放和轻微调色不敏感
+    const QImage small = image.scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                              .convertToFormat(QImage::Format_Grayscale8);
+    quint64 hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        const uchar *row = small.constScanLine(y);
+        for (int x = 0; x < 8; ++x) {
+            hash = (hash << 1) | (row[x] > row[x + 1] ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
+bool DuplicateFinder::readCoverHash(const QString &coverPath, quint64 *hash)
+{
+    if (coverPath.isEmpty()) {
+        return false;
+    }
+    QImageReader reader(coverPath);
+    reader.setScaledSize(COVER_DECODE_SIZE);
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        return false;
+    }
+    *hash = coverHash(image);
+    return true;
+}
+
+// 哈希的第 segment 段
+static inline quint32 coverSegment(quint64 hash, int segment)
+{
+    return quint32(hash >> (segment * COVER_SEGMENT_BITS)) & 0xFFFF;
+}
+
+QVector<QPair<int, int>> DuplicateFinder::similarPairs(const QVector<quint64> &hashes, int maxDistance)
+{
+    QVector<QPair<int, int>> pairs;
+    const int count = hashes.size();
+    maxDistance = qBound(0, maxDistance, MAX_COVER_DISTANCE);
+    // 距离为 d 时至少有一段相差不超过 d / 4 位（鸽巢原理）
+    const int segmentErrors = maxDistance / COVER_HASH_SEGMENTS;
+    const int buckets = 1 << COVER_SEGMENT_BITS;
+
+    // 每段一张表：offsets[值] .. offsets[值 + 1] 为该段取这个值的下标（计数排序，连续存放）
+    QVector<int> offsets[COVER_HASH_SEGMENTS];
+    QVector<int> members[COVER_HASH_SEGMENTS];
+    for (int segment = 0; segment < COVER_HASH_SEGMENTS; ++segment) {
+        QVector<int> &offset = offsets[segment];
+        offset.fill(0, buckets + 1);
+        for (quint64 hash : hashes) {
+            ++offset[coverSegment(hash, segment) + 1];
+        }
+        for (int value = 0; value < buckets; ++value) {
+            offset[value + 1] += offset[value];
+        }
+        QVector<int> next = offset;
+        QVector<int> &member = members[segment];
+        member.resize(count);
+        for (int i = 0; i < count; ++i) {
+            member[next[coverSegment(hashes.at(i), segment)]++] = i;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const quint64 hash = hashes.at(i);
+        for (int segment = 0; segment < COVER_HASH_SEGMENTS; ++segment) {
+            const quint32 value = coverSegment(hash, segment);
+            // 原值，以及允许一位误差时的 16 个单位翻转
+            const int probes = segmentErrors > 0 ? COVER_SEGMENT_BITS + 1 : 1;
+            for (int probe = 0; probe < probes; ++probe) {
+                const quint32 key = probe == 0 ? value : value ^ (1u << (probe - 1));
+                const int *begin = members[segment].constData() + offsets[segment].at(key);
+                const int *end = members[segment].constData() + offsets[segment].at(key + 1);
+                for (const int *it = begin; it != end; ++it) {
+                    const int j = *it;
+                    if (j <= i) {
+                        continue;
+                    }
+                    const quint64 diff = hash ^ hashes.at(j);
+                    if (qPopulationCount(diff) > maxDistance) {
+                        continue;
+                    }
+                    // 同一对可能在多段中命中，只在第一个满足条件的段中记录
+                    int first = 0;
+                    while (qPopulationCount(quint64(coverSegment(diff, first))) > segmentErrors) {
+                        ++first;
+                    }
+                    if (first == segment) {
+                        pairs.append(qMakePair(i, j));
+                    }
+                }
+            }
+        }
+    }
+    return pairs;
+}
+
+void DuplicateFinder::start(const QVector<quint32> &videoIds, bool verifyFull)
+{
+    cancel();
+    m_verifyFull = verifyFull;
+
+    // 同一文件可能同时属于多个媒体库目录（ID 相同），先去重
+    QVector<quint32> ids = videoIds;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    m_entries = retainEntries(ids);
+
+    // 只有大小相同的文件才可能重复，其余文件不读取
+    VideoCatalog *catalog = VideoCatalog::instance();
+    QHash<qint64, QVector<quint32>> bySize;
+    for (quint32 id : qAsConst(ids)) {
+        const qint64 size = catalog->fileSize(id);
+        if (size > 0) {
+            bySize[size].append(id);
+        }
+    }
+    for (auto it = bySize.constBegin(); it != bySize.constEnd(); ++it) {
+        if (it.value().size() > 1) {
+            m_groups.append(it.value());
+        }
+    }
+
+    runPhase(Phase::Sample);
+}
+
+void DuplicateFinder::startSimilarCovers(const QVector<quint32> &videoIds, int maxDistance)
+{
+    cancel();
+    m_maxCoverDistance = qBound(0, maxDistance, MAX_COVER_DISTANCE);
+
+    QVector<quint32> ids = videoIds;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    m_entries = retainEntries(ids);
+    m_groups.append(ids);
+
+    runPhase(Phase::Cover);
+}
+
+void DuplicateFinder::cancel()
+{
+    // 排队中的任务直接丢弃；已开始的任务由代数检查放弃结果
+    m_generation->fetchAndAddRelaxed(1);
+    ConcurrencyController::instance()->cancel(this);
+    m_groups.clear();
+    m_entries.reset();
+    m_phase = Phase::Idle;
+    m_pending = 0;
+}
+
+void DuplicateFinder::runPhase(Phase phase)
+{
+    m_phase = phase;
+
+    // 已缓存哈希的文件不再读取。封面哈希要在工作线程中对照封面文件的修改时间，
+    // 全部提交，未变化的封面不会重新解码
+    VideoCatalog *catalog = VideoCatalog::instance();
+    QVector<quint32> missing;
+    for (const QVector<quint32> &group : qAsConst(m_groups)) {
+        for (quint32 id : group) {
+            quint64 hash;
+            if (phase == Phase::Cover || !cachedHash(phase, id, &hash)) {
+                missing.append(id);
+            }
+        }
+    }
+
+    m_done = 0;
+    m_total = missing.size();
+    m_pending = missing.size();
+    if (missing.isEmpty()) {
+        finish();
+        return;
+    }
+    emit progress(0, m_total);
+
+    const quint64 generation = m_generation->loadRelaxed();
+    std::shared_ptr<QAtomicInteger<quint64>> currentGeneration = m_generation;
+    std::shared_ptr<const QVector<quint32>> entries = m_entries;
+    QPointer<DuplicateFinder> self(this);
+    // 读取封面是小文件解码，与封面图解码共用同一设备的并发控制
+    const WorkloadKind kind = phase == Phase::Cover ? WorkloadKind::CoverDecode : WorkloadKind::ContentHash;
+    for (quint32 id : qAsConst(missing)) {
+        const QString path = catalog->filePath(id);
+        const qint64 size = catalog->fileSize(id);
+        ConcurrencyController::instance()->submit(path, kind,
+                                                  [self, currentGeneration, entries, generation, phase, id, path, size]() {
+            if (currentGeneration->loadRelaxed() != generation) {
+                return;
+            }
+
+            // 结果直接写入目录（线程安全），主线程只计数
+            computeHash(phase, id, path, size);
+
+            QMetaObject::invokeMethod(qApp, [self, generation]() {
+                if (self) {
+                    self->onHashed(generation);
+                }
+            }, Qt::QueuedConnection);
+        }, this);
+    }
+}
+
+bool DuplicateFinder::cachedHash(Phase phase, quint32 id, quint64 *hash)
+{
+    VideoCatalog *catalog = VideoCatalog::instance();
+    switch (phase) {
+        case Phase::Sample:
+            return catalog->sampleHash(id, hash);
+        case Phase::Full:
+            return catalog->fullHash(id, hash);
+        case Phase::Cover:
+            return catalog->coverHash(id, hash);
+        case Phase::Idle:
+            break;
+    }
+    return false;
+}
+
+void DuplicateFinder::computeHash(Phase phase, quint32 id, const QString &path, qint64 size)
+{
+    VideoCatalog *catalog = VideoCatalog::instance();
+    quint64 hash = 0;
+    QString errorReason;
+    if (phase == Phase::Cover) {
+        // 没有封面的视频不参与比较；封面文件的修改时间未变时沿用缓存的哈希
+        const QString coverPath = VideoItem::coverFilePath(catalog->folderPath(id), catalog->fileName(id));
+        if (coverPath.isEmpty()) {
+            catalog->clearCoverHash(id);
+            return;
+        }
+        const qint64 coverModifiedMs = QFileInfo(coverPath).lastModified().toMSecsSinceEpoch();
+        qint64 cachedModifiedMs = 0;
+        if (catalog->coverHash(id, &hash, &cachedModifiedMs) && cachedModifiedMs == coverModifiedMs) {
+            return;
+        }
+        if (readCoverHash(coverPath, &hash)) {
+            catalog->setCoverHash(id, hash, coverModifiedMs);
+        } else {
+            catalog->clearCoverHash(id);
+        }
+    } else if (phase == Phase::Sample) {
+        if (sampledHash(path, size, &hash, &errorReason)) {
+            catalog->setSampleHash(id, hash);
+            if (size <= sampleCoverage()) {
+                catalog->setFullHash(id, hash);
+            }
+        } else {
+            qWarning() << "无法读取视频内容:" << path << errorReason;
+        }
+    } else {
+        if (fullHash(path, &hash, &errorReason)) {
+            catalog->setFullHash(id, hash);
+        } else {
+            qWarning() << "无法读取视频内容:" << path << errorReason;
+        }
+    }
+}
+
+void DuplicateFinder::onHashed(quint64 generation)
+{
+    if (generation != m_generation->loadRelaxed() || m_pending == 0) {
+        return;
+    }
+    ++m_done;
+    emit progress(m_done, m_total);
+    if (--m_pending == 0) {
+        finish();
+    }
+}
+
+QVector<QVector<quint32>> DuplicateFinder::regroup(Phase phase) const
+{
+    // 组内文件大小相同，按哈希细分；读取失败（没有哈希）的文件不计入
+    QVector<QVector<quint32>> result;
+    for (const QVector<quint32> &group : m_groups) {
+        QHash<quint64, QVector<quint32>> byHash;
+        for (quint32 id : group) {
+            quint64 hash;
+            if (cachedHash(phase, id, &hash)) {
+                byHash[hash].append(id);
+            }
+        }
+        for (auto it = byHash.constBegin(); it != byHash.constEnd(); ++it) {
+            if (it.value().size() > 1) {
+                result.append(it.value());
+            }
+        }
+    }
+    return result;
+}
+
+void DuplicateFinder::finish()
+{
+    if (m_phase == Phase::Cover) {
+        groupSimilarCovers();
+        return;
+    }
+
+    m_groups = regroup(m_phase);
+    if (m_phase == Phase::Sample && m_verifyFull && !m_groups.isEmpty()) {
+        runPhase(Phase::Full);
+        return;
+    }
+
+    VideoCatalog *catalog = VideoCatalog::instance();
+    QVector<DuplicateGroup> groups;
+    groups.reserve(m_groups.size());
+    for (const QVector<quint32> &ids : qAsConst(m_groups)) {
+        DuplicateGroup group;
+        group.videoIds = ids;
+        group.fileSize = catalog->fileSize(ids.first());
+        // 小文件的抽样已覆盖整个文件
+        group.verified = m_phase == Phase::Full || group.fileSize <= sampleCoverage();
+        groups.append(group);
+    }
+
+    // 浪费空间最多的组排在前面
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup &a, const DuplicateGroup &b) {
+        return a.fileSize * (a.videoIds.size() - 1) > b.fileSize * (b.videoIds.size() - 1);
+    });
+
+    m_groups.clear();
+    m_entries.reset();
+    m_phase = Phase::Idle;
+    m_pending = 0;
+    emit finished(groups);
+}
+
+// 并查集：相似关系传递，A~B、B~C 时三者归为一组
+static int findRoot(QVector<int> &parent, int i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void DuplicateFinder::groupSimilarCovers()
+{
+    // 在主线程中取出哈希，比较和聚类在工作线程中进行
+    QVector<quint32> ids;
+    QVector<quint64> hashes;
+    for (const QVector<quint32> &group : qAsConst(m_groups)) {
+        for (quint32 id : group) {
+            quint64 hash;
+            if (cachedHash(Phase::Cover, id, &hash)) {
+                ids.append(id);
+                hashes.append(hash);
+            }
+        }
+    }
+    m_groups.clear();
+    m_pending = 1; // 聚类完成前仍视为查找中
+
+    const quint64 generation = m_generation->loadRelaxed();
+    const int maxDistance = m_maxCoverDistance;
+    std::shared_ptr<const QVector<quint32>> entries = m_entries;
+    QPointer<DuplicateFinder> self(this);
+    QThreadPool::globalInstance()->start([self, generation, entries, ids, hashes, maxDistance]() {
+        QElapsedTimer timer;
+        timer.start();
+        const QVector<QPair<int, int>> pairs = similarPairs(hashes, maxDistance);
+
+        QVector<int> parent(ids.size());
+        for (int i = 0; i < parent.size(); ++i) {
+            parent[i] = i;
+        }
+        for (const auto &pair : pairs) {
+            parent[findRoot(parent, pair.first)] = findRoot(parent, pair.second);
+        }
+
+        // 统计各连通分量的大小，没有相似封面的视频不成组
+        QVector<int> componentSize(ids.size(), 0);
+        for (int i = 0; i < ids.size(); ++i) {
+            ++componentSize[findRoot(parent, i)];
+        }
+        QHash<int, int> groupOfRoot;
+        QVector<DuplicateGroup> groups;
+        for (int i = 0; i < ids.size(); ++i) {
+            const int root = findRoot(parent, i);
+            if (componentSize.at(root) < 2) {
+                continue;
+            }
+            auto it = groupOfRoot.constFind(root);
+            if (it == groupOfRoot.constEnd()) {
+                it = groupOfRoot.insert(root, groups.size());
+                DuplicateGroup group;
+                group.similarCover = true;
+                groups.append(group);
+            }
+            groups[it.value()].videoIds.append(ids.at(i));
+        }
+        std::sort(groups.begin(), groups.end(), [](const DuplicateGroup &a, const DuplicateGroup &b) {
+            return a.videoIds.size() > b.videoIds.size();
+        });
+        qDebug() << "封面相似查找：" << ids.size() << "个封面，" << pairs.size() << "对相似，"
+                 << groups.size() << "组，耗时" << timer.elapsed() << "毫秒";
+
+        QMetaObject::invokeMethod(qApp, [self, generation, entries, groups]() {
+            if (self && generation == self->m_generation->loadRelaxed()) {
+                self->m_entries.reset();
+                self->m_phase = Phase::Idle;
+                self->m_pending = 0;
+                emit self->finished(groups);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
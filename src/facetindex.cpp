@@ -0,0 +1,194 @@
+#include "facetindex.h"
+#include <algorithm>
+#include <limits>
+
+const qint64 FacetIndex::NO_VALUE = (std::numeric_limits<qint64>::min)();
+
+void FacetIndex::RangeColumn::set(quint32 id, qint64 value)
+{
+    if (id >= quint32(valueById.size())) {
+        if (value == NO_VALUE) {
+            return;
+        }
+        valueById.resize(id + 1, NO_VALUE);
+    }
+    if (valueById.at(id) != value) {
+        valueById[id] = value;
+        dirty = true;
+    }
+}
+
+void FacetIndex::RangeColumn::sort() const
+{
+    if (!dirty) {
+        return;
+    }
+
+    // 按 (值, ID) 排序后拆成两列，查询时只在值列上二分
+    QVector<QPair<qint64, quint32>> pairs;
+    pairs.reserve(valueById.size());
+    for (int id = 0; id < valueById.size(); ++id) {
+        if (valueById.at(id) != NO_VALUE) {
+            pairs.append(qMakePair(valueById.at(id), quint32(id)));
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    values.resize(pairs.size());
+    ids.resize(pairs.size());
+    for (int i = 0; i < pairs.size(); ++i) {
+        values[i] = pairs.at(i).first;
+        ids[i] = pairs.at(i).second;
+    }
+    dirty = false;
+}
+
+void FacetIndex::addValue(FacetField field, quint32 id, const QString &name)
+{
+    const QString folded = name.trimmed().toCaseFolded();
+    if (folded.isEmpty()) {
+        return;
+    }
+
+    ValueFacet &facet = m_values[int(field)];
+    auto it = facet.index.constFind(folded);
+    int valueIndex;
+    if (it != facet.index.constEnd()) {
+        valueIndex = it.value();
+    } else {
+        valueIndex = facet.names.size();
+        facet.names.append(name.trimmed());
+        facet.folded.append(folded);
+        facet.bitmaps.append(RoaringBitmap());
+        facet.index.insert(folded, valueIndex);
+    }
+
+    RoaringBitmap &bitmap = facet.bitmaps[valueIndex];
+    if (!bitmap.contains(id)) {
+        bitmap.add(id);
+        m_valuesById[id].append((quint32(field) << 24) | quint32(valueIndex));
+    }
+}
+
+void FacetIndex::insert(quint32 id, const VideoMetadata &metadata, qint64 fileSize)
+{
+    if (m_all.contains(id)) {
+        remove(id);
+    }
+
+    for (const QString &actor : metadata.actors) {
+        addValue(FacetField::Actor, id, actor);
+    }
+    for (const QString &genre : metadata.genres) {
+        addValue(FacetField::Genre, id, genre);
+    }
+    addValue(FacetField::Studio, id, metadata.studio);
+
+    m_ranges[int(FacetField::Date) - VALUE_FACET_COUNT].set(
+        id, metadata.releaseDate.isValid() ? metadata.releaseDate.toJulianDay() : NO_VALUE);
+    m_ranges[int(FacetField::Size) - VALUE_FACET_COUNT].set(id, fileSize);
+    m_ranges[int(FacetField::Rating) - VALUE_FACET_COUNT].set(
+        id, metadata.rating > 0 ? qRound(metadata.rating * 10) : NO_VALUE);
+
+    m_all.add(id);
+}
+
+void FacetIndex::remove(quint32 id)
+{
+    if (!m_all.contains(id)) {
+        return;
+    }
+
+    for (quint32 entry : m_valuesById.take(id)) {
+        m_values[entry >> 24].bitmaps[entry & 0xFFFFFF].remove(id);
+    }
+    for (RangeColumn &column : m_ranges) {
+        column.set(id, NO_VALUE);
+    }
+    m_all.remove(id);
+}
+
+void FacetIndex::clear()
+{
+    for (ValueFacet &facet : m_values) {
+        facet = ValueFacet();
+    }
+    for (RangeColumn &column : m_ranges) {
+        column = RangeColumn();
+    }
+    m_valuesById.clear();
+    m_all.clear();
+}
+
+RoaringBitmap FacetIndex::valueBitmap(const FacetFilter &filter) const
+{
+    // 取值表通常只有几千项，逐项比较子串后合并命中取值的位图
+    const ValueFacet &facet = m_values[int(filter.field)];
+    RoaringBitmap result;
+    for (int i = 0; i < facet.folded.size(); ++i) {
+        const QString &folded = facet.folded.at(i);
+        for (const QString &value : filter.values) {
+            if (folded.contains(value)) {
+                result = RoaringBitmap::unite(result, facet.bitmaps.at(i));
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+RoaringBitmap FacetIndex::rangeBitmap(const FacetFilter &filter) const
+{
+    const RangeColumn &column = m_ranges[int(filter.field) - VALUE_FACET_COUNT];
+    column.sort();
+
+    auto first = std::lower_bound(column.values.constBegin(), column.values.constEnd(), filter.min);
+    auto last = std::upper_bound(first, column.values.constEnd(), filter.max);
+    const int begin = int(first - column.values.constBegin());
+    const int end = int(last - column.values.constBegin());
+    return RoaringBitmap::fromValues(column.ids.constData() + begin, end - begin);
+}
+
+RoaringBitmap FacetIndex::evaluate(const QVector<FacetFilter> &filters) const
+{
+    RoaringBitmap result = m_all;
+    for (const FacetFilter &filter : filters) {
+        if (result.isEmpty()) {
+            break;
+        }
+        const RoaringBitmap matched = filter.isRange() ? rangeBitmap(filter) : valueBitmap(filter);
+        result = filter.negated ? RoaringBitmap::subtract(result, matched)
+                                : RoaringBitmap::intersect(result, matched);
+    }
+    return result;
+}
+
+QVector<FacetCount> FacetIndex::counts(FacetField field, const RoaringBitmap &within, int limit) const
+{
+    QVector<FacetCount> result;
+    if (int(field) >= VALUE_FACET_COUNT || limit <= 0) {
+        return result;
+    }
+
+    const ValueFacet &facet = m_values[int(field)];
+    for (int i = 0; i < facet.bitmaps.size(); ++i) {
+        const int count = RoaringBitmap::intersectionCount(facet.bitmaps.at(i), within);
+        if (count > 0) {
+            FacetCount entry;
+            entry.value = facet.names.at(i);
+            entry.count = count;
+            result.append(entry);
+        }
+    }
+
+    auto moreFirst = [](const FacetCount &a, const FacetCount &b) {
+        return a.count != b.count ? a.count > b.count : a.value < b.value;
+    };
+    if (result.size() > limit) {
+        std::partial_sort(result.begin(), result.begin() + limit, result.end(), moreFirst);
+        result.resize(limit);
+    } else {
+        std::sort(result.begin(), result.end(), moreFirst);
+    }
+    return result;
+}
@@ -0,0 +1,191 @@
+#include "librarysnapshot.h"
+#include "videocatalog.h"
+#include "xxhash64.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+
+static const quint32 SNAPSHOT_MAGIC = 0x4A415653; // "JAVS"
+static const quint32 SNAPSHOT_VERSION = 2;
+
+// 条目中已保存的哈希
+static const quint8 SNAPSHOT_SAMPLE_HASH = 0x1;
+static const quint8 SNAPSHOT_FULL_HASH = 0x2;
+static const quint8 SNAPSHOT_COVER_HASH = 0x4;
+
+// 保存内容哈希算法对固定输入的结果，读取时不一致则丢弃内容哈希（封面哈希与此无关）。
+// XXH64 与机器无关，只有更换算法（如早期版本的 qHashBits）时才会不一致
+static quint64 contentHashProbe()
+{
+    static const char probe[] = "JavArk content hash probe";
+    return XxHash64::hash(probe, sizeof(probe) - 1, 1);
+}
+
+QHash<QString, QVector<std::shared_ptr<VideoItem>>> LibrarySnapshot::load(const QString &filePath,
+                                                                          const QStringList &directories)
+{
+    QHash<QString, QVector<std::shared_ptr<VideoItem>>> result;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 probe = 0;
+    in >> magic >> version >> probe;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        qWarning() << "媒体库快照格式不符，忽略:" << filePath;
+        return result;
+    }
+    const bool contentHashesValid = probe == contentHashProbe();
+
+    VideoCatalog *catalog = VideoCatalog::instance();
+    quint32 directoryCount = 0;
+    in >> directoryCount;
+    for (quint32 d = 0; d < directoryCount && in.status() == QDataStream::Ok; ++d) {
+        QString directory;
+        QStringList folders;
+        quint32 count = 0;
+        in >> directory >> folders >> count;
+        // 配置中已移除的目录也要读完，才能继续读取后面的目录
+        const bool wanted = directories.contains(directory);
+
+        QVector<std::shared_ptr<VideoItem>> videos;
+        if (wanted) {
+            videos.reserve(count);
+        }
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            quint32 folder = 0;
+            QString fileName;
+            qint64 fileSize = 0;
+            qint64 creationMs = 0;
+            qint64 modifiedMs = 0;
+            qint64 nfoModifiedMs = 0;
+            in >> folder >> fileName >> fileSize >> creationMs >> modifiedMs >> nfoModifiedMs;
+
+            VideoMetadata metadata;
+            if (nfoModifiedMs != 0) {
+                qint64 releaseDay = 0;
+                in >> metadata.title >> metadata.actors >> metadata.genres >> metadata.studio
+                   >> releaseDay >> metadata.rating;
+                if (releaseDay != 0) {
+                    metadata.releaseDate = QDate::fromJulianDay(releaseDay);
+                }
+            }
+
+            quint8 hashes = 0;
+            quint64 sampleHash = 0;
+            quint64 fullHash = 0;
+            quint64 coverHash = 0;
+            qint64 coverModifiedMs = 0;
+            in >> hashes;
+            if (hashes & SNAPSHOT_SAMPLE_HASH) in >> sampleHash;
+            if (hashes & SNAPSHOT_FULL_HASH) in >> fullHash;
+            if (hashes & SNAPSHOT_COVER_HASH) in >> coverHash >> coverModifiedMs;
+
+            if (!wanted || folder >= quint32(folders.size()) || in.status() != QDataStream::Ok) {
+                continue;
+            }
+
+            auto video = std::make_shared<VideoItem>(folders.at(folder), fileName,
+                                                     fileSize, creationMs, modifiedMs);
+            const quint32 id = video->id();
+            if (nfoModifiedMs != 0 && catalog->nfoModifiedMs(id) == 0) {
+                catalog->setMetadata(id, metadata, nfoModifiedMs);
+            }
+            if (contentHashesValid && (hashes & SNAPSHOT_SAMPLE_HASH)) {
+                catalog->setSampleHash(id, sampleHash);
+            }
+            if (contentHashesValid && (hashes & SNAPSHOT_FULL_HASH)) {
+                catalog->setFullHash(id, fullHash);
+            }
+            if (hashes & SNAPSHOT_COVER_HASH) {
+                catalog->setCoverHash(id, coverHash, coverModifiedMs);
+            }
+            videos.append(video);
+        }
+        if (wanted) {
+            result.insert(directory, videos);
+        }
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "媒体库快照不完整，忽略:" << filePath;
+        result.clear();
+    }
+    return result;
+}
+
+bool LibrarySnapshot::save(const QString &filePath, const QHash<QString, QVector<quint32>> &videoIdsByDirectory)
+{
+    QDir().mkpath(QFileInfo(filePath).path());
+
+    // QSaveFile 写完后以重命名方式原子替换，写入中断时保留上一份快照
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "无法写入媒体库快照:" << filePath << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << contentHashProbe();
+    out << quint32(videoIdsByDirectory.size());
+
+    VideoCatalog *catalog = VideoCatalog::instance();
+    for (auto it = videoIdsByDirectory.constBegin(); it != videoIdsByDirectory.constEnd(); ++it) {
+        // 同一目录下的文件夹路径只写一次
+        QStringList folders;
+        QHash<QString, quint32> folderIndex;
+        QVector<quint32> folderOf;
+        folderOf.reserve(it.value().size());
+        for (quint32 id : it.value()) {
+            const QString folder = catalog->folderPath(id);
+            auto found = folderIndex.constFind(folder);
+            if (found == folderIndex.constEnd()) {
+                found = folderIndex.insert(folder, quint32(folders.size()));
+                folders.append(folder);
+            }
+            folderOf.append(found.value());
+        }
+
+        out << it.key() << folders << quint32(it.value().size());
+        for (int i = 0; i < it.value().size(); ++i) {
+            const quint32 id = it.value().at(i);
+            const qint64 nfoModifiedMs = catalog->nfoModifiedMs(id);
+            out << folderOf.at(i) << catalog->fileName(id) << catalog->fileSize(id)
+                << catalog->creationMs(id) << catalog->modifiedMs(id) << nfoModifiedMs;
+            if (nfoModifiedMs != 0) {
+                const VideoMetadata metadata = catalog->metadata(id);
+                const qint64 releaseDay = metadata.releaseDate.isValid() ? metadata.releaseDate.toJulianDay() : 0;
+                out << metadata.title << metadata.actors << metadata.genres << metadata.studio
+                    << releaseDay << metadata.rating;
+            }
+
+            quint64 sampleHash = 0;
+            quint64 fullHash = 0;
+            quint64 coverHash = 0;
+            qint64 coverModifiedMs = 0;
+            quint8 hashes = 0;
+            if (catalog->sampleHash(id, &sampleHash)) hashes |= SNAPSHOT_SAMPLE_HASH;
+            if (catalog->fullHash(id, &fullHash)) hashes |= SNAPSHOT_FULL_HASH;
+            if (catalog->coverHash(id, &coverHash, &coverModifiedMs)) hashes |= SNAPSHOT_COVER_HASH;
+            out << hashes;
+            if (hashes & SNAPSHOT_SAMPLE_HASH) out << sampleHash;
+            if (hashes & SNAPSHOT_FULL_HASH) out << fullHash;
+            if (hashes & SNAPSHOT_COVER_HASH) out << coverHash << coverModifiedMs;
+        }
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "写入媒体库快照失败:" << filePath << file.errorString();
+        return false;
+    }
+    return true;
+}
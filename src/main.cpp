@@ -9,6 +9,8 @@
 #include <QMessageBox>
 #include <QDateTime>
 #include <QTextStream>
+#include <QImage>
+#include <QThreadPool>
 
 // 设置自定义消息处理函数，记录到日志文件
 void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
@@ -53,7 +55,7 @@ void messageHandler(QtMsgType type, const QMessageLogContext &context, const QSt
     file.close();
 }
 
-// 创建默认图标
+// 创建默认图标（在工作线程中执行，只使用 QImage）
 void createDefaultIcons()
 {
     try {
@@ -78,10 +80,10 @@ void createDefaultIcons()
             QString path = iconDir.filePath(file);
             if (!QFile::exists(path)) {
                 // 创建一个简单的图标，实际项目应该使用真实图标
-                QPixmap pixmap(64, 64);
-                pixmap.fill(Qt::transparent);
+                QImage image(64, 64, QImage::Format_ARGB32_Premultiplied);
+                image.fill(Qt::transparent);
                 
-                QPainter painter(&pixmap);
+                QPainter painter(&image);
                 painter.setPen(QPen(Qt::black, 2));
                 painter.setBrush(Qt::white);
                 painter.drawRect(4, 4, 56, 56);
@@ -96,7 +98,8 @@ void createDefaultIcons()
                     painter.drawText(24, 38, "▶");
                 }
                 
-                bool success = pixmap.save(path);
+                painter.end();
+                bool success = image.save(path);
                 if (!success) {
                     qDebug() << "无法保存图标文件:" << path;
                 }
@@ -140,9 +143,6 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
     
     try {
-        // 创建默认图标
-        createDefaultIcons();
-        
         // 设置高优先级
         setHighPriority();
         
@@ -150,6 +150,9 @@ int main(int argc, char *argv[])
         MainWindow mainWindow;
         mainWindow.show();
         
+        // 默认图标只写到磁盘供外部使用（界面使用资源中的图标），不阻塞首屏
+        QThreadPool::globalInstance()->start(createDefaultIcons);
+        
         return app.exec();
     } catch (const std::exception& e) {
         qDebug() << "应用程序启动时发生异常:" << e.what();
@@ -1,33 +1,61 @@
 #include "mainwindow.h"
-#include <QMouseEvent>
-#include <QPainter>
 #include <QStandardPaths>
 #include <QDir>
 #include <QApplication>
 #include <QStyle>
 #include <QScreen>
-#include <QStyleOption>
 #include <QDebug>
 #include <QMessageBox>
 #include <QTimer>
 #include <QTabWidget>
+#include <QDateTime>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QTreeWidget>
+#include <QLocale>
+#include <QSet>
+#include <algorithm>
+#include "concurrencycontroller.h"
+#include "videogridview.h"
+#include "videodelegate.h"
+#include "mergedvideomodel.h"
+#include "settingsstore.h"
+#include "videocatalog.h"
 
 // 默认配置
 const int DEFAULT_GRID_COLUMNS = 5;
 const int DEFAULT_THUMBNAIL_SIZE = 240;
 const QString CONFIG_FILENAME = "javark.ini";
+const int SEARCH_DEBOUNCE_MS = 150;
+// 标签页离开超过该时间后释放其模型和视图，每分钟检查一次
+const qint64 TAB_VIEW_IDLE_RELEASE_MS = 10 * 60 * 1000;
+const int TAB_VIEW_RELEASE_CHECK_MS = 60 * 1000;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       m_library(new VideoLibrary(this)),
+      m_settings(nullptr),
+      m_currentPage(nullptr),
+      m_tabReleaseTimer(new QTimer(this)),
+      m_allPage(nullptr),
+      m_allModel(nullptr),
+      m_allView(nullptr),
+      m_allHiddenSinceMs(0),
       m_gridColumns(DEFAULT_GRID_COLUMNS),
       m_thumbnailSize(DEFAULT_THUMBNAIL_SIZE),
       m_useFanartMode(false), // 默认使用海报模式
       m_sortOrder(SortOrder::NameAsc), // 默认按文件名排序
-      m_searchText("") // 初始化搜索文本为空
+      m_searchText(""), // 初始化搜索文本为空
+      m_searchTimer(new QTimer(this)),
+      m_hoverScrubEnabled(false),
+      m_duplicateFinder(new DuplicateFinder(this)),
+      m_firstGridShown(false)
 {
+    m_startupTimer.start();
+
     // 设置配置文件路径 - 使用应用程序目录下的配置文件（便携版）
     m_configFile = QCoreApplication::applicationDirPath() + "/" + CONFIG_FILENAME;
+    m_settings = new SettingsStore(m_configFile, this);
 
     // 确保日志目录存在
     QDir logDir(QCoreApplication::applicationDirPath() + "/logs");
@@ -94,11 +122,19 @@ MainWindow::MainWindow(QWidget *parent)
     createMenus();
 
     // 连接视频库信号
-    connect(m_library, &VideoLibrary::videoAdded, this, &MainWindow::onVideoAdded);
+    connect(m_library, &VideoLibrary::videosAdded, this, &MainWindow::onVideosAdded);
+    connect(m_library, &VideoLibrary::videosRemoved, this, &MainWindow::onVideosRemoved);
+    connect(m_library, &VideoLibrary::snapshotLoaded, this, &MainWindow::onSnapshotLoaded);
     connect(m_library, &VideoLibrary::scanStarted, this, &MainWindow::onScanStarted);
     connect(m_library, &VideoLibrary::scanProgress, this, &MainWindow::onScanProgress);
     connect(m_library, &VideoLibrary::scanFinished, this, &MainWindow::onScanFinished);
     connect(m_library, &VideoLibrary::videoPosterReady, this, &MainWindow::onVideoPosterReady);
+    connect(m_library, &VideoLibrary::videoSpriteSheetReady, this, &MainWindow::onVideoSpriteSheetReady);
+    connect(m_library, &VideoLibrary::videoPosterFailed, this, &MainWindow::onVideoPosterFailed);
+    connect(ConcurrencyController::instance(), &ConcurrencyController::levelChanged,
+            this, &MainWindow::updateConcurrencyStatus);
+    connect(m_duplicateFinder, &DuplicateFinder::progress, this, &MainWindow::onDuplicateProgress);
+    connect(m_duplicateFinder, &DuplicateFinder::finished, this, &MainWindow::onDuplicatesFound);
 
     // 连接工具栏按钮
     connect(m_addDirButton, &QPushButton::clicked, this, &MainWindow::onAddDirectory);
@@ -106,10 +142,20 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_scanButton, &QPushButton::clicked, this, &MainWindow::onScanLibrary);
     connect(m_sortButton, &QPushButton::clicked, this, &MainWindow::onToggleSortOrder);
     connect(m_toggleCoverButton, &QPushButton::clicked, this, &MainWindow::onToggleCoverMode);
+    connect(m_hoverScrubButton, &QPushButton::clicked, this, &MainWindow::onToggleHoverScrub);
     connect(m_increaseButton, &QPushButton::clicked, this, &MainWindow::onIncreaseThumbnailSize);
     connect(m_decreaseButton, &QPushButton::clicked, this, &MainWindow::onDecreaseThumbnailSize);
     connect(m_searchEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
 
+    // 搜索防抖：连续输入时只在停顿后过滤一次
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(SEARCH_DEBOUNCE_MS);
+    connect(m_searchTimer, &QTimer::timeout, this, &MainWindow::filterVideos);
+
+    m_tabReleaseTimer->setInterval(TAB_VIEW_RELEASE_CHECK_MS);
+    connect(m_tabReleaseTimer, &QTimer::timeout, this, &MainWindow::releaseIdleTabViews);
+    m_tabReleaseTimer->start();
+
     // 加载设置
     loadSettings();
 
@@ -127,6 +173,7 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     saveSettings();
+    m_settings->sync();
 }
 
 void MainWindow::createUI()
@@ -177,6 +224,24 @@ void MainWindow::createUI()
     m_toggleCoverButton->setFixedHeight(32);
     m_toggleCoverButton->setStyleSheet("background-color: #505060; color: white; font-weight: bold;");
 
+    // 创建悬停预览开关按钮
+    m_hoverScrubButton = new QPushButton(tr("悬停预览"), this);
+    m_hoverScrubButton->setCheckable(true);
+    m_hoverScrubButton->setFixedHeight(32);
+    m_hoverScrubButton->setToolTip(tr("鼠标在封面上横向移动时预览视频画面"));
+    m_hoverScrubButton->setStyleSheet("QPushButton { background-color: #505060; color: white; font-weight: bold; } QPushButton:checked { background-color: #0078D7; }");
+
+    // 创建查找重复按钮：默认只抽样比较，完整校验需要读取整个文件
+    m_duplicateButton = new QPushButton(tr("查找重复"), this);
+    m_duplicateButton->setFixedHeight(32);
+    m_duplicateButton->setToolTip(tr("在所有媒体库目录中查找内容相同的视频"));
+    m_duplicateButton->setStyleSheet("background-color: #505060; color: white; font-weight: bold;");
+    QMenu *duplicateMenu = new QMenu(m_duplicateButton);
+    duplicateMenu->addAction(tr("快速查找（抽样比较）"), this, [this]() { onFindDuplicates(false); });
+    duplicateMenu->addAction(tr("完整校验（读取整个文件）"), this, [this]() { onFindDuplicates(true); });
+    duplicateMenu->addAction(tr("相似封面（不同编码的同一作品）"), this, &MainWindow::onFindSimilarCovers);
+    m_duplicateButton->setMenu(duplicateMenu);
+
     // 创建缩略图尺寸调整按钮
     m_increaseButton = new QPushButton("+", this);
     m_increaseButton->setFixedSize(32, 32);
@@ -188,7 +253,7 @@ void MainWindow::createUI()
 
     // 创建搜索框
     m_searchEdit = new QLineEdit(this);
-    m_searchEdit->setPlaceholderText(tr("搜索视频..."));
+    m_searchEdit->setPlaceholderText(tr("搜索视频...（可用 actor: genre: year>= size> 过滤）"));
     m_searchEdit->setClearButtonEnabled(true);
     m_searchEdit->setFixedHeight(32);
     m_searchEdit->setMinimumWidth(200);
@@ -215,18 +280,32 @@ void MainWindow::createUI()
     m_toolbarLayout->addWidget(m_scanButton);
     m_toolbarLayout->addWidget(m_sortButton);
     m_toolbarLayout->addWidget(m_toggleCoverButton);
+    m_toolbarLayout->addWidget(m_hoverScrubButton);
+    m_toolbarLayout->addWidget(m_duplicateButton);
     m_toolbarLayout->addWidget(m_decreaseButton);
     m_toolbarLayout->addWidget(m_increaseButton);
     m_toolbarLayout->addStretch(1);
     m_toolbarLayout->addWidget(m_searchEdit);
 
+    // 显示封面提取/解码的自适应并发水平
+    m_concurrencyLabel = new QLabel(this);
+    m_concurrencyLabel->setFrameShape(QFrame::NoFrame);
+    m_concurrencyLabel->setStyleSheet("color: #A0A0A0;");
+
     // 添加控件到底部状态栏布局
     m_bottomLayout->addWidget(m_statusLabel, 1);
+    m_bottomLayout->addWidget(m_concurrencyLabel);
 
     // 创建 QTabWidget
     m_tabWidget = new QTabWidget(this);
     m_tabWidget->setTabsClosable(false); // 根据需要设置是否可关闭
     m_tabWidget->setStyleSheet("QTabBar::tab { padding: 8px; background-color: #3A3A42; border-top-left-radius: 4px; border-top-right-radius: 4px; font-size: 11pt; font-weight: bold; } QTabBar::tab:selected { background-color: #2D2D30; border: 1px solid #3F3F46; border-bottom: none; } QTabWidget::pane { border: 1px solid #3F3F46; border-top: none; background-color: #2D2D30; }");
+    // “全部”标签页，加入第一个目录后显示在最后
+    m_allPage = createTabPage();
+    m_allPage->setToolTip(tr("所有媒体库目录"));
+
+    // 标签页首次显示时才创建视图；状态栏显示当前标签页的选中数量
+    connect(m_tabWidget, &QTabWidget::currentChanged, this, &MainWindow::onCurrentTabChanged);
 
     // 添加到主布局 (替换旧的 m_scrollArea)
     m_mainLayout->addLayout(m_toolbarLayout);
@@ -284,22 +363,10 @@ void MainWindow::updateDirectoryList()
                 if (reply == QMessageBox::Yes) {
                     m_library->removeDirectory(dir); // 从库中移除目录
                     updateDirectoryList();           // 更新目录菜单显示
+                    m_library->saveLibraryConfig(m_settings); // 延迟写盘
 
                     // 从 TabWidget 中移除对应的标签页
-                    if (m_tabContents.contains(dir)) {
-                        QWidget* tabContent = m_tabContents.value(dir);
-                        int index = m_tabWidget->indexOf(tabContent);
-                        if (index != -1) {
-                            m_tabWidget->removeTab(index);
-                        }
-                        // 清理相关数据结构
-                        delete m_tabGridLayouts.value(dir); // 删除布局会删除其中的 QScrollArea
-                        m_tabGridLayouts.remove(dir);
-                        qDeleteAll(m_tabVideoWidgets.value(dir));
-                        m_tabVideoWidgets.remove(dir);
-                        delete tabContent; // 删除主内容 QWidget
-                        m_tabContents.remove(dir);
-                    }
+                    removeTab(dir);
                 }
             });
             m_dirMenu->addAction(action);
@@ -318,6 +385,7 @@ void MainWindow::onAddDirectory()
     if (!dir.isEmpty()) {
         m_library->addDirectory(dir);
         updateDirectoryList();
+        m_library->saveLibraryConfig(m_settings);
 
         // 自动开始扫描
         onScanLibrary();
@@ -334,75 +402,380 @@ void MainWindow::onScanLibrary()
     m_library->scanLibrary();
 }
 
-void MainWindow::onVideoAdded(const QString& directory, std::shared_ptr<VideoItem> video)
+void MainWindow::onVideosAdded(const QString& directory, const QVector<quint32>& videoIds)
 {
-    QWidget* tabContentWidget = nullptr;
-    QGridLayout* gridLayout = nullptr;
-    QList<VideoWidget*>* videoWidgets = nullptr;
-
-    // 检查此目录的标签页是否已存在
-    if (!m_tabContents.contains(directory)) {
-        // 创建新的标签页内容
-        tabContentWidget = new QWidget(m_tabWidget);
-        QVBoxLayout* tabLayout = new QVBoxLayout(tabContentWidget); // 使用 QVBoxLayout 包裹 ScrollArea
-        tabLayout->setContentsMargins(0, 0, 0, 0);
-
-        QScrollArea* scrollArea = new QScrollArea(tabContentWidget);
-        scrollArea->setWidgetResizable(true);
-        scrollArea->setFrameShape(QFrame::NoFrame);
-        scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-        scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-        scrollArea->setStyleSheet("background-color: #2D2D30;"); // 确保滚动区域背景色一致
-
-        QWidget* scrollContent = new QWidget(scrollArea);
-        gridLayout = new QGridLayout(scrollContent);
-        gridLayout->setContentsMargins(10, 10, 10, 10); // 增加边距
-        gridLayout->setSpacing(10);
-        scrollArea->setWidget(scrollContent);
-
-        tabLayout->addWidget(scrollArea); // 将 ScrollArea 添加到标签页布局
-
-        // 存储新创建的元素
-        m_tabContents.insert(directory, tabContentWidget);
-        m_tabGridLayouts.insert(directory, gridLayout);
-        m_tabVideoWidgets.insert(directory, QList<VideoWidget*>());
-
-        // 添加新的标签页到 TabWidget
+    // 信号只带 ID，按 ID 从视频库取得视频对象
+    QVector<std::shared_ptr<VideoItem>> videos;
+    videos.reserve(videoIds.size());
+    for (quint32 videoId : videoIds) {
+        if (std::shared_ptr<VideoItem> video = m_library->video(videoId)) {
+            videos.append(video);
+        }
+    }
+
+    LibraryTab& tab = ensureTab(directory);
+    QWidget* page = tab.page;
+
+    tab.videos += videos;
+    m_directoryOfVideo.reserve(m_directoryOfVideo.size() + videos.size());
+    for (const std::shared_ptr<VideoItem>& video : videos) {
+        m_directoryOfVideo.insert(video->id(), directory);
+    }
+
+    // 搜索过程中新扫描到的视频：补充匹配结果，未创建视图的标签页只累加数量
+    if (!m_searchQuery.isEmpty()) {
+        for (const std::shared_ptr<VideoItem>& video : videos) {
+            int rank = m_searchQuery.rank(*video);
+            if (rank >= 0) {
+                m_searchMatches.append(SearchMatch{video.get(), rank});
+                ++tab.matchCount;
+            }
+        }
+    }
+
+    if (tab.model) {
+        // 已有模型：按当前排序方式把整批视频归并到最终位置
+        tab.model->insertVideos(videos);
+    } else if (m_allModel) {
+        // “全部”标签页正在使用，新目录的模型也要参与归并
+        updateAllTabSources();
+    }
+
+    if (m_tabWidget->indexOf(page) == -1) {
+        // 按目录名顺序添加标签页（第一个标签页加入后会成为当前页并立即创建视图）
         // 使用 QDir 获取目录名作为标签文本
         QString tabLabel = QDir(directory).dirName();
         if (tabLabel.isEmpty()) tabLabel = directory; // 如果是根目录，显示完整路径
-        m_tabWidget->addTab(tabContentWidget, tabLabel);
-        m_tabWidget->setTabToolTip(m_tabWidget->indexOf(tabContentWidget), directory); // 设置完整路径为 ToolTip
-    } else {
-        // 获取现有的元素
-        tabContentWidget = m_tabContents.value(directory);
-        gridLayout = m_tabGridLayouts.value(directory);
+        int index = m_tabWidget->insertTab(tabInsertIndex(directory), page, tabLabel);
+        m_tabWidget->setTabToolTip(index, directory); // 设置完整路径为 ToolTip
+    }
+    if (m_tabWidget->indexOf(m_allPage) == -1) {
+        m_tabWidget->addTab(m_allPage, tr("全部"));
     }
 
-    videoWidgets = &m_tabVideoWidgets[directory];
+    updateTabTitles();
 
-    // 计算网格位置
-    int currentGridColumns = calculateColumnsForTab(tabContentWidget);
-    int row = videoWidgets->size() / currentGridColumns;
-    int col = videoWidgets->size() % currentGridColumns;
+    // 首屏时间：等这一批绘制完（排在绘制事件之后）再记录
+    if (!m_firstGridShown && !videos.isEmpty()) {
+        m_firstGridShown = true;
+        const bool fromSnapshot = m_scanButton->isEnabled(); // 扫描期间扫描按钮不可用
+        QTimer::singleShot(0, this, [this, fromSnapshot]() {
+            qInfo() << "首屏网格" << m_startupTimer.elapsed() << "毫秒"
+                    << (fromSnapshot ? "（来自快照）" : "（来自扫描）");
+        });
+    }
+}
 
-    // 创建视频小部件 (传递当前封面模式)
-    VideoWidget *widget = new VideoWidget(video, m_thumbnailSize, m_useFanartMode, tabContentWidget);
-    videoWidgets->append(widget);
+void MainWindow::onVideosRemoved(const QString& directory, const QVector<quint32>& videoIds)
+{
+    auto it = m_tabs.find(directory);
+    if (it == m_tabs.end()) {
+        return;
+    }
+    LibraryTab& tab = it.value();
+    const QSet<quint32> removed(videoIds.begin(), videoIds.end());
+
+    // 先丢弃搜索匹配（只保存了裸指针）和模型中的行，再释放视频
+    auto matchEnd = std::remove_if(m_searchMatches.begin(), m_searchMatches.end(),
+                                   [&removed](const SearchMatch& match) {
+        return removed.contains(match.video->id());
+    });
+    tab.matchCount -= int(m_searchMatches.end() - matchEnd);
+    m_searchMatches.erase(matchEnd, m_searchMatches.end());
+    if (tab.model) {
+        tab.model->removeVideos(videoIds);
+    }
 
-    // 添加到对应的网格布局
-    gridLayout->addWidget(widget, row, col);
+    tab.videos.erase(std::remove_if(tab.videos.begin(), tab.videos.end(),
+                                    [&removed](const std::shared_ptr<VideoItem>& video) {
+        return removed.contains(video->id());
+    }), tab.videos.end());
+    for (quint32 videoId : videoIds) {
+        m_directoryOfVideo.remove(videoId);
+    }
+    updateTabTitles();
 }
 
-void MainWindow::onScanStarted()
+void MainWindow::onSnapshotLoaded(int videoCount)
+{
+    if (videoCount > 0) {
+        qInfo() << "从快照显示了" << videoCount << "个视频，耗时" << m_startupTimer.elapsed() << "毫秒，后台重新扫描";
+    }
+    if (!m_library->directories().isEmpty()) {
+        onScanLibrary();
+    }
+}
+
+int MainWindow::tabInsertIndex(const QString& directory) const
+{
+    // “全部”标签页始终在最后
+    int index = 0;
+    while (index < m_tabWidget->count()) {
+        QWidget* page = m_tabWidget->widget(index);
+        if (page == m_allPage || directory < m_directoryOfPage.value(page)) {
+            break;
+        }
+        ++index;
+    }
+    return index;
+}
+
+QWidget* MainWindow::createTabPage()
+{
+    // 只创建一个空容器，视图在首次显示时再放入
+    QWidget* page = new QWidget(m_tabWidget);
+    QVBoxLayout* layout = new QVBoxLayout(page);
+    layout->setContentsMargins(0, 0, 0, 0);
+    return page;
+}
+
+MainWindow::LibraryTab& MainWindow::ensureTab(const QString& directory)
+{
+    auto it = m_tabs.find(directory);
+    if (it != m_tabs.end()) {
+        return it.value();
+    }
+
+    LibraryTab tab;
+    tab.page = createTabPage();
+    m_directoryOfPage.insert(tab.page, directory);
+    return m_tabs.insert(directory, tab).value();
+}
+
+VideoListModel* MainWindow::ensureTabModel(const QString& directory)
+{
+    auto it = m_tabs.find(directory);
+    if (it == m_tabs.end()) {
+        return nullptr;
+    }
+    LibraryTab& tab = it.value();
+    if (tab.model) {
+        return tab.model;
+    }
+
+    // 按当前排序方式一次性排好全部视频，再应用当前的搜索结果
+    tab.model = new VideoListModel(directory, this);
+    tab.model->sortBy(m_sortOrder);
+    tab.model->setVideos(tab.videos);
+    if (!m_searchQuery.isEmpty()) {
+        tab.model->setSearch(m_searchQuery, m_searchMatches);
+    }
+    return tab.model;
+}
+
+VideoGridView* MainWindow::createGridView(AbstractVideoModel* model, QWidget* page)
+{
+    VideoGridView* view = new VideoGridView(model, page);
+    view->setThumbnailSize(m_thumbnailSize);
+    view->setUseFanartMode(m_useFanartMode);
+    view->setHoverScrubEnabled(m_hoverScrubEnabled);
+    connect(view, &VideoGridView::spriteSheetRequested, m_library, &VideoLibrary::requestSpriteSheet);
+    connect(view, &VideoGridView::selectedCountChanged, this, &MainWindow::updateTabTitles);
+    page->layout()->addWidget(view);
+    return view;
+}
+
+VideoGridView* MainWindow::materializeTab(const QString& directory)
+{
+    VideoListModel* model = ensureTabModel(directory);
+    if (!model) {
+        return nullptr;
+    }
+    LibraryTab& tab = m_tabs[directory];
+    if (!tab.view) {
+        tab.view = createGridView(model, tab.page);
+    }
+    return tab.view;
+}
+
+VideoGridView* MainWindow::materializeAllTab()
+{
+    if (!m_allView) {
+        // 各目录的模型保持各自的有序排列，“全部”视图只做惰性归并
+        m_allModel = new MergedVideoModel(this);
+        updateAllTabSources();
+        m_allView = createGridView(m_allModel, m_allPage);
+    }
+    return m_allView;
+}
+
+void MainWindow::updateAllTabSources()
+{
+    if (!m_allModel) {
+        return;
+    }
+    // 按目录名顺序（与标签页一致），键相同时排在前面的目录优先
+    QStringList directories = m_tabs.keys();
+    std::sort(directories.begin(), directories.end());
+    QVector<VideoListModel*> sources;
+    sources.reserve(directories.size());
+    for (const QString& directory : qAsConst(directories)) {
+        sources.append(ensureTabModel(directory));
+    }
+    if (sources != m_allModel->sources()) {
+        m_allModel->setSources(sources);
+    }
+}
+
+void MainWindow::releaseTabView(LibraryTab& tab)
+{
+    // 释放视图；“全部”标签页仍在使用时保留模型，否则一并释放，
+    // 视频列表保留，再次显示时重新创建
+    delete tab.view;
+    tab.view = nullptr;
+    if (!m_allModel) {
+        delete tab.model;
+        tab.model = nullptr;
+    }
+}
+
+void MainWindow::releaseAllTabView()
+{
+    delete m_allView;
+    delete m_allModel;
+    m_allView = nullptr;
+    m_allModel = nullptr;
+
+    // 只为“全部”标签页创建的目录模型也不再需要
+    for (LibraryTab& tab : m_tabs) {
+        if (!tab.view) {
+            delete tab.model;
+            tab.model = nullptr;
+        }
+    }
+}
+
+void MainWindow::removeTab(const QString& directory)
+{
+    auto it = m_tabs.find(directory);
+    if (it == m_tabs.end()) {
+        return;
+    }
+
+    // 先丢弃该目录的搜索匹配（只保存了裸指针），再释放视频
+    m_searchMatches.erase(std::remove_if(m_searchMatches.begin(), m_searchMatches.end(),
+                                         [this, &directory](const SearchMatch& match) {
+        return m_directoryOfVideo.value(match.video->id()) == directory;
+    }), m_searchMatches.end());
+    for (const std::shared_ptr<VideoItem>& video : qAsConst(it->videos)) {
+        m_directoryOfVideo.remove(video->id());
+    }
+
+    LibraryTab tab = it.value();
+    m_tabs.erase(it);
+    m_directoryOfPage.remove(tab.page);
+
+    // 先让“全部”标签页停止引用该目录的模型
+    updateAllTabSources();
+    delete tab.view;
+    delete tab.model;
+
+    int index = m_tabWidget->indexOf(tab.page);
+    if (index != -1) {
+        m_tabWidget->removeTab(index);
+    }
+    delete tab.page;
+
+    // 没有目录时也不再显示“全部”标签页
+    if (m_tabs.isEmpty()) {
+        index = m_tabWidget->indexOf(m_allPage);
+        if (index != -1) {
+            m_tabWidget->removeTab(index);
+        }
+        releaseAllTabView();
+    }
+    updateTabTitles();
+}
+
+QString MainWindow::currentTabDirectory() const
+{
+    return m_directoryOfPage.value(m_tabWidget->currentWidget());
+}
+
+VideoGridView* MainWindow::currentTabView() const
+{
+    if (m_tabWidget->currentWidget() == m_allPage) {
+        return m_allView;
+    }
+    return m_tabs.value(currentTabDirectory()).view;
+}
+
+QVector<VideoGridView*> MainWindow::tabViews() const
 {
-    // 清除所有标签页的内容
-    clearVideoWidgets();
+    QVector<VideoGridView*> views;
+    for (const LibraryTab& tab : m_tabs) {
+        if (tab.view) {
+            views.append(tab.view);
+        }
+    }
+    if (m_allView) {
+        views.append(m_allView);
+    }
+    return views;
+}
+
+int MainWindow::visibleCount(const LibraryTab& tab) const
+{
+    if (tab.model) {
+        return tab.model->rowCount();
+    }
+    return m_searchQuery.isEmpty() ? tab.videos.size() : tab.matchCount;
+}
+
+void MainWindow::onCurrentTabChanged(int index)
+{
+    Q_UNUSED(index);
+
+    // 记录离开的标签页的时间，空闲足够久后释放其视图
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (m_currentPage == m_allPage) {
+        m_allHiddenSinceMs = now;
+    } else {
+        auto previous = m_tabs.find(m_directoryOfPage.value(m_currentPage));
+        if (previous != m_tabs.end()) {
+            previous->hiddenSinceMs = now;
+        }
+    }
 
-    // 显示进度条
+    m_currentPage = m_tabWidget->currentWidget();
+    if (m_currentPage == m_allPage) {
+        materializeAllTab();
+        adjustGridColumns();
+    } else if (m_directoryOfPage.contains(m_currentPage)) {
+        materializeTab(m_directoryOfPage.value(m_currentPage));
+        adjustGridColumns();
+    }
+    updateTabTitles();
+}
+
+void MainWindow::releaseIdleTabViews()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (m_allView && m_currentPage != m_allPage
+        && now - m_allHiddenSinceMs >= TAB_VIEW_IDLE_RELEASE_MS) {
+        releaseAllTabView();
+    }
+    for (auto it = m_tabs.begin(); it != m_tabs.end(); ++it) {
+        if (it->view && it->page != m_currentPage
+            && now - it->hiddenSinceMs >= TAB_VIEW_IDLE_RELEASE_MS) {
+            releaseTabView(it.value());
+        }
+    }
+}
+
+void MainWindow::onScanStarted()
+{
+    // 扫描期间继续显示现有内容，完成后只按差异增删视频
+    m_scanTimer.start();
     m_progressBar->setVisible(true);
     m_progressBar->setValue(0);
-    m_statusLabel->setText(tr("扫描中..."));
+    m_statusLabel->setText(m_directoryOfVideo.isEmpty() ? tr("扫描中...") : tr("后台更新中..."));
+
+    // 扫描期间视频列表会变化，放弃正在进行的重复查找（已算出的哈希保留在目录中）
+    if (m_duplicateFinder->isRunning()) {
+        m_duplicateFinder->cancel();
+        m_duplicateButton->setEnabled(true);
+    }
 
     // 禁用扫描按钮
     m_scanButton->setEnabled(false);
@@ -422,73 +795,42 @@ void MainWindow::onScanFinished()
 {
     // 隐藏进度条
     m_progressBar->setVisible(false);
+    qInfo() << "媒体库扫描完成，耗时" << m_scanTimer.elapsed() << "毫秒（启动后" << m_startupTimer.elapsed() << "毫秒）";
 
-    // 扫描完成后，可能需要重新排序和布局所有标签页的内容
-    refreshVideoDisplay(); // 使用新的刷新逻辑
+    // 视频在扫描过程中已按序插入，只需更新标签标题和状态栏
+    updateTabTitles();
+    updateFacetToolTip();
+    adjustGridColumns();
 
     // 启用扫描按钮
     m_scanButton->setEnabled(true);
 }
 
-void MainWindow::clearVideoWidgets()
-{
-    // 清除所有标签页的内容
-    for (const QString& dir : m_tabContents.keys()) {
-        QWidget* tabContentWidget = m_tabContents.value(dir);
-        clearVideoWidgetsInTab(tabContentWidget);
-    }
-}
-
-// 清空特定标签页的视频小部件
-void MainWindow::clearVideoWidgetsInTab(QWidget* tabContentWidget)
-{
-    QString dir = m_tabContents.key(tabContentWidget);
-    if (dir.isEmpty()) return;
-
-    if (m_tabGridLayouts.contains(dir) && m_tabVideoWidgets.contains(dir)) {
-        QGridLayout* gridLayout = m_tabGridLayouts.value(dir);
-        QList<VideoWidget*>& videoWidgets = m_tabVideoWidgets[dir];
-
-        for (VideoWidget *widget : qAsConst(videoWidgets)) {
-            gridLayout->removeWidget(widget);
-            widget->deleteLater();
-        }
-        videoWidgets.clear();
-    }
-}
-
 void MainWindow::closeEvent(QCloseEvent *event)
 {
+    // 退出前同步写盘，不丢失尚在延迟中的修改
     saveSettings();
+    m_settings->sync();
     event->accept();
 }
 
 void MainWindow::saveSettings()
 {
     try {
-        // 确保目录存在
-        QFileInfo fileInfo(m_configFile);
-        QDir().mkpath(fileInfo.path());
-
         // 保存库目录
-        m_library->saveLibraryConfig(m_configFile);
-
-        // 保存窗口设置
-        QSettings settings(m_configFile, QSettings::IniFormat);
-        settings.beginGroup("MainWindow");
-        settings.setValue("geometry", saveGeometry());
-        settings.setValue("state", saveState());
-        settings.setValue("gridColumns", m_gridColumns);
-        settings.setValue("thumbnailSize", m_thumbnailSize);
-        settings.setValue("useFanartMode", m_useFanartMode);
-        settings.setValue("sortOrder", static_cast<int>(m_sortOrder));
-        settings.endGroup();
-
-        if (settings.status() != QSettings::NoError) {
-            qDebug() << "保存设置时出错:" << settings.status();
-        }
+        m_library->saveLibraryConfig(m_settings);
+
+        // 记录当前标签页的列数
+        adjustGridColumns();
 
-        settings.sync();
+        // 保存窗口设置（只更新内存，由配置存储在后台写盘）
+        m_settings->setValue("MainWindow/geometry", saveGeometry());
+        m_settings->setValue("MainWindow/state", saveState());
+        m_settings->setValue("MainWindow/gridColumns", m_gridColumns);
+        m_settings->setValue("MainWindow/thumbnailSize", m_thumbnailSize);
+        m_settings->setValue("MainWindow/useFanartMode", m_useFanartMode);
+        m_settings->setValue("MainWindow/sortOrder", static_cast<int>(m_sortOrder));
+        m_settings->setValue("MainWindow/hoverScrub", m_hoverScrubEnabled);
     } catch (const std::exception& e) {
         qDebug() << "保存设置时发生异常:" << e.what();
     } catch (...) {
@@ -498,20 +840,23 @@ void MainWindow::saveSettings()
 
 void MainWindow::loadSettings()
 {
+    // 读取配置文件到内存
+    m_settings->load();
+
     // 加载库目录
-    m_library->loadLibraryConfig(m_configFile);
+    m_library->loadLibraryConfig(m_settings);
     updateDirectoryList();
 
     // 加载窗口设置
-    QSettings settings(m_configFile, QSettings::IniFormat);
-    settings.beginGroup("MainWindow");
-    restoreGeometry(settings.value("geometry").toByteArray());
-    restoreState(settings.value("state").toByteArray());
-    m_gridColumns = settings.value("gridColumns", DEFAULT_GRID_COLUMNS).toInt();
-    m_thumbnailSize = settings.value("thumbnailSize", DEFAULT_THUMBNAIL_SIZE).toInt();
-    m_useFanartMode = settings.value("useFanartMode", false).toBool();
-    m_sortOrder = static_cast<SortOrder>(settings.value("sortOrder", static_cast<int>(SortOrder::NameAsc)).toInt());
-    settings.endGroup();
+    restoreGeometry(m_settings->value("MainWindow/geometry").toByteArray());
+    restoreState(m_settings->value("MainWindow/state").toByteArray());
+    m_gridColumns = m_settings->value("MainWindow/gridColumns", DEFAULT_GRID_COLUMNS).toInt();
+    m_thumbnailSize = m_settings->value("MainWindow/thumbnailSize", DEFAULT_THUMBNAIL_SIZE).toInt();
+    m_useFanartMode = m_settings->value("MainWindow/useFanartMode", false).toBool();
+    m_sortOrder = static_cast<SortOrder>(m_settings->value("MainWindow/sortOrder", static_cast<int>(SortOrder::NameAsc)).toInt());
+    m_hoverScrubEnabled = m_settings->value("MainWindow/hoverScrub", false).toBool();
+
+    m_hoverScrubButton->setChecked(m_hoverScrubEnabled);
 
     // 根据当前封面模式设置按钮文本
     if (m_useFanartMode) {
@@ -526,12 +871,9 @@ void MainWindow::loadSettings()
     // 加载后调整网格列数
     adjustGridColumns();
 
-    // 如果加载了目录，则自动开始扫描以加载视频和封面
-    // 使用 QTimer::singleShot 将扫描操作推迟到事件循环空闲时执行，
-    // 避免阻塞 MainWindow 的构造和显示过程。
-    if (!m_library->directories().isEmpty()) {
-         QTimer::singleShot(0, this, &MainWindow::onScanLibrary);
-    }
+    // 先在后台读取上次的媒体库快照立即显示网格，显示后再开始扫描（onSnapshotLoaded），
+    // 不阻塞 MainWindow 的构造和显示过程
+    m_library->loadSnapshot();
 }
 
 void MainWindow::onToggleCoverMode()
@@ -546,39 +888,43 @@ void MainWindow::onToggleCoverMode()
         m_toggleCoverButton->setText(tr("使用背景"));
     }
 
-    // 更新所有当前存在的视频小部件的封面模式
-    for (const QString& dir : m_tabVideoWidgets.keys()) {
-        for (VideoWidget *widget : m_tabVideoWidgets.value(dir)) {
-            widget->setUseFanartMode(m_useFanartMode);
-        }
+    // 更新所有标签页的封面模式，视图只重绘可见的单元格
+    for (VideoGridView *view : tabViews()) {
+        view->setUseFanartMode(m_useFanartMode);
     }
 
     // 保存设置
-    QSettings settings(m_configFile, QSettings::IniFormat);
-    settings.beginGroup("MainWindow");
-    settings.setValue("useFanartMode", m_useFanartMode);
-    settings.endGroup();
+    m_settings->setValue("MainWindow/useFanartMode", m_useFanartMode);
+}
+
+void MainWindow::onToggleHoverScrub()
+{
+    m_hoverScrubEnabled = !m_hoverScrubEnabled;
+    m_hoverScrubButton->setChecked(m_hoverScrubEnabled);
+
+    // 更新所有标签页
+    for (VideoGridView *view : tabViews()) {
+        view->setHoverScrubEnabled(m_hoverScrubEnabled);
+    }
+
+    // 保存设置
+    m_settings->setValue("MainWindow/hoverScrub", m_hoverScrubEnabled);
 }
 
 void MainWindow::onIncreaseThumbnailSize()
 {
     m_thumbnailSize += 10;
 
-    // 更新所有当前存在的视频小部件的尺寸
-    for (const QString& dir : m_tabVideoWidgets.keys()) {
-        for (VideoWidget *widget : m_tabVideoWidgets.value(dir)) {
-            widget->setThumbnailSize(m_thumbnailSize);
-        }
+    // 更新所有标签页的缩略图尺寸
+    for (VideoGridView *view : tabViews()) {
+        view->setThumbnailSize(m_thumbnailSize);
     }
 
     // 调整当前标签页的网格列数
     adjustGridColumns();
 
     // 保存设置
-    QSettings settings(m_configFile, QSettings::IniFormat);
-    settings.beginGroup("MainWindow");
-    settings.setValue("thumbnailSize", m_thumbnailSize);
-    settings.endGroup();
+    m_settings->setValue("MainWindow/thumbnailSize", m_thumbnailSize);
 }
 
 void MainWindow::onDecreaseThumbnailSize()
@@ -586,127 +932,27 @@ void MainWindow::onDecreaseThumbnailSize()
     if (m_thumbnailSize > 10) {
         m_thumbnailSize -= 10;
 
-        // 更新所有当前存在的视频小部件的尺寸
-        for (const QString& dir : m_tabVideoWidgets.keys()) {
-            for (VideoWidget *widget : m_tabVideoWidgets.value(dir)) {
-                widget->setThumbnailSize(m_thumbnailSize);
-            }
+        // 更新所有标签页的缩略图尺寸
+        for (VideoGridView *view : tabViews()) {
+            view->setThumbnailSize(m_thumbnailSize);
         }
 
         // 调整当前标签页的网格列数
         adjustGridColumns();
 
         // 保存设置
-        QSettings settings(m_configFile, QSettings::IniFormat);
-        settings.beginGroup("MainWindow");
-        settings.setValue("thumbnailSize", m_thumbnailSize);
-        settings.endGroup();
+        m_settings->setValue("MainWindow/thumbnailSize", m_thumbnailSize);
     }
 }
 
 void MainWindow::adjustGridColumns()
 {
-    QWidget* currentTabWidget = m_tabWidget->currentWidget();
-    if (!currentTabWidget) return;
-
-    QScrollArea* scrollArea = currentTabWidget->findChild<QScrollArea*>();
-    if (!scrollArea) return;
-
-    QString dir = m_tabContents.key(currentTabWidget);
-    if (dir.isEmpty() || !m_tabGridLayouts.contains(dir)) return;
-
-    QGridLayout* gridLayout = m_tabGridLayouts.value(dir);
-
-    // 获取滚动区域的宽度
-    int availableWidth = scrollArea->viewport()->width();
-
-    // 每个缩略图需要的宽度（包括间距和边距）
-    int itemWidth = m_thumbnailSize + gridLayout->spacing() + 20; // 增加额外的边距空间
-
-    // 计算可容纳的列数
-    int newColumns = std::max(1, availableWidth / itemWidth);
-
-    // 保存列数设置
-    QSettings settings(m_configFile, QSettings::IniFormat);
-    settings.beginGroup("MainWindow");
-    settings.setValue("gridColumns", newColumns);
-    settings.endGroup();
-
-    // 强制重新布局当前标签页
-    reLayoutVideosInTab(currentTabWidget);
-}
-
-// 计算给定标签页当前的列数
-int MainWindow::calculateColumnsForTab(QWidget* tabContentWidget)
-{
-    if (!tabContentWidget) return DEFAULT_GRID_COLUMNS;
+    // 视图根据自身宽度计算列数（只做算术，不重新布局单元格），
+    // 这里只记录当前列数，退出时随其他设置一起保存
+    VideoGridView* view = currentTabView();
+    if (!view) return;
 
-    QScrollArea* scrollArea = tabContentWidget->findChild<QScrollArea*>();
-    QString dir = m_tabContents.key(tabContentWidget);
-    if (!scrollArea || dir.isEmpty() || !m_tabGridLayouts.contains(dir)) return DEFAULT_GRID_COLUMNS;
-
-    QGridLayout* gridLayout = m_tabGridLayouts.value(dir);
-    int availableWidth = scrollArea->viewport()->width();
-    // 每个缩略图需要的宽度（包括间距和边距）
-    int itemWidth = m_thumbnailSize + gridLayout->spacing() + 20; // 增加额外的边距空间
-    return std::max(1, availableWidth / itemWidth);
-}
-
-void MainWindow::reLayoutVideosInTab(QWidget* tabContentWidget)
-{
-    if (!tabContentWidget) return;
-
-    QString dir = m_tabContents.key(tabContentWidget);
-    if (dir.isEmpty() || !m_tabGridLayouts.contains(dir) || !m_tabVideoWidgets.contains(dir)) return;
-
-    QGridLayout* gridLayout = m_tabGridLayouts.value(dir);
-    QList<VideoWidget*>& videoWidgets = m_tabVideoWidgets[dir];
-
-    // 如果没有视频，直接返回
-    if (videoWidgets.isEmpty()) {
-        return;
-    }
-
-    // 暂时从布局中移除所有小部件
-    for (VideoWidget *widget : videoWidgets) {
-        gridLayout->removeWidget(widget);
-        widget->hide(); // 隐藏以避免闪烁
-    }
-
-    // 根据新的列数重新布局
-    int currentGridColumns = calculateColumnsForTab(tabContentWidget);
-    for (int i = 0; i < videoWidgets.size(); ++i) {
-        int row = i / currentGridColumns;
-        int col = i % currentGridColumns;
-        gridLayout->addWidget(videoWidgets[i], row, col);
-        videoWidgets[i]->show();
-    }
-    gridLayout->update(); // 确保布局更新
-}
-
-void MainWindow::reLayoutVideos()
-{
-    // 重新布局当前标签页
-    QWidget* currentTabWidget = m_tabWidget->currentWidget();
-    if (currentTabWidget) {
-        reLayoutVideosInTab(currentTabWidget);
-    }
-}
-
-void MainWindow::resizeEvent(QResizeEvent *event)
-{
-    QMainWindow::resizeEvent(event);
-
-    // 窗口大小变化时调整网格列数
-    adjustGridColumns();
-
-    sortVideos();
-
-    // 保存设置
-    QSettings settings(m_configFile, QSettings::IniFormat);
-    settings.beginGroup("MainWindow");
-    settings.setValue("geometry", saveGeometry());
-    settings.endGroup();
+    m_gridColumns = view->columnCount();
 }
 
 void MainWindow::onToggleSortOrder()
@@ -740,10 +986,7 @@ void MainWindow::onToggleSortOrder()
     sortVideos();
 
     // 保存设置
-    QSettings settings(m_configFile, QSettings::IniFormat);
-    settings.beginGroup("MainWindow");
-    settings.setValue("sortOrder", static_cast<int>(m_sortOrder));
-    settings.endGroup();
+    m_settings->setValue("MainWindow/sortOrder", static_cast<int>(m_sortOrder));
 }
 
 void MainWindow::updateSortButtonText()
@@ -773,366 +1016,278 @@ void MainWindow::updateSortButtonText()
 
 void MainWindow::sortVideos()
 {
-    // 对当前活动的标签页执行排序
-    QWidget* currentTabWidget = m_tabWidget->currentWidget();
-    if (!currentTabWidget) return;
-
-    QString dir = m_tabContents.key(currentTabWidget);
-    if (dir.isEmpty() || !m_tabVideoWidgets.contains(dir)) return;
-
-    QList<VideoWidget*>& videoWidgets = m_tabVideoWidgets[dir];
-
-    // 如果没有视频，直接返回
-    if (videoWidgets.isEmpty()) {
-        return;
-    }
-
-    // 根据当前排序方式对视频小部件进行排序
-    std::sort(videoWidgets.begin(), videoWidgets.end(),
-        [this](const VideoWidget* a, const VideoWidget* b) -> bool {
-            switch (m_sortOrder) {
-                case SortOrder::NameAsc:
-                    return a->video()->fileName().toLower() < b->video()->fileName().toLower();
-                case SortOrder::NameDesc:
-                    return a->video()->fileName().toLower() > b->video()->fileName().toLower();
-                case SortOrder::CreationTimeAsc:
-                    return a->video()->creationTime() < b->video()->creationTime();
-                case SortOrder::CreationTimeDesc:
-                    return a->video()->creationTime() > b->video()->creationTime();
-                case SortOrder::ModifiedTimeAsc:
-                    return a->video()->modifiedTime() < b->video()->modifiedTime();
-                case SortOrder::ModifiedTimeDesc:
-                    return a->video()->modifiedTime() > b->video()->modifiedTime();
-                default:
-                    return a->video()->fileName().toLower() < b->video()->fileName().toLower();
-            }
+    // 对已创建视图的标签页排序：各模型缓存了每种排序键的排列，
+    // 切换升降序只需反转，顺序未变化时不会通知视图；其他标签页显示时再排序
+    for (const LibraryTab &tab : qAsConst(m_tabs)) {
+        if (tab.model) {
+            tab.model->sortBy(m_sortOrder);
         }
-    );
-
-    // 重新布局当前标签页
-    reLayoutVideosInTab(currentTabWidget);
+    }
 }
 
 void MainWindow::onSearchTextChanged(const QString &text)
 {
-    // 保存搜索文本
+    // 保存搜索文本，停止输入后再过滤
     m_searchText = text.trimmed();
-
-    // 根据搜索条件过滤视频
-    filterVideos();
+    m_searchTimer->start();
 }
 
 void MainWindow::filterVideos()
 {
-    // 这个函数的逻辑需要重写以适应标签页结构
-    // 简单的实现是刷新整个显示，让 refreshVideoDisplay 处理过滤
-    refreshVideoDisplay();
-}
+    m_searchTimer->stop();
 
-void MainWindow::reLayoutFilteredVideos()
-{
-    // 此函数不再需要，过滤后的布局由 refreshVideoDisplay 或 reLayoutVideosInTab 处理
-    // 将在 refreshVideoDisplay 中重新实现
+    // 先在全库的索引中搜索（番号、子串、近似匹配），
+    // 再更新各模型的可见行，模型内部只通知变化的行
+    m_searchQuery = VideoSearchQuery(m_searchText);
+    m_searchMatches.clear();
+    m_library->searchVideos(m_searchQuery, &m_searchMatches);
+
+    // 未创建视图的标签页只统计匹配数
+    for (LibraryTab &tab : m_tabs) {
+        tab.matchCount = 0;
+    }
+    for (const SearchMatch &match : qAsConst(m_searchMatches)) {
+        auto it = m_tabs.find(m_directoryOfVideo.value(match.video->id()));
+        if (it != m_tabs.end()) {
+            ++it->matchCount;
+        }
+    }
+    for (const LibraryTab &tab : qAsConst(m_tabs)) {
+        if (tab.model) {
+            tab.model->setSearch(m_searchQuery, m_searchMatches);
+        }
+    }
+
+    updateFacetToolTip();
+    updateTabTitles();
 }
 
-void MainWindow::refreshVideoDisplay()
+void MainWindow::updateFacetToolTip()
 {
-    // 获取当前活动的标签页索引，以便后续恢复
-    int currentTabIndex = m_tabWidget->currentIndex();
-
-    // 移除所有现有标签页（但不删除内容）
-    while(m_tabWidget->count() > 0) {
-        m_tabWidget->removeTab(0);
+    // 搜索框提示中列出当前结果里最常见的演员、类别和片商，可照此输入过滤条件
+    static const struct {
+        FacetField field;
+        const char *key;
+    } facets[] = {
+        { FacetField::Actor, "actor" },
+        { FacetField::Genre, "genre" },
+        { FacetField::Studio, "studio" }
+    };
+
+    QStringList lines;
+    for (const auto &facet : facets) {
+        QStringList values;
+        for (const FacetCount &count : m_library->facetCounts(facet.field, 5)) {
+            values.append(QString("%1 (%2)").arg(count.value).arg(count.count));
+        }
+        if (!values.isEmpty()) {
+            lines.append(QString("%1: %2").arg(QLatin1String(facet.key), values.join(QStringLiteral("，"))));
+        }
     }
-
-    // 清空所有标签页的视频小部件列表，但不删除布局等
-    for (auto it = m_tabVideoWidgets.begin(); it != m_tabVideoWidgets.end(); ++it) {
-        qDeleteAll(it.value());
-        it.value().clear();
+    if (lines.isEmpty()) {
+        m_searchEdit->setToolTip(QString());
+    } else {
+        m_searchEdit->setToolTip(lines.join(QLatin1Char('\n')));
     }
+}
 
-    // 获取按目录分组的数据
-    const auto& videosByDir = m_library->videosByDirectory();
+void MainWindow::updateTabTitles()
+{
     int totalVideoCount = 0;
     int filteredVideoCount = 0;
 
-    // 遍历库中的目录
-    QStringList sortedDirs = videosByDir.keys();
-    std::sort(sortedDirs.begin(), sortedDirs.end()); // 按目录名排序标签页
-
-    for (const QString& dir : sortedDirs) {
-        const auto& videosInDir = videosByDir.value(dir);
-        totalVideoCount += videosInDir.size();
-
-        QWidget* tabContentWidget = nullptr;
-        QGridLayout* gridLayout = nullptr;
-        QList<VideoWidget*>* videoWidgetsPtr = nullptr;
-
-        // 检查或创建标签页及其内容
-        if (!m_tabContents.contains(dir)) {
-            // 创建新的标签页内容
-            tabContentWidget = new QWidget(m_tabWidget);
-            QVBoxLayout* tabLayout = new QVBoxLayout(tabContentWidget);
-            tabLayout->setContentsMargins(0, 0, 0, 0);
-
-            QScrollArea* scrollArea = new QScrollArea(tabContentWidget);
-            scrollArea->setWidgetResizable(true);
-            scrollArea->setFrameShape(QFrame::NoFrame);
-            scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-            scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-            scrollArea->setStyleSheet("background-color: #2D2D30;");
-
-            QWidget* scrollContent = new QWidget(scrollArea);
-            gridLayout = new QGridLayout(scrollContent);
-            gridLayout->setContentsMargins(10, 10, 10, 10);
-            gridLayout->setSpacing(10);
-            scrollArea->setWidget(scrollContent);
-
-            tabLayout->addWidget(scrollArea);
-
-            m_tabContents.insert(dir, tabContentWidget);
-            m_tabGridLayouts.insert(dir, gridLayout);
-            m_tabVideoWidgets.insert(dir, QList<VideoWidget*>());
-        } else {
-            tabContentWidget = m_tabContents.value(dir);
-            gridLayout = m_tabGridLayouts.value(dir);
+    int allTabIndex = -1;
+    for (int i = 0; i < m_tabWidget->count(); ++i) {
+        if (m_tabWidget->widget(i) == m_allPage) {
+            allTabIndex = i;
+            continue;
         }
+        QString directory = m_directoryOfPage.value(m_tabWidget->widget(i));
+        auto it = m_tabs.constFind(directory);
+        if (it == m_tabs.constEnd()) continue;
 
-        videoWidgetsPtr = &m_tabVideoWidgets[dir];
-
-        // 填充视频小部件 (应用过滤)
-        QList<VideoWidget*> currentTabFilteredWidgets;
-        for (const auto& video : videosInDir) {
-            // 检查是否匹配搜索条件
-            if (m_searchText.isEmpty() || video->fileName().contains(m_searchText, Qt::CaseInsensitive)) {
-                VideoWidget *widget = new VideoWidget(video, m_thumbnailSize, m_useFanartMode, tabContentWidget);
-                videoWidgetsPtr->append(widget); // 添加到总列表
-                currentTabFilteredWidgets.append(widget); // 添加到当前过滤后列表
-                filteredVideoCount++;
-            }
-        }
+        const int count = visibleCount(it.value());
+        totalVideoCount += it->videos.size();
+        filteredVideoCount += count;
 
-        // 如果此标签页有内容，则添加到 TabWidget 并进行排序和布局
-        if (!currentTabFilteredWidgets.isEmpty() || m_searchText.isEmpty()) {
-            // 获取标签文本
-            QString tabLabel = QDir(dir).dirName();
-            if (tabLabel.isEmpty()) tabLabel = dir;
-
-            // 添加标签页，在标签中显示视频数量
-            m_tabWidget->addTab(tabContentWidget, QString("%1 (%2)").arg(tabLabel).arg(currentTabFilteredWidgets.size()));
-            m_tabWidget->setTabToolTip(m_tabWidget->indexOf(tabContentWidget), dir);
-
-            // 对当前标签页的视频进行排序
-            std::sort(currentTabFilteredWidgets.begin(), currentTabFilteredWidgets.end(),
-                [this](const VideoWidget* a, const VideoWidget* b) -> bool {
-                    switch (m_sortOrder) {
-                        case SortOrder::NameAsc: return a->video()->fileName().toLower() < b->video()->fileName().toLower();
-                        case SortOrder::NameDesc: return a->video()->fileName().toLower() > b->video()->fileName().toLower();
-                        case SortOrder::CreationTimeAsc: return a->video()->creationTime() < b->video()->creationTime();
-                        case SortOrder::CreationTimeDesc: return a->video()->creationTime() > b->video()->creationTime();
-                        case SortOrder::ModifiedTimeAsc: return a->video()->modifiedTime() < b->video()->modifiedTime();
-                        case SortOrder::ModifiedTimeDesc: return a->video()->modifiedTime() > b->video()->modifiedTime();
-                        default: return a->video()->fileName().toLower() < b->video()->fileName().toLower();
-                    }
-                });
-
-            // 布局当前标签页的视频
-            int cols = calculateColumnsForTab(tabContentWidget);
-            for (int i = 0; i < currentTabFilteredWidgets.size(); ++i) {
-                int row = i / cols;
-                int col = i % cols;
-                gridLayout->addWidget(currentTabFilteredWidgets[i], row, col);
-                currentTabFilteredWidgets[i]->show();
-            }
-        }
+        // 获取标签文本，在标签中显示视频数量
+        QString tabLabel = QDir(directory).dirName();
+        if (tabLabel.isEmpty()) tabLabel = directory;
+        m_tabWidget->setTabText(i, QString("%1 (%2)").arg(tabLabel).arg(count));
+
+        // 搜索时隐藏没有匹配结果的标签页
+        m_tabWidget->setTabVisible(i, count > 0 || m_searchText.isEmpty());
+    }
+
+    // “全部”标签页显示所有目录的可见视频数之和
+    if (allTabIndex != -1) {
+        m_tabWidget->setTabText(allTabIndex, tr("全部 (%1)").arg(filteredVideoCount));
+        m_tabWidget->setTabVisible(allTabIndex, filteredVideoCount > 0 || m_searchText.isEmpty());
     }
 
     // 更新状态栏
+    QString statusText;
     if (m_searchText.isEmpty()) {
-        m_statusLabel->setText(tr("就绪 - %1 个视频").arg(totalVideoCount));
+        statusText = tr("就绪 - %1 个视频").arg(totalVideoCount);
     } else {
-        m_statusLabel->setText(tr("已过滤 - %1/%2 个视频").arg(filteredVideoCount).arg(totalVideoCount));
+        statusText = tr("已过滤 - %1/%2 个视频").arg(filteredVideoCount).arg(totalVideoCount);
     }
-
-    // 恢复之前活动的标签页（如果它仍然存在）
-    if (currentTabIndex != -1 && currentTabIndex < m_tabWidget->count()) {
-        m_tabWidget->setCurrentIndex(currentTabIndex);
-    } else if (m_tabWidget->count() > 0) {
-        m_tabWidget->setCurrentIndex(0);
+    int failureCount = m_library->posterFailureCount();
+    if (failureCount > 0) {
+        statusText += tr("，%1 个封面提取失败").arg(failureCount);
     }
-
-    // 调整当前标签页的网格
-    adjustGridColumns();
+    VideoGridView* currentView = currentTabView();
+    if (currentView && currentView->selectedCount() > 0) {
+        statusText += tr("，已选择 %1 个").arg(currentView->selectedCount());
+    }
+    m_statusLabel->setText(statusText);
 }
 
-void MainWindow::onVideoPosterReady(std::shared_ptr<VideoItem> video)
+void MainWindow::onVideoPosterReady(quint32 videoId)
 {
-    // 遍历所有标签页查找对应的 VideoWidget
-    for (const QString& dir : m_tabVideoWidgets.keys()) {
-        for (VideoWidget *widget : m_tabVideoWidgets.value(dir)) {
-            if (widget->video() == video) {
-                widget->updateThumbnail();
-                return;
-            }
+    // 按视频 ID 直接找到所在标签页，只重绘对应的单元格；
+    // 视图尚未创建时只丢弃缓存的旧封面（“全部”视图经由目录模型收到通知）
+    LibraryTab tab = m_tabs.value(m_directoryOfVideo.value(videoId));
+    if (tab.view) {
+        tab.view->refreshVideo(videoId);
+    } else {
+        VideoDelegate::invalidate(videoId, m_thumbnailSize);
+        if (tab.model) {
+            tab.model->videoChanged(videoId);
         }
     }
 }
 
-// 添加设置封面模式的实现
-void VideoWidget::setUseFanartMode(bool useFanart)
+void MainWindow::onVideoSpriteSheetReady(quint32 videoId)
 {
-    m_useFanartMode = useFanart;
-    update(); // 触发重绘以显示正确的封面
+    // 只有正在预览该视频的视图会重新加载雪碧图
+    for (VideoGridView *view : tabViews()) {
+        view->reloadSpriteSheet(videoId);
+    }
 }
 
-// ------ VideoWidget 实现 ------
-
-VideoWidget::VideoWidget(std::shared_ptr<VideoItem> video, int thumbnailSize, bool useFanart, QWidget *parent)
-    : QWidget(parent),
-      m_video(video),
-      m_thumbnailSize(thumbnailSize),
-      m_hover(false),
-      m_useFanartMode(useFanart), // 使用传入的值初始化
-      m_selected(false)
+void MainWindow::updateConcurrencyStatus()
 {
-    // 设置大小策略和最小尺寸
-    setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-    // 调整大小以包含边框和标签
-    setFixedSize(m_thumbnailSize + 10, m_thumbnailSize + 30);
-
-    // 创建标题标签
-    m_titleLabel = new QLabel(this);
-    m_titleLabel->setText(m_video->fileName());
-    m_titleLabel->setAlignment(Qt::AlignCenter);
-    m_titleLabel->setWordWrap(true);
-    // 调整标题位置和大小
-    m_titleLabel->setGeometry(5, m_thumbnailSize + 5, m_thumbnailSize, 25);
-    m_titleLabel->setStyleSheet("color: #E1E1E1; background-color: transparent;");
-
-    // 启用鼠标追踪以便接收鼠标移入/移出事件
-    setMouseTracking(true);
-
-    // 设置工具提示
-    setToolTip(m_video->fileName());
+    ConcurrencyController *controller = ConcurrencyController::instance();
+    m_concurrencyLabel->setText(controller->statusText());
+    m_concurrencyLabel->setToolTip(controller->detailText());
 }
 
-void VideoWidget::setThumbnailSize(int size)
-{
-    m_thumbnailSize = size;
-    setFixedSize(m_thumbnailSize + 10, m_thumbnailSize + 30); // 考虑边框和标签的高度
-    update(); // 重新绘制以应用新的尺寸
-}
+// 封面相似的最大汉明距离（64 位 dHash）
+const int SIMILAR_COVER_DISTANCE = 6;
 
-void VideoWidget::mousePressEvent(QMouseEvent *event)
+void MainWindow::onFindDuplicates(bool verifyFull)
 {
-    if (event->button() == Qt::LeftButton) {
-        // 改为设置选中状态而不是播放视频
-        setSelected(true);
-
-        // 取消选择其他视频小部件（遍历父窗口的所有VideoWidget）
-        if (parent()) {
-            QList<VideoWidget*> siblings = parent()->findChildren<VideoWidget*>();
-            for (VideoWidget* widget : siblings) {
-                if (widget != this && widget->isSelected()) {
-                    widget->setSelected(false);
-                }
-            }
-        }
+    QVector<quint32> ids;
+    ids.reserve(m_library->videos().size());
+    for (const auto &video : m_library->videos()) {
+        ids.append(video->id());
     }
-    QWidget::mousePressEvent(event);
-}
-
-void VideoWidget::mouseDoubleClickEvent(QMouseEvent *event)
-{
-    if (event->button() == Qt::LeftButton) {
-        // 双击时播放视频
-        m_video->play();
+    if (ids.isEmpty()) {
+        return;
     }
-    QWidget::mouseDoubleClickEvent(event);
+
+    m_duplicateButton->setEnabled(false);
+    m_statusLabel->setText(tr("查找重复视频..."));
+    m_duplicateFinder->start(ids, verifyFull);
 }
 
-void VideoWidget::paintEvent(QPaintEvent *event)
+void MainWindow::onFindSimilarCovers()
 {
-    Q_UNUSED(event);
-
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform);
-
-    // 绘制背景
-    QStyleOption opt;
-    opt.initFrom(this);
-    style()->drawPrimitive(QStyle::PE_Widget, &opt, &painter, this);
-
-    // 绘制缩略图背景 - 在深色主题中添加浅灰色背景
-    painter.fillRect(0, 0, m_thumbnailSize, m_thumbnailSize, QColor(50, 50, 55));
-
-    // 根据当前模式选择要显示的图片
-    QPixmap image;
-    if (m_useFanartMode) {
-        // 使用背景图
-        image = m_video->fanartImage().scaled(m_thumbnailSize, m_thumbnailSize,
-                                            Qt::KeepAspectRatio,
-                                            Qt::SmoothTransformation);
-    } else {
-        // 使用海报图
-        image = m_video->posterImage().scaled(m_thumbnailSize, m_thumbnailSize,
-                                            Qt::KeepAspectRatio,
-                                            Qt::SmoothTransformation);
-    }
-
-    int x = (m_thumbnailSize - image.width()) / 2;
-    int y = (m_thumbnailSize - image.height()) / 2;
-
-    // 绘制边框
-    if (m_hover) {
-        // 在深色主题中使用亮蓝色边框
-        painter.setPen(QPen(QColor(0, 120, 215), 2));
-        painter.drawRect(x-1, y-1, image.width()+2, image.height()+2);
-
-        // 绘制播放图标
-        QPixmap playIcon(":/icons/play.png");
-        int iconSize = 48;
-        QPixmap scaledIcon = playIcon.scaled(iconSize, iconSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        int iconX = (width() - iconSize) / 2;
-        int iconY = (m_thumbnailSize - iconSize) / 2;
-        painter.drawPixmap(iconX, iconY, scaledIcon);
+    QVector<quint32> ids;
+    ids.reserve(m_library->videos().size());
+    for (const auto &video : m_library->videos()) {
+        ids.append(video->id());
     }
-    // 选中状态时绘制高亮边框
-    else if (m_selected) {
-        // 使用高亮橙色边框表示选中状态
-        painter.setPen(QPen(QColor(255, 165, 0), 3));
-        painter.drawRect(x-2, y-2, image.width()+4, image.height()+4);
+    if (ids.isEmpty()) {
+        return;
     }
 
-    painter.drawPixmap(x, y, image);
+    m_duplicateButton->setEnabled(false);
+    m_statusLabel->setText(tr("查找封面相似的视频..."));
+    m_duplicateFinder->startSimilarCovers(ids, SIMILAR_COVER_DISTANCE);
 }
 
-void VideoWidget::enterEvent(QEnterEvent *event)
+void MainWindow::onDuplicateProgress(int done, int total)
 {
-    Q_UNUSED(event);
-    m_hover = true;
-    update();
+    m_statusLabel->setText(tr("查找重复视频：已读取 %1/%2 个文件").arg(done).arg(total));
 }
 
-void VideoWidget::leaveEvent(QEvent *event)
+void MainWindow::onDuplicatesFound(const QVector<DuplicateGroup> &groups)
 {
-    Q_UNUSED(event);
-    m_hover = false;
-    update();
+    m_duplicateButton->setEnabled(true);
+
+    qint64 wasted = 0;
+    bool allVerified = true;
+    for (const DuplicateGroup &group : groups) {
+        // 封面相似的组内容不同，不确定保留哪一个，不计入可释放空间
+        if (!group.similarCover) {
+            wasted += group.fileSize * (group.videoIds.size() - 1);
+            allVerified = allVerified && group.verified;
+        }
+    }
+    const QLocale locale;
+    m_statusLabel->setText(tr("找到 %1 组重复视频，可释放 %2")
+                           .arg(groups.size()).arg(locale.formattedDataSize(wasted)));
+    if (groups.isEmpty()) {
+        QMessageBox::information(this, tr("查找重复"), tr("没有找到重复的视频。"));
+        return;
+    }
+
+    // 每组一个顶层项，展开后列出各文件的完整路径
+    QDialog *dialog = new QDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowTitle(tr("重复视频（%1 组，可释放 %2）")
+                           .arg(groups.size()).arg(locale.formattedDataSize(wasted)));
+    dialog->resize(800, 500);
+
+    QTreeWidget *tree = new QTreeWidget(dialog);
+    tree->setHeaderHidden(true);
+    VideoCatalog *catalog = VideoCatalog::instance();
+    for (const DuplicateGroup &group : groups) {
+        QTreeWidgetItem *groupItem = new QTreeWidgetItem(tree);
+        if (group.similarCover) {
+            groupItem->setText(0, tr("%1 个文件（封面相似）").arg(group.videoIds.size()));
+        } else {
+            groupItem->setText(0, tr("%1 个文件，每个 %2（%3）")
+                                  .arg(group.videoIds.size())
+                                  .arg(locale.formattedDataSize(group.fileSize))
+                                  .arg(group.verified ? tr("内容一致") : tr("抽样一致")));
+        }
+        for (quint32 id : group.videoIds) {
+            QTreeWidgetItem *fileItem = new QTreeWidgetItem(groupItem);
+            QString text = QDir::toNativeSeparators(catalog->filePath(id));
+            if (group.similarCover) {
+                // 不同编码的大小不同，列出来便于决定保留哪一个
+                text += QString("  (%1)").arg(locale.formattedDataSize(catalog->fileSize(id)));
+            }
+            fileItem->setText(0, text);
+        }
+    }
+    tree->expandAll();
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, dialog);
+    connect(buttons, &QDialogButtonBox::rejected, dialog, &QDialog::close);
+    if (!allVerified) {
+        // 抽样一致的文件按需再读取全部内容确认
+        QPushButton *verifyButton = buttons->addButton(tr("完整校验"), QDialogButtonBox::ActionRole);
+        connect(verifyButton, &QPushButton::clicked, this, [this, dialog]() {
+            dialog->close();
+            onFindDuplicates(true);
+        });
+    }
+
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+    layout->addWidget(tree);
+    layout->addWidget(buttons);
+    dialog->show();
 }
 
-// 新增：更新缩略图方法实现
-void VideoWidget::updateThumbnail()
+void MainWindow::onVideoPosterFailed(quint32 videoId)
 {
-    // 强制重新加载图片
-    if (m_video) {
-        // 将图片加载状态重置，强制重新加载
-        m_video->posterImage(); // 这会触发重新加载
-        m_video->fanartImage(); // 这会触发重新加载
-        qDebug() << "更新视频缩略图:" << m_video->fileName();
+    // 按视频 ID 直接找到所在标签页，重绘对应的单元格（显示失败标记和提示）
+    VideoListModel *model = m_tabs.value(m_directoryOfVideo.value(videoId)).model;
+    if (model) {
+        model->videoChanged(videoId);
     }
-
-    // 触发重绘
-    update();
-}
\ No newline at end of file
+}
@@ -0,0 +1,309 @@
+#include "mergedvideomodel.h"
+
+// 每隔多少行记录一次各源的游标
+static const int MERGE_CHECKPOINT_INTERVAL = 256;
+
+MergedVideoModel::MergedVideoModel(QObject *parent)
+    : AbstractVideoModel(parent),
+      m_rowCount(0),
+      m_sortOrder(SortOrder::NameAsc),
+      m_resetting(false),
+      m_checkpointCount(0),
+      m_cursorRow(-1)
+{
+}
+
+void MergedVideoModel::setSources(const QVector<VideoListModel*> &sources)
+{
+    beginResetModel();
+    for (VideoListModel *source : qAsConst(m_sources)) {
+        disconnect(source, nullptr, this, nullptr);
+    }
+    m_sources = sources;
+
+    // 源的插入和移除换算为合并后的行号转发；重置和重新排序转为本模型的重置
+    for (int i = 0; i < m_sources.size(); ++i) {
+        VideoListModel *source = m_sources.at(i);
+        connect(source, &QAbstractItemModel::rowsInserted, this,
+                [this, i](const QModelIndex &, int first, int last) {
+            sourceRowsInserted(i, first, last);
+        });
+        connect(source, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                [this, i](const QModelIndex &, int first, int last) {
+            sourceRowsAboutToBeRemoved(i, first, last);
+        });
+        connect(source, &QAbstractItemModel::rowsRemoved, this, [this, i]() {
+            sourceRowsRemoved(i);
+        });
+        connect(source, &QAbstractItemModel::modelAboutToBeReset, this, &MergedVideoModel::sourceAboutToChange);
+        connect(source, &QAbstractItemModel::layoutAboutToBeChanged, this, &MergedVideoModel::sourceAboutToChange);
+        connect(source, &QAbstractItemModel::modelReset, this, &MergedVideoModel::sourceChanged);
+        connect(source, &QAbstractItemModel::layoutChanged, this, &MergedVideoModel::sourceChanged);
+
+        // 单元格内容变化（封面、失败标记）只通知对应的一行
+        connect(source, &QAbstractItemModel::dataChanged, this,
+                [this, i](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+            if (m_resetting) {
+                return;
+            }
+            for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                QModelIndex changed = index(mergedRow(i, row));
+                emit dataChanged(changed, changed);
+            }
+        });
+    }
+
+    invalidate();
+    endResetModel();
+}
+
+QVector<VideoListModel*> MergedVideoModel::sources() const
+{
+    return m_sources;
+}
+
+int MergedVideoModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rowCount;
+}
+
+QVariant MergedVideoModel::data(const QModelIndex &index, int role) const
+{
+    int source = -1;
+    int sourceRow = -1;
+    if (!index.isValid() || !locate(index.row(), &source, &sourceRow)) {
+        return QVariant();
+    }
+    VideoListModel *model = m_sources.at(source);
+    return model->data(model->index(sourceRow), role);
+}
+
+std::shared_ptr<VideoItem> MergedVideoModel::videoAt(int row) const
+{
+    int source = -1;
+    int sourceRow = -1;
+    if (!locate(row, &source, &sourceRow)) {
+        return nullptr;
+    }
+    return m_sources.at(source)->videoAt(sourceRow);
+}
+
+int MergedVideoModel::rowOf(quint32 videoId) const
+{
+    for (int source = 0; source < m_sources.size(); ++source) {
+        int sourceRow = m_sources.at(source)->rowOf(videoId);
+        if (sourceRow >= 0) {
+            return mergedRow(source, sourceRow);
+        }
+    }
+    return -1;
+}
+
+int MergedVideoModel::mergedRow(int source, int sourceRow) const
+{
+    int row = sourceRow;
+    for (int other = 0; other < m_sources.size(); ++other) {
+        if (other != source) {
+            row += countBefore(other, source, sourceRow);
+        }
+    }
+    return row;
+}
+
+bool MergedVideoModel::headLess(int a, int rowA, int b, int rowB) const
+{
+    const VideoListModel *left = m_sources.at(a);
+    const VideoListModel *right = m_sources.at(b);
+
+    // 与源模型一致：先按匹配排名，再按排序键，键相同时按源的顺序
+    int rankA = left->rankAt(rowA);
+    int rankB = right->rankAt(rowB);
+    if (rankA != rankB) {
+        return rankA < rankB;
+    }
+    int result = VideoListModel::compareVideos(*left->itemAt(rowA), *right->itemAt(rowB), m_sortOrder);
+    return result != 0 ? result < 0 : a < b;
+}
+
+int MergedVideoModel::countBefore(int source, int other, int otherRow) const
+{
+    // 源内已有序，满足条件的行构成前缀，二分查找其长度
+    int low = 0;
+    int high = m_counts.at(source);
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (headLess(source, mid, other, otherRow)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int MergedVideoModel::minHead(const QVector<int> &cursor) const
+{
+    // 目录（源）数量很少，直接线性比较各源的头部
+    int best = -1;
+    for (int source = 0; source < m_sources.size(); ++source) {
+        if (cursor.at(source) >= m_counts.at(source)) {
+            continue;
+        }
+        if (best < 0 || headLess(source, cursor.at(source), best, cursor.at(best))) {
+            best = source;
+        }
+    }
+    return best;
+}
+
+int MergedVideoModel::advance(QVector<int> &cursor) const
+{
+    int source = minHead(cursor);
+    if (source >= 0) {
+        ++cursor[source];
+    }
+    return source;
+}
+
+bool MergedVideoModel::locate(int row, int *source, int *sourceRow) const
+{
+    if (row < 0 || row >= m_rowCount) {
+        return false;
+    }
+
+    // 向后跳转或跨过检查点间隔时，从所在区间的检查点重新开始
+    if (m_cursorRow < 0 || row < m_cursorRow || row - m_cursorRow >= MERGE_CHECKPOINT_INTERVAL) {
+        const int k = m_sources.size();
+        const int checkpoint = row / MERGE_CHECKPOINT_INTERVAL;
+        while (m_checkpointCount <= checkpoint) {
+            QVector<int> cursor(m_checkpoints.constEnd() - k, m_checkpoints.constEnd());
+            for (int i = 0; i < MERGE_CHECKPOINT_INTERVAL; ++i) {
+                advance(cursor);
+            }
+            m_checkpoints += cursor;
+            ++m_checkpointCount;
+        }
+        m_cursor = QVector<int>(m_checkpoints.constBegin() + checkpoint * k,
+                                m_checkpoints.constBegin() + (checkpoint + 1) * k);
+        m_cursorRow = checkpoint * MERGE_CHECKPOINT_INTERVAL;
+    }
+
+    while (m_cursorRow < row) {
+        advance(m_cursor);
+        ++m_cursorRow;
+    }
+
+    *source = minHead(m_cursor);
+    if (*source < 0) {
+        return false;
+    }
+    *sourceRow = m_cursor.at(*source);
+    return true;
+}
+
+QVector<int> MergedVideoModel::mergedRows(int source, int first, int last) const
+{
+    // 源内有序，合并后的行号随源行号单调递增
+    QVector<int> rows;
+    rows.reserve(last - first + 1);
+    for (int row = first; row <= last; ++row) {
+        rows.append(mergedRow(source, row));
+    }
+    return rows;
+}
+
+void MergedVideoModel::sourceRowsInserted(int source, int first, int last)
+{
+    if (m_resetting) {
+        return;
+    }
+
+    // 新行已在源中，其他源未变：按插入后的顺序算出新行的位置。
+    // 新行在合并后不一定连续，按升序逐段插入，插入每段时排在它前面的行都已存在
+    m_counts[source] = m_sources.at(source)->rowCount();
+    resetCursor();
+    const QVector<int> rows = mergedRows(source, first, last);
+    for (int start = 0; start < rows.size();) {
+        int end = start + 1;
+        while (end < rows.size() && rows.at(end) == rows.at(end - 1) + 1) {
+            ++end;
+        }
+        beginInsertRows(QModelIndex(), rows.at(start), rows.at(end - 1));
+        m_rowCount += end - start;
+        endInsertRows();
+        start = end;
+    }
+}
+
+void MergedVideoModel::sourceRowsAboutToBeRemoved(int source, int first, int last)
+{
+    if (m_resetting) {
+        return;
+    }
+
+    // 行仍在源中：按当前顺序算出位置，从后往前逐段移除，前面各段的行号不受影响。
+    // 源真正移除后（sourceRowsRemoved）再更新行数和检查点
+    const QVector<int> rows = mergedRows(source, first, last);
+    for (int end = rows.size(); end > 0;) {
+        int start = end - 1;
+        while (start > 0 && rows.at(start - 1) == rows.at(start) - 1) {
+            --start;
+        }
+        beginRemoveRows(QModelIndex(), rows.at(start), rows.at(end - 1));
+        m_rowCount -= end - start;
+        endRemoveRows();
+        end = start;
+    }
+}
+
+void MergedVideoModel::sourceRowsRemoved(int source)
+{
+    if (m_resetting) {
+        return;
+    }
+    m_counts[source] = m_sources.at(source)->rowCount();
+    resetCursor();
+}
+
+void MergedVideoModel::sourceAboutToChange()
+{
+    if (!m_resetting) {
+        m_resetting = true;
+        beginResetModel();
+    }
+}
+
+void MergedVideoModel::sourceChanged()
+{
+    if (m_resetting) {
+        invalidate();
+        m_resetting = false;
+        endResetModel();
+    }
+}
+
+void MergedVideoModel::invalidate()
+{
+    const int k = m_sources.size();
+    m_counts.resize(k);
+    m_rowCount = 0;
+    for (int source = 0; source < k; ++source) {
+        m_counts[source] = m_sources.at(source)->rowCount();
+        m_rowCount += m_counts.at(source);
+    }
+    m_sortOrder = m_sources.isEmpty() ? SortOrder::NameAsc : m_sources.first()->sortOrder();
+    resetCursor();
+}
+
+void MergedVideoModel::resetCursor()
+{
+    // 只保留第 0 个检查点（各源都从头开始），其余按需重建
+    const int k = m_sources.size();
+    m_checkpoints = QVector<int>(k, 0);
+    m_checkpointCount = 1;
+    m_cursor.clear();
+    m_cursorRow = -1;
+}
@@ -0,0 +1,141 @@
+#include "nforeader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QXmlStreamReader>
+
+// 评分统一折算到 10 分制
+static const float RATING_SCALE = 10.0f;
+
+QStringList NfoReader::candidateNames(const QString &videoFileName)
+{
+    return { QFileInfo(videoFileName).completeBaseName() + ".nfo", QStringLiteral("movie.nfo") };
+}
+
+// 读取 <actor> 元素中的演员名：Kodi 格式为 <actor><name>…</name>…</actor>
+static QString readActorName(QXmlStreamReader &xml)
+{
+    QString name;
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("name")) {
+            name = xml.readElementText().trimmed();
+        } else {
+            xml.skipCurrentElement();
+        }
+    }
+    return name;
+}
+
+// 读取 <ratings>：取 default="true" 的一项，没有时取第一项，按 max 属性折算到 10 分制
+static float readRatings(QXmlStreamReader &xml)
+{
+    float rating = 0;
+    bool haveDefault = false;
+    while (xml.readNextStartElement()) {
+        if (xml.name() != QLatin1String("rating")) {
+            xml.skipCurrentElement();
+            continue;
+        }
+
+        const QXmlStreamAttributes attributes = xml.attributes();
+        const bool isDefault = attributes.value(QLatin1String("default")) == QLatin1String("true");
+        bool ok = false;
+        float max = attributes.value(QLatin1String("max")).toFloat(&ok);
+        if (!ok || max <= 0) {
+            max = RATING_SCALE;
+        }
+
+        float value = 0;
+        while (xml.readNextStartElement()) {
+            if (xml.name() == QLatin1String("value")) {
+                value = xml.readElementText().toFloat(&ok);
+                if (!ok) {
+                    value = 0;
+                }
+            } else {
+                xml.skipCurrentElement();
+            }
+        }
+
+        if (value > 0 && !haveDefault && (isDefault || rating == 0)) {
+            rating = value * RATING_SCALE / max;
+            haveDefault = isDefault;
+        }
+    }
+    return rating;
+}
+
+bool NfoReader::read(const QString &nfoPath, VideoMetadata *metadata, QString *errorReason)
+{
+    QFile file(nfoPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorReason) *errorReason = file.errorString();
+        return false;
+    }
+
+    QXmlStreamReader xml(&file);
+    if (!xml.readNextStartElement() || xml.name() != QLatin1String("movie")) {
+        if (errorReason) *errorReason = xml.hasError() ? xml.errorString() : QObject::tr("不是电影 NFO");
+        return false;
+    }
+
+    VideoMetadata result;
+    QString releaseText;
+    int year = 0;
+    while (xml.readNextStartElement()) {
+        const QStringView name = xml.name();
+        if (name == QLatin1String("title")) {
+            result.title = xml.readElementText().trimmed();
+        } else if (name == QLatin1String("studio") || name == QLatin1String("maker")) {
+            const QString studio = xml.readElementText().trimmed();
+            if (result.studio.isEmpty()) {
+                result.studio = studio;
+            }
+        } else if (name == QLatin1String("genre")) {
+            const QString genre = xml.readElementText().trimmed();
+            if (!genre.isEmpty() && !result.genres.contains(genre)) {
+                result.genres.append(genre);
+            }
+        } else if (name == QLatin1String("actor")) {
+            const QString actor = readActorName(xml);
+            if (!actor.isEmpty() && !result.actors.contains(actor)) {
+                result.actors.append(actor);
+            }
+        } else if (name == QLatin1String("premiered") || name == QLatin1String("releasedate")
+                   || name == QLatin1String("release")) {
+            const QString text = xml.readElementText().trimmed();
+            if (releaseText.isEmpty()) {
+                releaseText = text;
+            }
+        } else if (name == QLatin1String("year")) {
+            year = xml.readElementText().trimmed().toInt();
+        } else if (name == QLatin1String("rating")) {
+            bool ok = false;
+            const float rating = xml.readElementText().toFloat(&ok);
+            if (ok && result.rating == 0) {
+                result.rating = rating;
+            }
+        } else if (name == QLatin1String("ratings")) {
+            const float rating = readRatings(xml);
+            if (rating > 0) {
+                result.rating = rating;
+            }
+        } else {
+            xml.skipCurrentElement();
+        }
+    }
+
+    if (xml.hasError()) {
+        if (errorReason) *errorReason = xml.errorString();
+        return false;
+    }
+
+    result.releaseDate = QDate::fromString(releaseText, Qt::ISODate);
+    if (!result.releaseDate.isValid() && year > 0) {
+        result.releaseDate = QDate(year, 1, 1);
+    }
+    result.rating = qBound(0.0f, result.rating, RATING_SCALE);
+
+    *metadata = result;
+    return true;
+}
@@ -0,0 +1,156 @@
+#include "posterfailurecache.h"
+#include <QSettings>
+#include <QMutexLocker>
+#include <QDebug>
+
+// 退避时间：首次失败后1小时，之后每次翻倍，最长30天
+static const qint64 BACKOFF_BASE_SECS = 60 * 60;
+static const qint64 BACKOFF_MAX_SECS = 30LL * 24 * 60 * 60;
+
+void PosterFailureCache::setFilePath(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_filePath = filePath;
+}
+
+void PosterFailureCache::load()
+{
+    QMutexLocker locker(&m_mutex);
+    m_failures.clear();
+    m_dirty = false;
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+
+    QSettings settings(m_filePath, QSettings::IniFormat);
+    int size = settings.beginReadArray("Failures");
+    for (int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        QString path = settings.value("Path").toString();
+        if (path.isEmpty()) {
+            continue;
+        }
+
+        PosterFailure failure;
+        failure.reason = settings.value("Reason").toString();
+        failure.attempts = settings.value("Attempts", 1).toInt();
+        failure.fileSize = settings.value("Size").toLongLong();
+        failure.fileModified = settings.value("Modified").toDateTime();
+        failure.lastAttempt = settings.value("LastAttempt").toDateTime();
+        failure.nextRetry = settings.value("NextRetry").toDateTime();
+        m_failures.insert(path, failure);
+    }
+    settings.endArray();
+
+    qInfo() << "加载封面提取失败记录:" << m_failures.size() << "条";
+}
+
+void PosterFailureCache::save()
+{
+    // 在锁内只复制（隐式共享）记录，写文件时工作线程可以继续记录失败
+    QString filePath;
+    QHash<QString, PosterFailure> failures;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_dirty || m_filePath.isEmpty()) {
+            return;
+        }
+        m_dirty = false;
+        filePath = m_filePath;
+        failures = m_failures;
+    }
+
+    QSettings settings(filePath, QSettings::IniFormat);
+    settings.clear();
+    settings.beginWriteArray("Failures");
+    int i = 0;
+    for (auto it = failures.constBegin(); it != failures.constEnd(); ++it, ++i) {
+        settings.setArrayIndex(i);
+        settings.setValue("Path", it.key());
+        settings.setValue("Reason", it->reason);
+        settings.setValue("Attempts", it->attempts);
+        settings.setValue("Size", it->fileSize);
+        settings.setValue("Modified", it->fileModified);
+        settings.setValue("LastAttempt", it->lastAttempt);
+        settings.setValue("NextRetry", it->nextRetry);
+    }
+    settings.endArray();
+    settings.sync();
+
+    if (settings.status() != QSettings::NoError) {
+        qWarning() << "保存封面提取失败记录时出错:" << settings.status();
+        // 写盘失败（如 U 盘被拔出）时保留未保存标记，下次保存时重试
+        QMutexLocker locker(&m_mutex);
+        m_dirty = true;
+    }
+}
+
+PosterFailure PosterFailureCache::recordFailure(const QString &videoPath, qint64 fileSize,
+                                                const QDateTime &fileModified, const QString &reason)
+{
+    QMutexLocker locker(&m_mutex);
+
+    PosterFailure &failure = m_failures[videoPath];
+    // 文件变化后重新开始计数
+    if (failure.fileSize != fileSize || failure.fileModified != fileModified) {
+        failure.attempts = 0;
+    }
+
+    failure.reason = reason;
+    failure.attempts++;
+    failure.fileSize = fileSize;
+    failure.fileModified = fileModified;
+    failure.lastAttempt = QDateTime::currentDateTime();
+
+    qint64 backoff = BACKOFF_BASE_SECS << qMin(failure.attempts - 1, 16);
+    failure.nextRetry = failure.lastAttempt.addSecs(qMin(backoff, BACKOFF_MAX_SECS));
+
+    qWarning() << "封面提取失败:" << videoPath << "原因:" << reason
+               << "次数:" << failure.attempts << "下次重试:" << failure.nextRetry.toString(Qt::ISODate);
+
+    m_dirty = true;
+    return failure;
+}
+
+void PosterFailureCache::clear(const QString &videoPath)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_failures.remove(videoPath) > 0) {
+        m_dirty = true;
+    }
+}
+
+bool PosterFailureCache::lookup(const QString &videoPath, qint64 fileSize,
+                                const QDateTime &fileModified, PosterFailure *failure) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_failures.constFind(videoPath);
+    if (it == m_failures.constEnd()) {
+        return false;
+    }
+
+    // 文件大小或修改时间变化，说明文件已被替换或修复，旧记录不再适用
+    if (it->fileSize != fileSize || it->fileModified != fileModified) {
+        return false;
+    }
+
+    if (failure) {
+        *failure = *it;
+    }
+    return true;
+}
+
+bool PosterFailureCache::shouldSkip(const QString &videoPath, qint64 fileSize, const QDateTime &fileModified) const
+{
+    PosterFailure failure;
+    if (!lookup(videoPath, fileSize, fileModified, &failure)) {
+        return false;
+    }
+    return QDateTime::currentDateTime() < failure.nextRetry;
+}
+
+int PosterFailureCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_failures.size();
+}
@@ -0,0 +1,203 @@
+#include "posterjobqueue.h"
+#include <QSettings>
+#include <QFile>
+#include <QMutexLocker>
+#include <QDir>
+#include <QDebug>
+#include <algorithm>
+
+// 路径是否位于目录之下。目录加上分隔符再比较，D:/videos 不会匹配 D:/videos2 下的文件
+static bool isUnder(const QString &path, const QString &dirPath)
+{
+    QString prefix = QDir::cleanPath(dirPath);
+    if (!prefix.endsWith(QLatin1Char('/'))) {
+        prefix += QLatin1Char('/');
+    }
+    return path.startsWith(prefix);
+}
+
+void PosterJobQueue::setFilePath(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_filePath = filePath;
+}
+
+void PosterJobQueue::load()
+{
+    QMutexLocker locker(&m_mutex);
+    m_jobs.clear();
+    m_nextSequence = 0;
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+
+    QSettings settings(m_filePath, QSettings::IniFormat);
+    int size = settings.beginReadArray("Jobs");
+    int interrupted = 0;
+    for (int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        PosterJob job;
+        job.videoPath = settings.value("Video").toString();
+        job.outputPath = settings.value("Output").toString();
+        if (job.videoPath.isEmpty() || job.outputPath.isEmpty()) {
+            continue;
+        }
+
+        // 上次退出时正在执行的任务重新排队，并清理被中断的临时文件
+        if (settings.value("State").toString() == "running") {
+            interrupted++;
+            QFile::remove(tempPathFor(job.outputPath));
+        }
+        job.state = PosterJobState::Pending;
+        job.sequence = m_nextSequence++;
+        m_jobs.insert(job.videoPath, job);
+    }
+    settings.endArray();
+
+    if (!m_jobs.isEmpty()) {
+        qInfo() << "恢复封面提取队列:" << m_jobs.size() << "个任务，其中" << interrupted << "个在上次退出时被中断";
+    }
+}
+
+void PosterJobQueue::save() const
+{
+    QMutexLocker locker(&m_mutex);
+    saveLocked();
+}
+
+void PosterJobQueue::saveLocked() const
+{
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+
+    // 按入队顺序写出
+    QVector<const PosterJob*> ordered;
+    ordered.reserve(m_jobs.size());
+    for (const PosterJob &job : m_jobs) {
+        ordered.append(&job);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const PosterJob *a, const PosterJob *b) {
+        return a->sequence < b->sequence;
+    });
+
+    QSettings settings(m_filePath, QSettings::IniFormat);
+    settings.clear();
+    settings.beginWriteArray("Jobs");
+    for (int i = 0; i < ordered.size(); ++i) {
+        settings.setArrayIndex(i);
+        settings.setValue("Video", ordered[i]->videoPath);
+        settings.setValue("Output", ordered[i]->outputPath);
+        settings.setValue("State", ordered[i]->state == PosterJobState::Running ? "running" : "pending");
+    }
+    settings.endArray();
+    settings.sync();
+
+    if (settings.status() != QSettings::NoError) {
+        qWarning() << "保存封面提取队列时出错:" << settings.status();
+    }
+}
+
+bool PosterJobQueue::enqueue(const QString &videoPath, const QString &outputPath)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_jobs.contains(videoPath)) {
+        return false;
+    }
+
+    PosterJob job;
+    job.videoPath = videoPath;
+    job.outputPath = outputPath;
+    job.sequence = m_nextSequence++;
+    m_jobs.insert(videoPath, job);
+    return true;
+}
+
+QVector<PosterJob> PosterJobQueue::takePending()
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<PosterJob> pending;
+    for (PosterJob &job : m_jobs) {
+        if (job.state == PosterJobState::Pending) {
+            job.state = PosterJobState::Running;
+            pending.append(job);
+        }
+    }
+    std::sort(pending.begin(), pending.end(), [](const PosterJob &a, const PosterJob &b) {
+        return a.sequence < b.sequence;
+    });
+    return pending;
+}
+
+void PosterJobQueue::finish(const QString &videoPath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_jobs.remove(videoPath);
+}
+
+void PosterJobQueue::removeUnder(const QString &dirPath)
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+        if (isUnder(it.key(), dirPath)) {
+            it = m_jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PosterJobQueue::retainUnder(const QStringList &dirPaths)
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+        bool keep = std::any_of(dirPaths.begin(), dirPaths.end(), [&it](const QString &dir) {
+            return isUnder(it.key(), dir);
+        });
+        if (keep) {
+            ++it;
+        } else {
+            it = m_jobs.erase(it);
+        }
+    }
+}
+
+int PosterJobQueue::removeIf(const std::function<bool(const QString &videoPath)> &predicate)
+{
+    // 判断条件可能访问文件系统，不在锁内执行
+    QStringList paths;
+    {
+        QMutexLocker locker(&m_mutex);
+        paths = m_jobs.keys();
+    }
+    QStringList removed;
+    for (const QString &path : qAsConst(paths)) {
+        if (predicate(path)) {
+            removed.append(path);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (const QString &path : qAsConst(removed)) {
+        m_jobs.remove(path);
+    }
+    return removed.size();
+}
+
+bool PosterJobQueue::contains(const QString &videoPath) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_jobs.contains(videoPath);
+}
+
+int PosterJobQueue::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_jobs.size();
+}
+
+QString PosterJobQueue::tempPathFor(const QString &outputPath)
+{
+    // 保留 .jpg 扩展名，FFmpeg 依据扩展名选择输出格式
+    return outputPath + ".part.jpg";
+}
@@ -0,0 +1,419 @@
+#include "roaringbitmap.h"
+#include <QtAlgorithms>
+#include <algorithm>
+
+// 数组容器的最大元素数：超过后位图（8 KB）更省空间
+static const int ARRAY_MAX = 4096;
+// 位图容器的字数
+static const int BITMAP_WORDS = 65536 / 64;
+
+bool RoaringBitmap::Container::contains(quint16 low) const
+{
+    if (isBitmap()) {
+        return words.at(low >> 6) & (quint64(1) << (low & 63));
+    }
+    return std::binary_search(values.constBegin(), values.constEnd(), low);
+}
+
+void RoaringBitmap::Container::add(quint16 low)
+{
+    if (isBitmap()) {
+        quint64 &word = words[low >> 6];
+        const quint64 bit = quint64(1) << (low & 63);
+        if (!(word & bit)) {
+            word |= bit;
+            ++cardinality;
+        }
+        return;
+    }
+
+    auto it = std::lower_bound(values.begin(), values.end(), low);
+    if (it != values.end() && *it == low) {
+        return;
+    }
+    values.insert(it, low);
+    ++cardinality;
+    if (cardinality > ARRAY_MAX) {
+        toBitmap();
+    }
+}
+
+void RoaringBitmap::Container::remove(quint16 low)
+{
+    if (isBitmap()) {
+        quint64 &word = words[low >> 6];
+        const quint64 bit = quint64(1) << (low & 63);
+        if (word & bit) {
+            word &= ~bit;
+            --cardinality;
+            toArrayIfSparse();
+        }
+        return;
+    }
+
+    auto it = std::lower_bound(values.begin(), values.end(), low);
+    if (it != values.end() && *it == low) {
+        values.erase(it);
+        --cardinality;
+    }
+}
+
+void RoaringBitmap::Container::toBitmap()
+{
+    words = QVector<quint64>(BITMAP_WORDS, 0);
+    for (quint16 low : qAsConst(values)) {
+        words[low >> 6] |= quint64(1) << (low & 63);
+    }
+    values.clear();
+    values.squeeze();
+}
+
+void RoaringBitmap::Container::toArrayIfSparse()
+{
+    if (!isBitmap() || cardinality > ARRAY_MAX) {
+        return;
+    }
+    values.clear();
+    values.reserve(cardinality);
+    for (int i = 0; i < BITMAP_WORDS; ++i) {
+        quint64 word = words.at(i);
+        while (word) {
+            const int bit = qCountTrailingZeroBits(word);
+            values.append(static_cast<quint16>(i * 64 + bit));
+            word &= word - 1;
+        }
+    }
+    words.clear();
+    words.squeeze();
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container &a, const Container &b)
+{
+    Container result;
+    if (a.isBitmap() && b.isBitmap()) {
+        result.words.resize(BITMAP_WORDS);
+        for (int i = 0; i < BITMAP_WORDS; ++i) {
+            result.words[i] = a.words.at(i) & b.words.at(i);
+            result.cardinality += qPopulationCount(result.words.at(i));
+        }
+        result.toArrayIfSparse();
+        return result;
+    }
+
+    if (a.isBitmap() || b.isBitmap()) {
+        // 数组中的元素逐个到位图中查找
+        const Container &array = a.isBitmap() ? b : a;
+        const Container &bitmap = a.isBitmap() ? a : b;
+        for (quint16 low : array.values) {
+            if (bitmap.contains(low)) {
+                result.values.append(low);
+            }
+        }
+    } else {
+        std::set_intersection(a.values.constBegin(), a.values.constEnd(),
+                              b.values.constBegin(), b.values.constEnd(),
+                              std::back_inserter(result.values));
+    }
+    result.cardinality = result.values.size();
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container &a, const Container &b)
+{
+    Container result;
+    if (!a.isBitmap() && !b.isBitmap() && a.cardinality + b.cardinality <= ARRAY_MAX) {
+        std::set_union(a.values.constBegin(), a.values.constEnd(),
+                       b.values.constBegin(), b.values.constEnd(),
+                       std::back_inserter(result.values));
+        result.cardinality = result.values.size();
+        return result;
+    }
+
+    // 以位图为结果，再把另一侧并入
+    result = a;
+    if (!result.isBitmap()) {
+        result.toBitmap();
+    }
+    if (b.isBitmap()) {
+        result.cardinality = 0;
+        for (int i = 0; i < BITMAP_WORDS; ++i) {
+            result.words[i] |= b.words.at(i);
+            result.cardinality += qPopulationCount(result.words.at(i));
+        }
+    } else {
+        for (quint16 low : b.values) {
+            result.add(low);
+        }
+    }
+    result.toArrayIfSparse();
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::subtract(const Container &a, const Container &b)
+{
+    Container result;
+    if (a.isBitmap()) {
+        result = a;
+        if (b.isBitmap()) {
+            result.cardinality = 0;
+            for (int i = 0; i < BITMAP_WORDS; ++i) {
+                result.words[i] &= ~b.words.at(i);
+                result.cardinality += qPopulationCount(result.words.at(i));
+            }
+            result.toArrayIfSparse();
+        } else {
+            for (quint16 low : b.values) {
+                result.remove(low);
+            }
+        }
+        return result;
+    }
+
+    for (quint16 low : a.values) {
+        if (!b.contains(low)) {
+            result.values.append(low);
+        }
+    }
+    result.cardinality = result.values.size();
+    return result;
+}
+
+int RoaringBitmap::intersectionCount(const Container &a, const Container &b)
+{
+    int count = 0;
+    if (a.isBitmap() && b.isBitmap()) {
+        for (int i = 0; i < BITMAP_WORDS; ++i) {
+            count += qPopulationCount(a.words.at(i) & b.words.at(i));
+        }
+    } else if (a.isBitmap() || b.isBitmap()) {
+        const Container &array = a.isBitmap() ? b : a;
+        const Container &bitmap = a.isBitmap() ? a : b;
+        for (quint16 low : array.values) {
+            count += bitmap.contains(low);
+        }
+    } else {
+        auto i = a.values.constBegin();
+        auto j = b.values.constBegin();
+        while (i != a.values.constEnd() && j != b.values.constEnd()) {
+            if (*i < *j) {
+                ++i;
+            } else if (*j < *i) {
+                ++j;
+            } else {
+                ++count;
+                ++i;
+                ++j;
+            }
+        }
+    }
+    return count;
+}
+
+int RoaringBitmap::indexOf(quint16 key) const
+{
+    auto it = std::lower_bound(m_keys.constBegin(), m_keys.constEnd(), key);
+    if (it != m_keys.constEnd() && *it == key) {
+        return it - m_keys.constBegin();
+    }
+    return -1;
+}
+
+void RoaringBitmap::add(quint32 value)
+{
+    const quint16 key = value >> 16;
+    auto it = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+    const int i = it - m_keys.begin();
+    if (it == m_keys.end() || *it != key) {
+        m_keys.insert(i, key);
+        m_containers.insert(i, Container());
+    }
+    m_containers[i].add(static_cast<quint16>(value));
+}
+
+void RoaringBitmap::remove(quint32 value)
+{
+    const int i = indexOf(value >> 16);
+    if (i < 0) {
+        return;
+    }
+    m_containers[i].remove(static_cast<quint16>(value));
+    if (m_containers.at(i).cardinality == 0) {
+        m_keys.remove(i);
+        m_containers.remove(i);
+    }
+}
+
+bool RoaringBitmap::contains(quint32 value) const
+{
+    const int i = indexOf(value >> 16);
+    return i >= 0 && m_containers.at(i).contains(static_cast<quint16>(value));
+}
+
+int RoaringBitmap::cardinality() const
+{
+    int count = 0;
+    for (const Container &container : m_containers) {
+        count += container.cardinality;
+    }
+    return count;
+}
+
+void RoaringBitmap::clear()
+{
+    m_keys.clear();
+    m_containers.clear();
+}
+
+QVector<quint32> RoaringBitmap::toVector() const
+{
+    QVector<quint32> result;
+    result.reserve(cardinality());
+    for (int i = 0; i < m_keys.size(); ++i) {
+        const quint32 high = quint32(m_keys.at(i)) << 16;
+        const Container &container = m_containers.at(i);
+        if (!container.isBitmap()) {
+            for (quint16 low : container.values) {
+                result.append(high | low);
+            }
+            continue;
+        }
+        for (int w = 0; w < BITMAP_WORDS; ++w) {
+            quint64 word = container.words.at(w);
+            while (word) {
+                result.append(high | quint32(w * 64 + qCountTrailingZeroBits(word)));
+                word &= word - 1;
+            }
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::fromValues(const quint32 *values, int count)
+{
+    // 视频 ID 连续分配，桶数很少，直接按高 16 位下标定位桶
+    QVector<int> containerOf;
+    QVector<Container> containers;
+    for (int n = 0; n < count; ++n) {
+        const quint32 value = values[n];
+        const int key = value >> 16;
+        if (key >= containerOf.size()) {
+            containerOf.resize(key + 1, -1);
+        }
+        if (containerOf.at(key) < 0) {
+            containerOf[key] = containers.size();
+            containers.append(Container());
+            containers.last().words = QVector<quint64>(BITMAP_WORDS, 0);
+        }
+        containers[containerOf.at(key)].add(static_cast<quint16>(value));
+    }
+
+    RoaringBitmap result;
+    result.m_keys.reserve(containers.size());
+    result.m_containers.reserve(containers.size());
+    for (int key = 0; key < containerOf.size(); ++key) {
+        const int i = containerOf.at(key);
+        if (i >= 0) {
+            containers[i].toArrayIfSparse();
+            result.m_keys.append(static_cast<quint16>(key));
+            result.m_containers.append(containers.at(i));
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::intersect(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    // 只有两边都有的桶才可能有交集
+    RoaringBitmap result;
+    int i = 0;
+    int j = 0;
+    while (i < a.m_keys.size() && j < b.m_keys.size()) {
+        if (a.m_keys.at(i) < b.m_keys.at(j)) {
+            ++i;
+        } else if (b.m_keys.at(j) < a.m_keys.at(i)) {
+            ++j;
+        } else {
+            Container container = intersect(a.m_containers.at(i), b.m_containers.at(j));
+            if (container.cardinality > 0) {
+                result.m_keys.append(a.m_keys.at(i));
+                result.m_containers.append(container);
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::unite(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    RoaringBitmap result;
+    int i = 0;
+    int j = 0;
+    while (i < a.m_keys.size() || j < b.m_keys.size()) {
+        if (j >= b.m_keys.size() || (i < a.m_keys.size() && a.m_keys.at(i) < b.m_keys.at(j))) {
+            result.m_keys.append(a.m_keys.at(i));
+            result.m_containers.append(a.m_containers.at(i));
+            ++i;
+        } else if (i >= a.m_keys.size() || b.m_keys.at(j) < a.m_keys.at(i)) {
+            result.m_keys.append(b.m_keys.at(j));
+            result.m_containers.append(b.m_containers.at(j));
+            ++j;
+        } else {
+            result.m_keys.append(a.m_keys.at(i));
+            result.m_containers.append(unite(a.m_containers.at(i), b.m_containers.at(j)));
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::subtract(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    RoaringBitmap result;
+    for (int i = 0; i < a.m_keys.size(); ++i) {
+        const int j = b.indexOf(a.m_keys.at(i));
+        if (j < 0) {
+            result.m_keys.append(a.m_keys.at(i));
+            result.m_containers.append(a.m_containers.at(i));
+            continue;
+        }
+        Container container = subtract(a.m_containers.at(i), b.m_containers.at(j));
+        if (container.cardinality > 0) {
+            result.m_keys.append(a.m_keys.at(i));
+            result.m_containers.append(container);
+        }
+    }
+    return result;
+}
+
+int RoaringBitmap::intersectionCount(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    int count = 0;
+    int i = 0;
+    int j = 0;
+    while (i < a.m_keys.size() && j < b.m_keys.size()) {
+        if (a.m_keys.at(i) < b.m_keys.at(j)) {
+            ++i;
+        } else if (b.m_keys.at(j) < a.m_keys.at(i)) {
+            ++j;
+        } else {
+            count += intersectionCount(a.m_containers.at(i), b.m_containers.at(j));
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+qint64 RoaringBitmap::bytes() const
+{
+    qint64 bytes = m_keys.capacity() * qint64(sizeof(quint16))
+                 + m_containers.capacity() * qint64(sizeof(Container));
+    for (const Container &container : m_containers) {
+        bytes += container.values.capacity() * qint64(sizeof(quint16))
+               + container.words.capacity() * qint64(sizeof(quint64));
+    }
+    return bytes;
+}
@@ -0,0 +1,201 @@
+#include "settingsstore.h"
+#include <QSettings>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QMutexLocker>
+#include <QDebug>
+
+// 最后一次修改后等待多久写盘
+static const int FLUSH_DELAY_MS = 500;
+
+SettingsStore::SettingsStore(const QString &filePath, QObject *parent)
+    : QObject(parent),
+      m_filePath(filePath),
+      m_generation(0),
+      m_flushedGeneration(0),
+      m_writtenGeneration(0)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_DELAY_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, &SettingsStore::flushAsync);
+
+    m_writer.setMaxThreadCount(1);
+}
+
+SettingsStore::~SettingsStore()
+{
+    sync();
+}
+
+void SettingsStore::load()
+{
+    m_values.clear();
+
+    QSettings settings(m_filePath, QSettings::IniFormat);
+    const QStringList keys = settings.allKeys();
+    for (const QString &key : keys) {
+        m_values.insert(key, settings.value(key));
+    }
+    m_flushedGeneration = m_generation;
+    QMutexLocker locker(&m_writeMutex);
+    m_writtenGeneration = m_generation;
+}
+
+QVariant SettingsStore::value(const QString &key, const QVariant &defaultValue) const
+{
+    return m_values.value(key, defaultValue);
+}
+
+// INI 中读出的标量都是 QString，与 bool、int 等类型的新值直接比较总是不等：
+// 类型不同时按写入 INI 的文本形式比较
+static bool sameValue(const QVariant &stored, const QVariant &value)
+{
+    if (stored.metaType() == value.metaType()) {
+        return stored == value;
+    }
+    if (stored.canConvert<QString>() && value.canConvert<QString>()) {
+        return stored.toString() == value.toString();
+    }
+    return false;
+}
+
+void SettingsStore::setValue(const QString &key, const QVariant &value)
+{
+    auto it = m_values.find(key);
+    if (it != m_values.end() && sameValue(it.value(), value)) {
+        return;
+    }
+    m_values.insert(key, value);
+    scheduleFlush();
+}
+
+void SettingsStore::remove(const QString &key)
+{
+    if (m_values.remove(key) > 0) {
+        scheduleFlush();
+    }
+}
+
+void SettingsStore::removeGroup(const QString &group)
+{
+    const QString prefix = group + QLatin1Char('/');
+    bool removed = false;
+    auto it = m_values.lowerBound(prefix);
+    while (it != m_values.end() && it.key().startsWith(prefix)) {
+        it = m_values.erase(it);
+        removed = true;
+    }
+    if (removed) {
+        scheduleFlush();
+    }
+}
+
+QStringList SettingsStore::readArray(const QString &group, const QString &key) const
+{
+    QStringList values;
+    const int size = m_values.value(group + QStringLiteral("/size")).toInt();
+    for (int i = 1; i <= size; ++i) {
+        values.append(m_values.value(QStringLiteral("%1/%2/%3").arg(group).arg(i).arg(key)).toString());
+    }
+    return values;
+}
+
+void SettingsStore::writeArray(const QString &group, const QString &key, const QStringList &values)
+{
+    if (readArray(group, key) == values) {
+        return;
+    }
+
+    removeGroup(group);
+    // QSettings 的数组下标从1开始
+    for (int i = 0; i < values.size(); ++i) {
+        m_values.insert(QStringLiteral("%1/%2/%3").arg(group).arg(i + 1).arg(key), values.at(i));
+    }
+    m_values.insert(group + QStringLiteral("/size"), values.size());
+    scheduleFlush();
+}
+
+void SettingsStore::scheduleFlush()
+{
+    ++m_generation;
+    m_flushTimer.start();
+}
+
+void SettingsStore::flushAsync()
+{
+    if (m_flushedGeneration == m_generation) {
+        return;
+    }
+
+    // 复制快照（隐式共享，代价很小），后台线程不访问 m_values
+    QMap<QString, QVariant> snapshot = m_values;
+    quint64 generation = m_generation;
+    m_flushedGeneration = generation;
+    m_writer.start([this, snapshot, generation]() {
+        writeSnapshot(snapshot, generation);
+    });
+}
+
+void SettingsStore::sync()
+{
+    m_flushTimer.stop();
+    m_writer.waitForDone();
+
+    // 包括后台写盘失败的版本，关闭前再试一次
+    quint64 written = 0;
+    {
+        QMutexLocker locker(&m_writeMutex);
+        written = m_writtenGeneration;
+    }
+    m_flushedGeneration = m_generation;
+    if (written != m_generation) {
+        writeSnapshot(m_values, m_generation);
+    }
+}
+
+bool SettingsStore::writeSnapshot(const QMap<QString, QVariant> &values, quint64 generation)
+{
+    QMutexLocker locker(&m_writeMutex);
+    if (generation <= m_writtenGeneration) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_filePath).path());
+
+    // 先用 QSettings 写出临时文件以保持 INI 编码格式一致
+    const QString tempPath = m_filePath + QStringLiteral(".writing");
+    QFile::remove(tempPath);
+    {
+        QSettings settings(tempPath, QSettings::IniFormat);
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+            settings.setValue(it.key(), it.value());
+        }
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qWarning() << "写入临时配置文件失败:" << tempPath << settings.status();
+            QFile::remove(tempPath);
+            return false;
+        }
+    }
+
+    QFile temp(tempPath);
+    if (!temp.open(QIODevice::ReadOnly)) {
+        qWarning() << "无法读取临时配置文件:" << tempPath << temp.errorString();
+        return false;
+    }
+    QByteArray content = temp.readAll();
+    temp.close();
+    QFile::remove(tempPath);
+
+    // QSaveFile 写完后以重命名方式原子替换目标文件
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit()) {
+        qWarning() << "保存配置文件失败:" << m_filePath << file.errorString();
+        return false;
+    }
+
+    m_writtenGeneration = generation;
+    return true;
+}
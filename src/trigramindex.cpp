@@ -0,0 +1,146 @@
+#include "trigramindex.h"
+#include <algorithm>
+
+// 三个 UTF-16 码元打包成一个 48 位键
+static inline quint64 packTrigram(QChar a, QChar b, QChar c)
+{
+    return (quint64(a.unicode()) << 32) | (quint64(b.unicode()) << 16) | quint64(c.unicode());
+}
+
+QVector<quint64> TrigramIndex::trigramsOf(const QString &foldedText)
+{
+    QVector<quint64> trigrams;
+    if (foldedText.size() < 3) {
+        return trigrams;
+    }
+
+    trigrams.reserve(foldedText.size() - 2);
+    for (int i = 0; i + 2 < foldedText.size(); ++i) {
+        trigrams.append(packTrigram(foldedText.at(i), foldedText.at(i + 1), foldedText.at(i + 2)));
+    }
+
+    // 去重，每个文档在同一倒排表中只出现一次
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+void TrigramIndex::insert(quint32 id, const QString &text)
+{
+    if (m_texts.contains(id)) {
+        remove(id);
+    }
+
+    QString folded = text.toCaseFolded();
+    const QVector<quint64> trigrams = trigramsOf(folded);
+    for (quint64 trigram : trigrams) {
+        QVector<quint32> &posting = m_postings[trigram];
+        // 扫描时 id 递增分配，通常直接追加在末尾
+        if (posting.isEmpty() || posting.last() < id) {
+            posting.append(id);
+        } else {
+            auto it = std::lower_bound(posting.begin(), posting.end(), id);
+            if (it == posting.end() || *it != id) {
+                posting.insert(it, id);
+            }
+        }
+    }
+    m_texts.insert(id, folded);
+}
+
+void TrigramIndex::remove(quint32 id)
+{
+    auto textIt = m_texts.find(id);
+    if (textIt == m_texts.end()) {
+        return;
+    }
+
+    const QVector<quint64> trigrams = trigramsOf(textIt.value());
+    for (quint64 trigram : trigrams) {
+        auto postingIt = m_postings.find(trigram);
+        if (postingIt == m_postings.end()) {
+            continue;
+        }
+        QVector<quint32> &posting = postingIt.value();
+        auto it = std::lower_bound(posting.begin(), posting.end(), id);
+        if (it != posting.end() && *it == id) {
+            posting.erase(it);
+        }
+        if (posting.isEmpty()) {
+            m_postings.erase(postingIt);
+        }
+    }
+    m_texts.erase(textIt);
+}
+
+void TrigramIndex::clear()
+{
+    m_postings.clear();
+    m_texts.clear();
+}
+
+void TrigramIndex::intersect(QVector<quint32> &target, const QVector<quint32> &other)
+{
+    QVector<quint32> result;
+    result.reserve(target.size());
+
+    if (other.size() > target.size() * 16) {
+        // 长度悬殊时在长表中二分查找，避免整表遍历
+        auto from = other.constBegin();
+        for (quint32 id : qAsConst(target)) {
+            from = std::lower_bound(from, other.constEnd(), id);
+            if (from == other.constEnd()) {
+                break;
+            }
+            if (*from == id) {
+                result.append(id);
+            }
+        }
+    } else {
+        std::set_intersection(target.constBegin(), target.constEnd(),
+                              other.constBegin(), other.constEnd(),
+                              std::back_inserter(result));
+    }
+    target.swap(result);
+}
+
+bool TrigramIndex::search(const QString &query, QVector<quint32> *results) const
+{
+    QString folded = query.toCaseFolded();
+    if (folded.size() < 3) {
+        return false;
+    }
+
+    results->clear();
+
+    // 收集各 trigram 的倒排表，任何一个不存在则没有结果
+    const QVector<quint64> trigrams = trigramsOf(folded);
+    QVector<const QVector<quint32>*> postings;
+    postings.reserve(trigrams.size());
+    for (quint64 trigram : trigrams) {
+        auto it = m_postings.constFind(trigram);
+        if (it == m_postings.constEnd()) {
+            return true;
+        }
+        postings.append(&it.value());
+    }
+
+    // 从最短的倒排表开始求交集，候选集合尽快缩小
+    std::sort(postings.begin(), postings.end(),
+              [](const QVector<quint32> *a, const QVector<quint32> *b) {
+                  return a->size() < b->size();
+              });
+    QVector<quint32> candidates = *postings.first();
+    for (int i = 1; i < postings.size() && !candidates.isEmpty(); ++i) {
+        intersect(candidates, *postings.at(i));
+    }
+
+    // trigram 全部命中不代表连续出现，逐个验证子串
+    results->reserve(candidates.size());
+    for (quint32 id : qAsConst(candidates)) {
+        if (m_texts.value(id).contains(folded)) {
+            results->append(id);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,616 @@
+#include "videocatalog.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <algorithm>
+
+// 每块条目数
+static const quint32 CATALOG_CHUNK_SIZE = 4096;
+// 每个文字块的字符数（单段文字不超过 0xFFFF 个字符，总能放进一块）
+static const int NAME_BLOCK_SIZE = 0x10000;
+// 没有片商时的词表下标
+static const quint32 NO_TERM = 0xFFFFFFFF;
+// 每个条目最多记录的演员和类别数
+static const int MAX_TERMS_PER_KIND = 0xFF;
+// QString 数据块的头部大小（Qt 6 的 QArrayData）
+static const int STRING_HEADER_BYTES = 16;
+// 废弃的文字或演员、类别下标至少有这么多、且超过一半时才整理
+static const int COMPACT_MIN_DEAD = NAME_BLOCK_SIZE;
+
+// 一块条目，每列一个定长数组
+struct VideoCatalog::Chunk {
+    quint32 folderOf[CATALOG_CHUNK_SIZE];
+    quint32 nameOffset[CATALOG_CHUNK_SIZE];
+    quint16 nameLength[CATALOG_CHUNK_SIZE];
+    quint32 refs[CATALOG_CHUNK_SIZE];
+    quint32 generation[CATALOG_CHUNK_SIZE];     // 条目被复用的次数
+    quint8 reclaimed[CATALOG_CHUNK_SIZE];       // 已回收、在空闲列表中等待复用
+    qint64 fileSize[CATALOG_CHUNK_SIZE];
+    qint64 creationMs[CATALOG_CHUNK_SIZE];
+    qint64 modifiedMs[CATALOG_CHUNK_SIZE];
+
+    // 搜索和排序键，searchLength 为 0 表示尚未计算
+    quint32 searchOffset[CATALOG_CHUNK_SIZE];
+    quint16 searchLength[CATALOG_CHUNK_SIZE];
+    quint8 codeLength[CATALOG_CHUNK_SIZE];
+    quint32 sortKeyOffset[CATALOG_CHUNK_SIZE];
+    quint16 sortKeyLength[CATALOG_CHUNK_SIZE];
+
+    // NFO 元数据
+    qint64 nfoModifiedMs[CATALOG_CHUNK_SIZE];
+    quint32 titleOffset[CATALOG_CHUNK_SIZE];
+    quint16 titleLength[CATALOG_CHUNK_SIZE];
+    quint32 studio[CATALOG_CHUNK_SIZE];
+    quint32 termListOffset[CATALOG_CHUNK_SIZE];
+    quint8 actorCount[CATALOG_CHUNK_SIZE];
+    quint8 genreCount[CATALOG_CHUNK_SIZE];
+    quint8 rating[CATALOG_CHUNK_SIZE];          // 评分 * 10，0 表示没有
+    qint32 releaseDay[CATALOG_CHUNK_SIZE];      // 发行日期的儒略日，0 表示没有
+
+    // 内容哈希，hashFlags 标记哪些已计算
+    quint64 sampleHash[CATALOG_CHUNK_SIZE];
+    quint64 fullHash[CATALOG_CHUNK_SIZE];
+    quint64 coverHash[CATALOG_CHUNK_SIZE];
+    qint64 coverModifiedMs[CATALOG_CHUNK_SIZE];
+    quint8 hashFlags[CATALOG_CHUNK_SIZE];
+};
+
+// hashFlags 的位
+static const quint8 HASH_SAMPLED = 0x1;
+static const quint8 HASH_FULL = 0x2;
+static const quint8 HASH_COVER = 0x4;
+
+quint32 VideoCatalog::StringTable::intern(const QString &text)
+{
+    auto it = index.constFind(text);
+    if (it != index.constEnd()) {
+        return it.value();
+    }
+    const quint32 i = strings.size();
+    strings.append(text);
+    index.insert(text, i);
+    return i;
+}
+
+qint64 VideoCatalog::StringTable::bytes() const
+{
+    // QString 本身、数据块，以及哈希表中的一份键（与表中共享数据）和节点
+    qint64 bytes = strings.capacity() * qint64(sizeof(QString));
+    for (const QString &text : strings) {
+        bytes += STRING_HEADER_BYTES + (text.capacity() + 1) * qint64(sizeof(QChar));
+    }
+    bytes += index.capacity() * qint64(sizeof(QString) + sizeof(quint32) + sizeof(void*));
+    return bytes;
+}
+
+VideoCatalog* VideoCatalog::instance()
+{
+    static VideoCatalog catalog;
+    return &catalog;
+}
+
+VideoCatalog::VideoCatalog()
+    : m_nameBlockUsed(NAME_BLOCK_SIZE),
+      m_textChars(0),
+      m_deadTextChars(0),
+      m_deadTerms(0),
+      m_count(0),
+      m_liveEntries(0)
+{
+}
+
+VideoCatalog::Chunk& VideoCatalog::chunkOf(quint32 id) const
+{
+    return *m_chunks[id / CATALOG_CHUNK_SIZE];
+}
+
+QStringView VideoCatalog::textAt(quint32 offset, int length) const
+{
+    if (length == 0) {
+        return QStringView();
+    }
+    return QStringView(m_nameBlocks[offset / NAME_BLOCK_SIZE].get() + offset % NAME_BLOCK_SIZE, length);
+}
+
+QStringView VideoCatalog::nameOf(quint32 id) const
+{
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    return textAt(chunk.nameOffset[slot], chunk.nameLength[slot]);
+}
+
+QStringView VideoCatalog::searchTextOf(quint32 id) const
+{
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    return textAt(chunk.searchOffset[slot], chunk.searchLength[slot]);
+}
+
+QStringView VideoCatalog::nameSortKeyOf(quint32 id) const
+{
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    return textAt(chunk.sortKeyOffset[slot], chunk.sortKeyLength[slot]);
+}
+
+quint32 VideoCatalog::storeName(QStringView name)
+{
+    // 当前块放不下时另起一块，已有的块不再移动
+    if (m_nameBlockUsed + name.size() > NAME_BLOCK_SIZE) {
+        m_nameBlocks.emplace_back(new char16_t[NAME_BLOCK_SIZE]);
+        m_nameBlockUsed = 0;
+    }
+    const quint32 offset = quint32(m_nameBlocks.size() - 1) * NAME_BLOCK_SIZE + m_nameBlockUsed;
+    std::copy_n(name.utf16(), name.size(), m_nameBlocks.back().get() + m_nameBlockUsed);
+    m_nameBlockUsed += name.size();
+    m_textChars += name.size();
+    return offset;
+}
+
+quint32 VideoCatalog::acquire(const QString &folderPath, QStringView fileName,
+                              qint64 fileSize, qint64 creationMs, qint64 modifiedMs)
+{
+    QWriteLocker locker(&m_lock);
+
+    // 同一文件夹下的视频共用一份路径
+    const quint32 folder = m_folders.intern(folderPath);
+    // 文件名超过 quint16 的部分截断（Windows 路径本身不超过 32767 个字符）
+    const QStringView name = fileName.left(qMin<qsizetype>(fileName.size(), 0xFFFF));
+
+    // 已知且未变化的文件沿用原 ID；大小或修改时间变了则分配新 ID，旧的缓存不会被误用
+    quint32 known;
+    if (findLocked(folder, name, fileSize, modifiedMs, &known)) {
+        if (chunkOf(known).refs[known % CATALOG_CHUNK_SIZE]++ == 0) {
+            ++m_liveEntries;
+        }
+        return known;
+    }
+
+    // 优先复用已回收的条目，代数加一，以 ID 为键的旧缓存随之失效
+    quint32 id;
+    if (!m_freeIds.isEmpty()) {
+        id = m_freeIds.takeLast();
+        ++chunkOf(id).generation[id % CATALOG_CHUNK_SIZE];
+    } else {
+        id = m_count++;
+        if (id % CATALOG_CHUNK_SIZE == 0) {
+            m_chunks.emplace_back(new Chunk);
+        }
+        chunkOf(id).generation[id % CATALOG_CHUNK_SIZE] = 0;
+    }
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    Chunk &chunk = chunkOf(id);
+    chunk.reclaimed[slot] = 0;
+    chunk.folderOf[slot] = folder;
+    chunk.nameOffset[slot] = storeName(name);
+    chunk.nameLength[slot] = static_cast<quint16>(name.size());
+    chunk.refs[slot] = 1;
+    chunk.fileSize[slot] = fileSize;
+    chunk.creationMs[slot] = creationMs;
+    chunk.modifiedMs[slot] = modifiedMs;
+    chunk.searchOffset[slot] = 0;
+    chunk.searchLength[slot] = 0;
+    chunk.codeLength[slot] = 0;
+    chunk.sortKeyOffset[slot] = 0;
+    chunk.sortKeyLength[slot] = 0;
+    chunk.nfoModifiedMs[slot] = 0;
+    chunk.titleOffset[slot] = 0;
+    chunk.titleLength[slot] = 0;
+    chunk.studio[slot] = NO_TERM;
+    chunk.termListOffset[slot] = 0;
+    chunk.actorCount[slot] = 0;
+    chunk.genreCount[slot] = 0;
+    chunk.rating[slot] = 0;
+    chunk.releaseDay[slot] = 0;
+    chunk.hashFlags[slot] = 0;
+    m_idsByPath.insert(qHash(name, folder), id);
+    ++m_liveEntries;
+    return id;
+}
+
+bool VideoCatalog::find(const QString &folderPath, QStringView fileName,
+                        qint64 fileSize, qint64 modifiedMs, quint32 *id) const
+{
+    QReadLocker locker(&m_lock);
+
+    // 文件夹从未出现过时文件必然是新的
+    auto folder = m_folders.index.constFind(folderPath);
+    if (folder == m_folders.index.constEnd()) {
+        return false;
+    }
+    const QStringView name = fileName.left(qMin<qsizetype>(fileName.size(), 0xFFFF));
+    return findLocked(folder.value(), name, fileSize, modifiedMs, id);
+}
+
+bool VideoCatalog::findLocked(quint32 folder, QStringView name,
+                              qint64 fileSize, qint64 modifiedMs, quint32 *id) const
+{
+    auto range = m_idsByPath.equal_range(qHash(name, folder));
+    for (auto it = range.first; it != range.second; ++it) {
+        const quint32 candidate = it.value();
+        const Chunk &chunk = chunkOf(candidate);
+        const quint32 slot = candidate % CATALOG_CHUNK_SIZE;
+        if (chunk.folderOf[slot] == folder && chunk.fileSize[slot] == fileSize
+            && chunk.modifiedMs[slot] == modifiedMs && nameOf(candidate) == name) {
+            *id = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void VideoCatalog::retain(quint32 id)
+{
+    QWriteLocker locker(&m_lock);
+    if (chunkOf(id).refs[id % CATALOG_CHUNK_SIZE]++ == 0) {
+        ++m_liveEntries;
+    }
+}
+
+void VideoCatalog::release(quint32 id)
+{
+    QWriteLocker locker(&m_lock);
+    if (--chunkOf(id).refs[id % CATALOG_CHUNK_SIZE] == 0) {
+        --m_liveEntries;
+    }
+}
+
+QVector<quint32> VideoCatalog::reclaimUnused()
+{
+    QWriteLocker locker(&m_lock);
+
+    // 不再被引用的条目移出路径表，文字和下标列表记为废弃，条目放入空闲列表
+    QVector<quint32> reclaimed;
+    for (quint32 id = 0; id < m_count; ++id) {
+        Chunk &chunk = chunkOf(id);
+        const quint32 slot = id % CATALOG_CHUNK_SIZE;
+        if (chunk.refs[slot] != 0 || chunk.reclaimed[slot]) {
+            continue;
+        }
+        m_idsByPath.remove(qHash(nameOf(id), chunk.folderOf[slot]), id);
+        m_deadTextChars += chunk.nameLength[slot] + chunk.searchLength[slot]
+                         + chunk.sortKeyLength[slot] + chunk.titleLength[slot];
+        m_deadTerms += chunk.actorCount[slot] + chunk.genreCount[slot];
+        chunk.nameLength[slot] = 0;
+        chunk.searchLength[slot] = 0;
+        chunk.sortKeyLength[slot] = 0;
+        chunk.titleLength[slot] = 0;
+        chunk.actorCount[slot] = 0;
+        chunk.genreCount[slot] = 0;
+        chunk.reclaimed[slot] = 1;
+        m_freeIds.append(id);
+        reclaimed.append(id);
+    }
+
+    // 回收的条目和重新读取的 NFO 留下的废弃部分超过一半时整理
+    if (m_deadTextChars >= COMPACT_MIN_DEAD && m_deadTextChars * 2 >= m_textChars) {
+        compactText();
+    }
+    if (m_deadTerms >= COMPACT_MIN_DEAD && m_deadTerms * 2 >= m_termLists.size()) {
+        compactTermLists();
+    }
+    return reclaimed;
+}
+
+void VideoCatalog::compactText()
+{
+    // 把仍在使用的文字依次复制到新的块中并更新偏移；读取都在锁内进行，不会有人持有旧的位置
+    std::vector<std::unique_ptr<char16_t[]>> oldBlocks;
+    oldBlocks.swap(m_nameBlocks);
+    m_nameBlockUsed = NAME_BLOCK_SIZE;
+    m_textChars = 0;
+    m_deadTextChars = 0;
+
+    auto moveText = [this, &oldBlocks](quint32 &offset, quint16 length) {
+        if (length != 0) {
+            const char16_t *text = oldBlocks[offset / NAME_BLOCK_SIZE].get() + offset % NAME_BLOCK_SIZE;
+            offset = storeName(QStringView(text, length));
+        }
+    };
+    for (quint32 id = 0; id < m_count; ++id) {
+        Chunk &chunk = chunkOf(id);
+        const quint32 slot = id % CATALOG_CHUNK_SIZE;
+        moveText(chunk.nameOffset[slot], chunk.nameLength[slot]);
+        moveText(chunk.searchOffset[slot], chunk.searchLength[slot]);
+        moveText(chunk.sortKeyOffset[slot], chunk.sortKeyLength[slot]);
+        moveText(chunk.titleOffset[slot], chunk.titleLength[slot]);
+    }
+}
+
+void VideoCatalog::compactTermLists()
+{
+    QVector<quint32> termLists;
+    termLists.reserve(m_termLists.size() - m_deadTerms);
+    for (quint32 id = 0; id < m_count; ++id) {
+        Chunk &chunk = chunkOf(id);
+        const quint32 slot = id % CATALOG_CHUNK_SIZE;
+        const int count = chunk.actorCount[slot] + chunk.genreCount[slot];
+        const quint32 offset = chunk.termListOffset[slot];
+        chunk.termListOffset[slot] = termLists.size();
+        for (int i = 0; i < count; ++i) {
+            termLists.append(m_termLists.at(offset + i));
+        }
+    }
+    m_termLists = termLists;
+    m_deadTerms = 0;
+}
+
+quint32 VideoCatalog::generation(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return chunkOf(id).generation[id % CATALOG_CHUNK_SIZE];
+}
+
+QString VideoCatalog::folderPath(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return m_folders.strings.at(chunkOf(id).folderOf[id % CATALOG_CHUNK_SIZE]);
+}
+
+QString VideoCatalog::fileName(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return nameOf(id).toString();
+}
+
+QString VideoCatalog::filePath(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    const QString &folder = m_folders.strings.at(chunkOf(id).folderOf[id % CATALOG_CHUNK_SIZE]);
+    const QStringView name = nameOf(id);
+
+    QString path;
+    path.reserve(folder.size() + 1 + name.size());
+    path.append(folder);
+    path.append(QLatin1Char('/'));
+    path.append(name);
+    return path;
+}
+
+qint64 VideoCatalog::fileSize(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return chunkOf(id).fileSize[id % CATALOG_CHUNK_SIZE];
+}
+
+qint64 VideoCatalog::creationMs(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return chunkOf(id).creationMs[id % CATALOG_CHUNK_SIZE];
+}
+
+qint64 VideoCatalog::modifiedMs(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return chunkOf(id).modifiedMs[id % CATALOG_CHUNK_SIZE];
+}
+
+bool VideoCatalog::hasSearchKeys(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return chunkOf(id).searchLength[id % CATALOG_CHUNK_SIZE] != 0;
+}
+
+void VideoCatalog::setSearchKeys(quint32 id, QStringView searchText, int codeLength, QStringView nameSortKey)
+{
+    QWriteLocker locker(&m_lock);
+    Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    // 快照读取和扫描可能同时为同一条目计算，先写入的为准
+    if (chunk.searchLength[slot] != 0 || searchText.isEmpty()) {
+        return;
+    }
+
+    // 超长时截断（番号在末尾，截断后不再保留）
+    const QStringView text = searchText.left(0xFFFF);
+    const QStringView sortKey = nameSortKey.left(0xFFFF);
+    chunk.searchOffset[slot] = storeName(text);
+    chunk.searchLength[slot] = static_cast<quint16>(text.size());
+    chunk.codeLength[slot] = text.size() == searchText.size() ? static_cast<quint8>(codeLength) : 0;
+    chunk.sortKeyOffset[slot] = sortKey.isEmpty() ? 0 : storeName(sortKey);
+    chunk.sortKeyLength[slot] = static_cast<quint16>(sortKey.size());
+}
+
+QString VideoCatalog::searchText(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return searchTextOf(id).toString();
+}
+
+QString VideoCatalog::codeKey(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    // 番号只含 ASCII 字母和数字，折叠大小写后转回大写即可还原
+    const int length = chunkOf(id).codeLength[id % CATALOG_CHUNK_SIZE];
+    return searchTextOf(id).right(length).toString().toUpper();
+}
+
+QString VideoCatalog::nameSortKey(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return nameSortKeyOf(id).toString();
+}
+
+int VideoCatalog::compareNameSortKeys(quint32 a, quint32 b) const
+{
+    QReadLocker locker(&m_lock);
+    return nameSortKeyOf(a).compare(nameSortKeyOf(b));
+}
+
+void VideoCatalog::visitSearchText(const QVector<quint32> &ids,
+                                   const std::function<void(quint32 id, QStringView searchText)> &visitor) const
+{
+    QReadLocker locker(&m_lock);
+    for (quint32 id : ids) {
+        visitor(id, searchTextOf(id));
+    }
+}
+
+void VideoCatalog::setMetadata(quint32 id, const VideoMetadata &metadata, qint64 nfoModifiedMs)
+{
+    QWriteLocker locker(&m_lock);
+    Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+
+    // 旧的标题和下标列表记为废弃，由 reclaimUnused 统一整理
+    m_deadTextChars += chunk.titleLength[slot];
+    m_deadTerms += chunk.actorCount[slot] + chunk.genreCount[slot];
+    const QStringView title = QStringView(metadata.title).left(0xFFFF);
+    chunk.titleOffset[slot] = title.isEmpty() ? 0 : storeName(title);
+    chunk.titleLength[slot] = static_cast<quint16>(title.size());
+    chunk.studio[slot] = metadata.studio.isEmpty() ? NO_TERM : m_terms.intern(metadata.studio);
+
+    const int actorCount = qMin<int>(metadata.actors.size(), MAX_TERMS_PER_KIND);
+    const int genreCount = qMin<int>(metadata.genres.size(), MAX_TERMS_PER_KIND);
+    chunk.termListOffset[slot] = m_termLists.size();
+    for (int i = 0; i < actorCount; ++i) {
+        m_termLists.append(m_terms.intern(metadata.actors.at(i)));
+    }
+    for (int i = 0; i < genreCount; ++i) {
+        m_termLists.append(m_terms.intern(metadata.genres.at(i)));
+    }
+    chunk.actorCount[slot] = static_cast<quint8>(actorCount);
+    chunk.genreCount[slot] = static_cast<quint8>(genreCount);
+
+    chunk.rating[slot] = static_cast<quint8>(qRound(metadata.rating * 10));
+    chunk.releaseDay[slot] = metadata.releaseDate.isValid() ? static_cast<qint32>(metadata.releaseDate.toJulianDay()) : 0;
+    chunk.nfoModifiedMs[slot] = nfoModifiedMs;
+}
+
+VideoMetadata VideoCatalog::metadata(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+
+    VideoMetadata metadata;
+    metadata.title = textAt(chunk.titleOffset[slot], chunk.titleLength[slot]).toString();
+    if (chunk.studio[slot] != NO_TERM) {
+        metadata.studio = m_terms.strings.at(chunk.studio[slot]);
+    }
+    const quint32 *terms = m_termLists.constData() + chunk.termListOffset[slot];
+    for (int i = 0; i < chunk.actorCount[slot]; ++i) {
+        metadata.actors.append(m_terms.strings.at(*terms++));
+    }
+    for (int i = 0; i < chunk.genreCount[slot]; ++i) {
+        metadata.genres.append(m_terms.strings.at(*terms++));
+    }
+    metadata.rating = chunk.rating[slot] / 10.0f;
+    if (chunk.releaseDay[slot] != 0) {
+        metadata.releaseDate = QDate::fromJulianDay(chunk.releaseDay[slot]);
+    }
+    return metadata;
+}
+
+QString VideoCatalog::title(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    return textAt(chunk.titleOffset[slot], chunk.titleLength[slot]).toString();
+}
+
+qint64 VideoCatalog::nfoModifiedMs(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return chunkOf(id).nfoModifiedMs[id % CATALOG_CHUNK_SIZE];
+}
+
+bool VideoCatalog::sampleHash(quint32 id, quint64 *hash) const
+{
+    QReadLocker locker(&m_lock);
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    if (!(chunk.hashFlags[slot] & HASH_SAMPLED)) {
+        return false;
+    }
+    *hash = chunk.sampleHash[slot];
+    return true;
+}
+
+bool VideoCatalog::fullHash(quint32 id, quint64 *hash) const
+{
+    QReadLocker locker(&m_lock);
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    if (!(chunk.hashFlags[slot] & HASH_FULL)) {
+        return false;
+    }
+    *hash = chunk.fullHash[slot];
+    return true;
+}
+
+void VideoCatalog::setSampleHash(quint32 id, quint64 hash)
+{
+    QWriteLocker locker(&m_lock);
+    Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    chunk.sampleHash[slot] = hash;
+    chunk.hashFlags[slot] |= HASH_SAMPLED;
+}
+
+void VideoCatalog::setFullHash(quint32 id, quint64 hash)
+{
+    QWriteLocker locker(&m_lock);
+    Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    chunk.fullHash[slot] = hash;
+    chunk.hashFlags[slot] |= HASH_FULL;
+}
+
+bool VideoCatalog::coverHash(quint32 id, quint64 *hash, qint64 *coverModifiedMs) const
+{
+    QReadLocker locker(&m_lock);
+    const Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    if (!(chunk.hashFlags[slot] & HASH_COVER)) {
+        return false;
+    }
+    *hash = chunk.coverHash[slot];
+    if (coverModifiedMs) {
+        *coverModifiedMs = chunk.coverModifiedMs[slot];
+    }
+    return true;
+}
+
+void VideoCatalog::setCoverHash(quint32 id, quint64 hash, qint64 coverModifiedMs)
+{
+    QWriteLocker locker(&m_lock);
+    Chunk &chunk = chunkOf(id);
+    const quint32 slot = id % CATALOG_CHUNK_SIZE;
+    chunk.coverHash[slot] = hash;
+    chunk.coverModifiedMs[slot] = coverModifiedMs;
+    chunk.hashFlags[slot] |= HASH_COVER;
+}
+
+void VideoCatalog::clearCoverHash(quint32 id)
+{
+    QWriteLocker locker(&m_lock);
+    Chunk &chunk = chunkOf(id);
+    chunk.hashFlags[id % CATALOG_CHUNK_SIZE] &= ~HASH_COVER;
+}
+
+VideoCatalog::Stats VideoCatalog::stats() const
+{
+    QReadLocker locker(&m_lock);
+
+    Stats stats;
+    stats.entries = m_count;
+    stats.liveEntries = m_liveEntries;
+    stats.freeEntries = m_freeIds.size();
+    stats.folders = m_folders.strings.size();
+    stats.terms = m_terms.strings.size();
+
+    // 条目块和文件名块按整块计算
+    stats.bytes += qint64(m_chunks.size()) * sizeof(Chunk);
+    stats.bytes += qint64(m_nameBlocks.size()) * NAME_BLOCK_SIZE * qint64(sizeof(char16_t));
+    stats.bytes += qint64(m_chunks.capacity() + m_nameBlocks.capacity()) * qint64(sizeof(void*));
+
+    // 文件夹表、词表和演员、类别的下标列表
+    stats.bytes += m_folders.bytes() + m_terms.bytes();
+    stats.bytes += (m_termLists.capacity() + m_freeIds.capacity()) * qint64(sizeof(quint32));
+
+    // 路径 -> ID 的哈希表
+    stats.bytes += m_idsByPath.capacity() * qint64(sizeof(size_t) + sizeof(void*))
+                 + m_idsByPath.size() * qint64(sizeof(quint32) + sizeof(void*));
+    return stats;
+}
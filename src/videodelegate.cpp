@@ -0,0 +1,227 @@
+#include "videodelegate.h"
+#include "videolistmodel.h"
+#include "concurrencycontroller.h"
+#include "videocatalog.h"
+#include <QCoreApplication>
+#include <QPainter>
+#include <QPixmapCache>
+#include <QPointer>
+
+VideoDelegate::VideoDelegate(QObject *parent)
+    : QStyledItemDelegate(parent),
+      m_thumbnailSize(240),
+      m_useFanartMode(false),
+      m_scrubVideo(nullptr),
+      m_scrubFrame(-1)
+{
+    // 默认10MB只够缓存几十张缩放后的封面
+    QPixmapCache::setCacheLimit(qMax(QPixmapCache::cacheLimit(), 256 * 1024));
+}
+
+VideoDelegate::~VideoDelegate()
+{
+    // 丢弃排队中的解码；已开始的任务经 QPointer 回送，本对象销毁后结果被忽略
+    ConcurrencyController::instance()->cancel(this);
+}
+
+void VideoDelegate::setThumbnailSize(int size)
+{
+    m_thumbnailSize = size;
+    clearScrubFrame();
+}
+
+void VideoDelegate::setUseFanartMode(bool useFanart)
+{
+    m_useFanartMode = useFanart;
+}
+
+void VideoDelegate::setScrubFrame(const VideoItem *video, const QPixmap &sheet, const QRect &source, int frame)
+{
+    m_scrubVideo = video;
+    m_scrubSheet = sheet;
+    m_scrubSource = source;
+    m_scrubFrame = frame;
+}
+
+void VideoDelegate::clearScrubFrame()
+{
+    m_scrubVideo = nullptr;
+    m_scrubSheet = QPixmap();
+    m_scrubSource = QRect();
+    m_scrubFrame = -1;
+}
+
+QString VideoDelegate::cacheKey(quint32 videoId, bool fanart, int thumbnailSize)
+{
+    // 用视频 ID 而不是路径作键，不必每次绘制都拼接路径；ID 在重新扫描后不变，缓存继续有效。
+    // 回收的 ID 分给其他文件时代数改变，旧的封面不会被误用
+    return QString("cover|%1|%2|%3|%4").arg(fanart ? 'f' : 'p').arg(thumbnailSize).arg(videoId)
+                                       .arg(VideoCatalog::instance()->generation(videoId));
+}
+
+void VideoDelegate::invalidate(quint32 videoId)
+{
+    invalidate(videoId, m_thumbnailSize);
+}
+
+void VideoDelegate::invalidate(quint32 videoId, int thumbnailSize)
+{
+    QPixmapCache::remove(cacheKey(videoId, false, thumbnailSize));
+    QPixmapCache::remove(cacheKey(videoId, true, thumbnailSize));
+}
+
+QPixmap VideoDelegate::scaledCover(const std::shared_ptr<VideoItem> &video) const
+{
+    QString key = cacheKey(video->id(), m_useFanartMode, m_thumbnailSize);
+    QPixmap scaled;
+    if (QPixmapCache::find(key, &scaled)) {
+        return scaled;
+    }
+
+    // 根据当前模式选择要显示的图片；界面线程不解码，尚未解码或尺寸不够时在后台解码
+    const int decodedSize = video->coverSize(m_useFanartMode);
+    if (decodedSize < m_thumbnailSize) {
+        requestCover(video, m_useFanartMode);
+        if (decodedSize == 0) {
+            return placeholder();
+        }
+    }
+    const QPixmap &source = m_useFanartMode ? video->fanartImage() : video->posterImage();
+    scaled = source.scaled(m_thumbnailSize, m_thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // 放大缩略图后暂时用较小的图片，不缓存，解码完成后再缓存
+    if (decodedSize >= m_thumbnailSize) {
+        QPixmapCache::insert(key, scaled);
+    }
+    return scaled;
+}
+
+void VideoDelegate::requestCover(const std::shared_ptr<VideoItem> &video, bool fanart) const
+{
+    const quint64 request = quint64(video->id()) * 2 + (fanart ? 1 : 0);
+    if (m_decoding.contains(request)) {
+        return;
+    }
+    m_decoding.insert(request);
+
+    // 工作线程不持有视频对象（其中的 QPixmap 只能在界面线程释放），回到界面线程后再取
+    QPointer<VideoDelegate> self(const_cast<VideoDelegate*>(this));
+    std::weak_ptr<VideoItem> weak = video;
+    const QString folderPath = video->folderPath();
+    const QString fileName = video->fileName();
+    const int size = m_thumbnailSize;
+    ConcurrencyController::instance()->submit(video->filePath(), WorkloadKind::CoverDecode,
+                                              [self, weak, folderPath, fileName, fanart, size, request]() {
+        const QImage image = VideoItem::readCover(folderPath, fileName, fanart, size);
+
+        QMetaObject::invokeMethod(qApp, [self, weak, image, fanart, size, request]() {
+            if (!self) {
+                return;
+            }
+            self->m_decoding.remove(request);
+            if (std::shared_ptr<VideoItem> video = weak.lock()) {
+                video->setCover(fanart, image, size);
+            }
+            // 视频已释放时也通知：ID 可能已分给其他视频，它的解码请求在此期间被合并掉了，重绘时再次请求
+            emit self->coverDecoded(quint32(request / 2));
+        }, Qt::QueuedConnection);
+    }, this);
+}
+
+QPixmap VideoDelegate::placeholder() const
+{
+    // 海报比例的灰色方块，封面解码完成前显示
+    const QString key = QString("cover|placeholder|%1").arg(m_thumbnailSize);
+    QPixmap pixmap;
+    if (!QPixmapCache::find(key, &pixmap)) {
+        pixmap = QPixmap(m_thumbnailSize * 2 / 3, m_thumbnailSize);
+        pixmap.fill(QColor(70, 70, 75));
+        QPixmapCache::insert(key, pixmap);
+    }
+    return pixmap;
+}
+
+QSize VideoDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(option);
+    Q_UNUSED(index);
+    return cellSize();
+}
+
+void VideoDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const AbstractVideoModel *model = qobject_cast<const AbstractVideoModel*>(index.model());
+    std::shared_ptr<VideoItem> video = model ? model->videoAt(index.row()) : nullptr;
+    if (!video) {
+        return;
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+    const QRect cell = option.rect;
+    const bool hover = option.state & QStyle::State_MouseOver;
+    const bool selected = option.state & QStyle::State_Selected;
+
+    // 绘制缩略图背景 - 在深色主题中添加浅灰色背景
+    painter->fillRect(cell.left(), cell.top(), m_thumbnailSize, m_thumbnailSize, QColor(50, 50, 55));
+
+    if (hover && m_scrubVideo == video.get() && !m_scrubSheet.isNull()) {
+        // 悬停预览：从已解码的雪碧图中截取当前帧，不再缩放封面
+        int frameW = m_scrubSource.width();
+        int frameH = m_scrubSource.height();
+        int fx = cell.left() + (m_thumbnailSize - frameW) / 2;
+        int fy = cell.top() + (m_thumbnailSize - frameH) / 2;
+
+        painter->drawPixmap(QPoint(fx, fy), m_scrubSheet, m_scrubSource);
+
+        painter->setPen(QPen(QColor(0, 120, 215), 2));
+        painter->drawRect(fx - 1, fy - 1, frameW + 2, frameH + 2);
+
+        // 底部进度条指示当前预览位置
+        int progressW = frameW * (m_scrubFrame + 1) / SPRITE_FRAME_COUNT;
+        painter->fillRect(fx, fy + frameH - 4, progressW, 4, QColor(0, 120, 215));
+    } else {
+        QPixmap image = scaledCover(video);
+        int x = cell.left() + (m_thumbnailSize - image.width()) / 2;
+        int y = cell.top() + (m_thumbnailSize - image.height()) / 2;
+
+        // 绘制边框
+        if (hover) {
+            // 在深色主题中使用亮蓝色边框
+            painter->setPen(QPen(QColor(0, 120, 215), 2));
+            painter->drawRect(x - 1, y - 1, image.width() + 2, image.height() + 2);
+        } else if (selected) {
+            // 使用高亮橙色边框表示选中状态
+            painter->setPen(QPen(QColor(255, 165, 0), 3));
+            painter->drawRect(x - 2, y - 2, image.width() + 4, image.height() + 4);
+        }
+
+        painter->drawPixmap(x, y, image);
+
+        // 绘制播放图标
+        if (hover) {
+            static const QPixmap playIcon = QPixmap(":/icons/play.png").scaled(48, 48, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            int iconX = cell.left() + (cell.width() - playIcon.width()) / 2;
+            int iconY = cell.top() + (m_thumbnailSize - playIcon.height()) / 2;
+            painter->drawPixmap(iconX, iconY, playIcon);
+        }
+
+        // 封面提取失败时在右上角显示警告标记
+        if (video->hasPosterFailure()) {
+            QRect badge(x + image.width() - 22, y + 4, 18, 18);
+            painter->setPen(Qt::NoPen);
+            painter->setBrush(QColor(200, 60, 60));
+            painter->drawEllipse(badge);
+            painter->setPen(Qt::white);
+            painter->drawText(badge, Qt::AlignCenter, "!");
+        }
+    }
+
+    // 绘制标题
+    QRect titleRect(cell.left() + 5, cell.top() + m_thumbnailSize + 5, m_thumbnailSize, 25);
+    painter->setPen(QColor(0xE1, 0xE1, 0xE1));
+    painter->drawText(titleRect, Qt::AlignCenter | Qt::TextWordWrap, video->fileName());
+
+    painter->restore();
+}
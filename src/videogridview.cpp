@@ -0,0 +1,742 @@
+#include "videogridview.h"
+#include "videolistmodel.h"
+#include "videodelegate.h"
+#include "concurrencycontroller.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QImageReader>
+#include <QPointer>
+#include <QApplication>
+#include <QDebug>
+#include <algorithm>
+
+// 单元格之间的间距
+static const int GRID_SPACING = 10;
+
+// 合并布局请求的间隔（约一帧）
+static const int LAYOUT_COALESCE_MS = 16;
+
+// 网格背景色（与样式表一致），行条缓存的上限（KB）
+static const QColor GRID_BACKGROUND(0x2D, 0x2D, 0x30);
+static const int STRIP_CACHE_LIMIT_KB = 64 * 1024;
+
+VideoGridView::VideoGridView(AbstractVideoModel *model, QWidget *parent)
+    : QAbstractItemView(parent),
+      m_model(model),
+      m_delegate(new VideoDelegate(this)),
+      m_columns(1),
+      m_hoverScrubEnabled(false),
+      m_stripCacheEnabled(true),
+      m_strips(STRIP_CACHE_LIMIT_KB),
+      m_spriteRequested(false),
+      m_spriteLoading(false),
+      m_scrubFrame(-1)
+{
+    setModel(m_model);
+    setItemDelegate(m_delegate);
+
+    setSelectionMode(QAbstractItemView::ExtendedSelection);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    setFrameShape(QFrame::NoFrame);
+    setStyleSheet("QAbstractItemView { background-color: #2D2D30; border: none; }");
+
+    // 启用鼠标追踪以便接收悬停事件
+    setMouseTracking(true);
+
+    // 同一帧内的多次尺寸或行数变化合并为一次布局
+    m_layoutTimer.setSingleShot(true);
+    m_layoutTimer.setInterval(LAYOUT_COALESCE_MS);
+    connect(&m_layoutTimer, &QTimer::timeout, this, &VideoGridView::doLayout);
+
+    // 行数变化只影响滚动范围，已有单元格的位置由行号直接算出
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &VideoGridView::scheduleLayout);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, &VideoGridView::scheduleLayout);
+    connect(m_model, &QAbstractItemModel::modelReset, this, &VideoGridView::scheduleLayout);
+    connect(m_model, &QAbstractItemModel::layoutChanged, this, &VideoGridView::scheduleLayout);
+
+    // 行的增删、重置或重新排序后，已绘制的行条全部失效；单元格内容变化只重绘该单元格
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &VideoGridView::clearStripCache);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, &VideoGridView::clearStripCache);
+    connect(m_model, &QAbstractItemModel::modelReset, this, &VideoGridView::clearStripCache);
+    connect(m_model, &QAbstractItemModel::layoutChanged, this, &VideoGridView::clearStripCache);
+    connect(m_model, &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        invalidateRows(topLeft.row(), bottomRight.row());
+    });
+
+    // 后台解码的封面到达后只重绘该单元格（同时使所在行条失效）
+    connect(m_delegate, &VideoDelegate::coverDecoded, this, [this](quint32 videoId) {
+        m_model->videoChanged(videoId);
+    });
+
+    // 选择模型重置时不会发出 selectionChanged，移除行时也不保证发出，这里自行同步
+    connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &VideoGridView::onRowsAboutToBeRemoved);
+    connect(m_model, &QAbstractItemModel::modelReset, this, &VideoGridView::onModelReset);
+
+    // 双击时播放视频
+    connect(this, &QAbstractItemView::doubleClicked, this, [this](const QModelIndex &index) {
+        std::shared_ptr<VideoItem> video = m_model->videoAt(index.row());
+        if (video) {
+            video->play();
+        }
+    });
+
+    doLayout();
+}
+
+QSize VideoGridView::gridSize() const
+{
+    QSize cell = m_delegate->cellSize();
+    return QSize(cell.width() + GRID_SPACING, cell.height() + GRID_SPACING);
+}
+
+void VideoGridView::scheduleLayout()
+{
+    if (!m_layoutTimer.isActive()) {
+        m_layoutTimer.start();
+    }
+}
+
+void VideoGridView::doLayout()
+{
+    m_layoutTimer.stop();
+    updateGeometries();
+    // 列数或宽度可能已变化，行条需要按新布局重绘
+    clearStripCache();
+    viewport()->update();
+}
+
+void VideoGridView::updateGeometries()
+{
+    // 只重新计算列数和滚动范围，与视频数量无关
+    const QSize grid = gridSize();
+    m_columns = std::max(1, viewport()->width() / std::max(1, grid.width()));
+
+    const int rowCount = m_model->rowCount();
+    const int lines = (rowCount + m_columns - 1) / m_columns;
+    const int contentHeight = lines * grid.height();
+
+    verticalScrollBar()->setSingleStep(std::max(1, grid.height() / 4));
+    verticalScrollBar()->setPageStep(viewport()->height());
+    verticalScrollBar()->setRange(0, std::max(0, contentHeight - viewport()->height()));
+
+    QAbstractItemView::updateGeometries();
+}
+
+void VideoGridView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractItemView::resizeEvent(event);
+    scheduleLayout();
+}
+
+QRect VideoGridView::cellRect(int row) const
+{
+    const QSize grid = gridSize();
+    const int line = row / m_columns;
+    const int column = row % m_columns;
+    return QRect(column * grid.width() + GRID_SPACING / 2,
+                 line * grid.height() + GRID_SPACING / 2 - verticalOffset(),
+                 grid.width() - GRID_SPACING,
+                 grid.height() - GRID_SPACING);
+}
+
+QRect VideoGridView::visualRect(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.row() >= m_model->rowCount()) {
+        return QRect();
+    }
+    return cellRect(index.row());
+}
+
+void VideoGridView::visibleRange(int *first, int *last) const
+{
+    const int lineHeight = std::max(1, gridSize().height());
+    const int firstLine = verticalOffset() / lineHeight;
+    const int lastLine = (verticalOffset() + viewport()->height()) / lineHeight;
+    *first = firstLine * m_columns;
+    *last = std::min(m_model->rowCount() - 1, (lastLine + 1) * m_columns - 1);
+}
+
+QModelIndex VideoGridView::indexAt(const QPoint &point) const
+{
+    const QSize grid = gridSize();
+    if (point.x() < 0 || point.y() < 0) {
+        return QModelIndex();
+    }
+    const int column = point.x() / grid.width();
+    const int line = (point.y() + verticalOffset()) / grid.height();
+    if (column >= m_columns) {
+        return QModelIndex();
+    }
+
+    const int row = line * m_columns + column;
+    if (row >= m_model->rowCount() || !cellRect(row).contains(point)) {
+        return QModelIndex();
+    }
+    return m_model->index(row);
+}
+
+void VideoGridView::scrollTo(const QModelIndex &index, ScrollHint hint)
+{
+    QRect rect = visualRect(index);
+    if (rect.isNull()) {
+        return;
+    }
+
+    const int viewHeight = viewport()->height();
+    int value = verticalScrollBar()->value();
+    if (hint == PositionAtTop || (hint == EnsureVisible && rect.top() < 0)) {
+        value += rect.top() - GRID_SPACING / 2;
+    } else if (hint == PositionAtBottom || (hint == EnsureVisible && rect.bottom() > viewHeight)) {
+        value += rect.bottom() - viewHeight + GRID_SPACING / 2;
+    } else if (hint == PositionAtCenter) {
+        value += rect.center().y() - viewHeight / 2;
+    }
+    verticalScrollBar()->setValue(value);
+}
+
+QModelIndex VideoGridView::moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers)
+{
+    Q_UNUSED(modifiers);
+
+    const int rowCount = m_model->rowCount();
+    if (rowCount == 0) {
+        return QModelIndex();
+    }
+
+    QModelIndex current = currentIndex();
+    int row = current.isValid() ? current.row() : 0;
+    const int linesPerPage = std::max(1, viewport()->height() / std::max(1, gridSize().height()));
+
+    switch (cursorAction) {
+        case MoveLeft:
+        case MovePrevious:
+            row -= 1;
+            break;
+        case MoveRight:
+        case MoveNext:
+            row += 1;
+            break;
+        case MoveUp:
+            row -= m_columns;
+            break;
+        case MoveDown:
+            row += m_columns;
+            break;
+        case MovePageUp:
+            row -= m_columns * linesPerPage;
+            break;
+        case MovePageDown:
+            row += m_columns * linesPerPage;
+            break;
+        case MoveHome:
+            row = 0;
+            break;
+        case MoveEnd:
+            row = rowCount - 1;
+            break;
+    }
+    return m_model->index(qBound(0, row, rowCount - 1));
+}
+
+int VideoGridView::horizontalOffset() const
+{
+    return 0;
+}
+
+int VideoGridView::verticalOffset() const
+{
+    return verticalScrollBar()->value();
+}
+
+bool VideoGridView::isIndexHidden(const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+    return false;
+}
+
+int VideoGridView::nearestRow(const QPoint &point) const
+{
+    const int rowCount = m_model->rowCount();
+    if (rowCount == 0) {
+        return -1;
+    }
+    const QSize grid = gridSize();
+    const int column = qBound(0, point.x() / std::max(1, grid.width()), m_columns - 1);
+    const int line = std::max(0, (point.y() + verticalOffset()) / std::max(1, grid.height()));
+    return std::min(rowCount - 1, line * m_columns + column);
+}
+
+void VideoGridView::setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command)
+{
+    // rect 由锚点和当前位置构成（未规范化，左上角即锚点）。
+    // 网格按行号线性排列，Shift 选择和拖动选择都取两端之间的连续行，
+    // 整段只占一个选择区间，与选中数量无关
+    int anchor = nearestRow(rect.topLeft());
+    int current = nearestRow(rect.bottomRight());
+    if (anchor < 0 || current < 0) {
+        selectionModel()->select(QItemSelection(), command);
+        return;
+    }
+
+    QItemSelection selection(m_model->index(std::min(anchor, current)),
+                             m_model->index(std::max(anchor, current)));
+    selectionModel()->select(selection, command);
+}
+
+QRegion VideoGridView::visualRegionForSelection(const QItemSelection &selection) const
+{
+    // 只计算可见范围内的选中单元格
+    int first = 0;
+    int last = -1;
+    visibleRange(&first, &last);
+
+    QRegion region;
+    for (const QItemSelectionRange &range : selection) {
+        const int top = std::max(range.top(), first);
+        const int bottom = std::min(range.bottom(), last);
+        for (int row = top; row <= bottom; ++row) {
+            region += cellRect(row);
+        }
+    }
+    return region;
+}
+
+void VideoGridView::paintCell(QPainter *painter, int row, const QRect &rect, bool hover) const
+{
+    QStyleOptionViewItem option;
+    initViewItemOption(&option);
+    option.rect = rect;
+    option.state = QStyle::State_Enabled;
+    std::shared_ptr<VideoItem> video = m_model->videoAt(row);
+    if (video && m_selectedIds.contains(video->id())) {
+        option.state |= QStyle::State_Selected;
+    }
+    if (hover) {
+        option.state |= QStyle::State_MouseOver;
+    }
+    m_delegate->paint(painter, option, m_model->index(row));
+}
+
+QPixmap* VideoGridView::stripPixmap(int line)
+{
+    if (QPixmap *strip = m_strips.object(line)) {
+        return strip;
+    }
+
+    // 按设备像素比绘制一整行单元格（不含悬停状态）
+    const QSize grid = gridSize();
+    const qreal ratio = viewport()->devicePixelRatioF();
+    QPixmap *strip = new QPixmap(QSize(viewport()->width(), grid.height()) * ratio);
+    strip->setDevicePixelRatio(ratio);
+    strip->fill(GRID_BACKGROUND);
+
+    QPainter painter(strip);
+    const int first = line * m_columns;
+    const int last = std::min(m_model->rowCount() - 1, first + m_columns - 1);
+    const int top = line * grid.height() - verticalOffset();
+    for (int row = first; row <= last; ++row) {
+        paintCell(&painter, row, cellRect(row).translated(0, -top), false);
+    }
+    painter.end();
+
+    const int costKb = std::max(1, strip->width() * strip->height() * strip->depth() / 8 / 1024);
+    m_strips.insert(line, strip, costKb);
+    return m_strips.object(line);
+}
+
+void VideoGridView::invalidateRows(int first, int last)
+{
+    if (m_strips.isEmpty() || first > last) {
+        return;
+    }
+    // 大范围变化（如全选）直接丢弃所有行条，否则逐个单元格标记
+    int visibleFirst = 0;
+    int visibleLast = -1;
+    visibleRange(&visibleFirst, &visibleLast);
+    if (last - first > 2 * (visibleLast - visibleFirst + 1)) {
+        clearStripCache();
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        m_dirtyRows.insert(row);
+    }
+}
+
+void VideoGridView::clearStripCache()
+{
+    m_strips.clear();
+    m_dirtyRows.clear();
+}
+
+void VideoGridView::setStripCacheEnabled(bool enabled)
+{
+    m_stripCacheEnabled = enabled;
+    clearStripCache();
+    viewport()->update();
+}
+
+void VideoGridView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    int first = 0;
+    int last = -1;
+    visibleRange(&first, &last);
+
+    if (!m_stripCacheEnabled) {
+        // 直接绘制可见的单元格
+        for (int row = first; row <= last; ++row) {
+            paintCell(&painter, row, cellRect(row), m_model->index(row) == m_hoverIndex);
+        }
+        return;
+    }
+
+    const QSize grid = gridSize();
+
+    // 先把标记为失效的单元格重绘到已缓存的行条上，其余行条保持不变
+    for (int row : qAsConst(m_dirtyRows)) {
+        if (row >= m_model->rowCount()) {
+            continue;
+        }
+        const int line = row / m_columns;
+        QPixmap *strip = m_strips.object(line);
+        if (!strip) {
+            continue;
+        }
+        const QRect rect = cellRect(row).translated(0, -(line * grid.height() - verticalOffset()));
+        QPainter stripPainter(strip);
+        stripPainter.fillRect(rect.adjusted(-GRID_SPACING / 2, -GRID_SPACING / 2,
+                                            GRID_SPACING / 2, GRID_SPACING / 2), GRID_BACKGROUND);
+        paintCell(&stripPainter, row, rect, false);
+    }
+    m_dirtyRows.clear();
+
+    // 只拼接与重绘区域相交的行条
+    painter.fillRect(event->rect(), GRID_BACKGROUND);
+    if (last >= first) {
+        const int firstLine = first / m_columns;
+        const int lastLine = last / m_columns;
+        for (int line = firstLine; line <= lastLine; ++line) {
+            const int top = line * grid.height() - verticalOffset();
+            if (top + grid.height() <= event->rect().top() || top > event->rect().bottom()) {
+                continue;
+            }
+            if (QPixmap *strip = stripPixmap(line)) {
+                painter.drawPixmap(0, top, *strip);
+            }
+        }
+    }
+
+    // 悬停中的单元格（边框、播放图标、预览帧）实时绘制在行条之上
+    if (m_hoverIndex.isValid() && m_hoverIndex.row() >= first && m_hoverIndex.row() <= last) {
+        const QRect rect = cellRect(m_hoverIndex.row());
+        painter.fillRect(rect, GRID_BACKGROUND);
+        paintCell(&painter, m_hoverIndex.row(), rect, true);
+    }
+}
+
+void VideoGridView::selectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
+{
+    const int before = m_selectedIds.size();
+    updateSelectedIds(deselected, false);
+    updateSelectedIds(selected, true);
+
+    // 选中状态绘制在行条中，只重绘状态变化的单元格
+    for (const QItemSelection *changed : {&selected, &deselected}) {
+        for (const QItemSelectionRange &range : *changed) {
+            invalidateRows(range.top(), range.bottom());
+        }
+    }
+
+    // 基类只重绘变化部分（visualRegionForSelection 限定在可见范围内）
+    QAbstractItemView::selectionChanged(selected, deselected);
+
+    if (m_selectedIds.size() != before) {
+        emit selectedCountChanged(m_selectedIds.size());
+    }
+}
+
+void VideoGridView::updateSelectedIds(const QItemSelection &selection, bool selected)
+{
+    for (const QItemSelectionRange &range : selection) {
+        for (int row = range.top(); row <= range.bottom(); ++row) {
+            std::shared_ptr<VideoItem> video = m_model->videoAt(row);
+            if (!video) {
+                continue;
+            }
+            if (selected) {
+                m_selectedIds.insert(video->id());
+            } else {
+                m_selectedIds.remove(video->id());
+            }
+        }
+    }
+}
+
+void VideoGridView::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+    if (m_selectedIds.isEmpty()) {
+        return;
+    }
+
+    const int before = m_selectedIds.size();
+    for (int row = first; row <= last; ++row) {
+        std::shared_ptr<VideoItem> video = m_model->videoAt(row);
+        if (video) {
+            m_selectedIds.remove(video->id());
+        }
+    }
+    if (m_selectedIds.size() != before) {
+        emit selectedCountChanged(m_selectedIds.size());
+    }
+}
+
+void VideoGridView::onModelReset()
+{
+    // 选择按 ID 记录：重置（重新排序、过滤）后保留仍在模型中的视频
+    const int before = m_selectedIds.size();
+    for (auto it = m_selectedIds.begin(); it != m_selectedIds.end();) {
+        if (m_model->rowOf(*it) < 0) {
+            it = m_selectedIds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_selectedIds.size() != before) {
+        emit selectedCountChanged(m_selectedIds.size());
+    }
+}
+
+QVector<std::shared_ptr<VideoItem>> VideoGridView::selectedVideos() const
+{
+    // 只访问选中的视频：ID -> 可见行为 O(1)，再按行号排序
+    QVector<QPair<int, std::shared_ptr<VideoItem>>> rows;
+    rows.reserve(m_selectedIds.size());
+    for (quint32 id : m_selectedIds) {
+        int row = m_model->rowOf(id);
+        if (row >= 0) {
+            rows.append(qMakePair(row, m_model->videoAt(row)));
+        }
+    }
+    std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    QVector<std::shared_ptr<VideoItem>> videos;
+    videos.reserve(rows.size());
+    for (const auto &row : rows) {
+        videos.append(row.second);
+    }
+    return videos;
+}
+
+void VideoGridView::setHoverIndex(const QModelIndex &index)
+{
+    if (index == m_hoverIndex) {
+        return;
+    }
+    if (m_hoverIndex.isValid()) {
+        update(m_hoverIndex);
+    }
+    m_hoverIndex = QPersistentModelIndex(index);
+    if (m_hoverIndex.isValid()) {
+        update(m_hoverIndex);
+    }
+}
+
+void VideoGridView::setThumbnailSize(int size)
+{
+    // 雪碧图按缩略图尺寸解码，尺寸变化后需要重新解码
+    resetScrub();
+    m_delegate->setThumbnailSize(size);
+    doLayout();
+}
+
+void VideoGridView::setUseFanartMode(bool useFanart)
+{
+    m_delegate->setUseFanartMode(useFanart);
+    clearStripCache();
+    viewport()->update();
+}
+
+void VideoGridView::setHoverScrubEnabled(bool enabled)
+{
+    m_hoverScrubEnabled = enabled;
+    if (!enabled) {
+        // 关闭时释放已解码的雪碧图
+        resetScrub();
+    }
+}
+
+void VideoGridView::refreshVideo(quint32 videoId)
+{
+    m_delegate->invalidate(videoId);
+    m_model->videoChanged(videoId);
+}
+
+void VideoGridView::resetScrub()
+{
+    if (m_scrubIndex.isValid()) {
+        update(m_scrubIndex);
+    }
+    m_scrubVideo.reset();
+    m_scrubIndex = QPersistentModelIndex();
+    m_spriteRequested = false;
+    m_spriteSheet = QPixmap();
+    m_scrubFrame = -1;
+    m_delegate->clearScrubFrame();
+}
+
+void VideoGridView::applyScrubFrame()
+{
+    if (m_spriteSheet.isNull() || m_scrubFrame < 0 || !m_scrubVideo) {
+        return;
+    }
+
+    QRect source(m_scrubFrame * m_spriteFrameSize.width(), 0,
+                 m_spriteFrameSize.width(), m_spriteFrameSize.height());
+    m_delegate->setScrubFrame(m_scrubVideo.get(), m_spriteSheet, source, m_scrubFrame);
+    update(m_scrubIndex);
+}
+
+void VideoGridView::reloadSpriteSheet(quint32 videoId)
+{
+    if (!m_scrubVideo || m_scrubVideo->id() != videoId) {
+        return;
+    }
+    m_spriteRequested = false;
+    m_spriteSheet = QPixmap();
+    startSpriteDecode();
+}
+
+// 在工作线程中按缩略图尺寸直接解码整张雪碧图，拖动时只需要从中截取一帧贴图
+static QImage decodeSpriteSheet(const QString &path, int thumbnailSize, QSize *frameSize)
+{
+    QImageReader reader(path);
+    QSize sheetSize = reader.size();
+    if (!sheetSize.isValid()) {
+        return QImage();
+    }
+
+    QSize sourceFrame(sheetSize.width() / SPRITE_FRAME_COUNT, sheetSize.height());
+    QSize scaledFrame = sourceFrame.scaled(thumbnailSize, thumbnailSize, Qt::KeepAspectRatio);
+    if (scaledFrame.isEmpty()) {
+        return QImage();
+    }
+    reader.setScaledSize(QSize(scaledFrame.width() * SPRITE_FRAME_COUNT, scaledFrame.height()));
+
+    QImage sheet = reader.read();
+    if (sheet.isNull()) {
+        qDebug() << "无法加载雪碧图:" << path << reader.errorString();
+        return QImage();
+    }
+
+    *frameSize = scaledFrame;
+    return sheet;
+}
+
+void VideoGridView::startSpriteDecode()
+{
+    if (!m_scrubVideo || m_spriteLoading) {
+        return;
+    }
+
+    QString path = m_scrubVideo->spriteSheetPath();
+    if (!QFileInfo::exists(path)) {
+        return;
+    }
+
+    m_spriteLoading = true;
+    QPointer<VideoGridView> self(this);
+    const VideoItem *video = m_scrubVideo.get();
+    int thumbnailSize = m_delegate->thumbnailSize();
+    ConcurrencyController::instance()->submit(path, WorkloadKind::CoverDecode, [self, video, path, thumbnailSize]() {
+        QSize frameSize;
+        QImage sheet = decodeSpriteSheet(path, thumbnailSize, &frameSize);
+
+        // QPixmap 只能在主线程创建
+        QMetaObject::invokeMethod(qApp, [self, video, sheet, frameSize, thumbnailSize]() {
+            if (self) {
+                self->onSpriteSheetDecoded(video, sheet, frameSize, thumbnailSize);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void VideoGridView::onSpriteSheetDecoded(const VideoItem *video, const QImage &sheet, const QSize &frameSize, int thumbnailSize)
+{
+    m_spriteLoading = false;
+
+    // 解码期间鼠标已移到其他视频，或缩略图尺寸已变化
+    if (!m_scrubVideo || video != m_scrubVideo.get()) {
+        startSpriteDecode();
+        return;
+    }
+    if (thumbnailSize != m_delegate->thumbnailSize()) {
+        startSpriteDecode();
+        return;
+    }
+
+    if (sheet.isNull()) {
+        // 解码失败，等待重新生成后的通知再重试
+        m_spriteRequested = true;
+        return;
+    }
+
+    m_spriteSheet = QPixmap::fromImage(sheet);
+    m_spriteFrameSize = frameSize;
+    applyScrubFrame();
+}
+
+void VideoGridView::mouseMoveEvent(QMouseEvent *event)
+{
+    QAbstractItemView::mouseMoveEvent(event);
+
+    QPoint pos = event->position().toPoint();
+    QModelIndex index = indexAt(pos);
+    setHoverIndex(index);
+    if (!m_hoverScrubEnabled) {
+        return;
+    }
+
+    std::shared_ptr<VideoItem> video = index.isValid() ? m_model->videoAt(index.row()) : nullptr;
+
+    // 鼠标移到了另一个视频上
+    if (video != m_scrubVideo) {
+        resetScrub();
+        m_scrubVideo = video;
+        m_scrubIndex = QPersistentModelIndex(index);
+    }
+    if (!video) {
+        return;
+    }
+
+    if (m_spriteSheet.isNull() && !m_spriteLoading && !m_spriteRequested) {
+        if (QFileInfo::exists(video->spriteSheetPath())) {
+            startSpriteDecode();
+        } else {
+            // 雪碧图尚未生成，请求后台生成，完成后通过 reloadSpriteSheet 通知
+            m_spriteRequested = true;
+            emit spriteSheetRequested(video->id());
+        }
+    }
+
+    int thumbnailSize = m_delegate->thumbnailSize();
+    int x = qBound(0, pos.x() - visualRect(index).left(), thumbnailSize - 1);
+    int frame = x * SPRITE_FRAME_COUNT / thumbnailSize;
+    if (frame != m_scrubFrame) {
+        m_scrubFrame = frame;
+        applyScrubFrame();
+    }
+}
+
+void VideoGridView::leaveEvent(QEvent *event)
+{
+    setHoverIndex(QModelIndex());
+    resetScrub();
+    QAbstractItemView::leaveEvent(event);
+}
@@ -1,144 +1,333 @@
 #include "videoitem.h"
+#include "videosearch.h"
+#include "videocatalog.h"
 #include <QDesktopServices>
 #include <QUrl>
 #include <QDir>
 #include <QDebug>
+#include <QMutex>
+#include <QImageReader>
+#include <QPixmapCache>
+#include <limits>
 #include <Windows.h>
 #include <shellapi.h>
 
-VideoItem::VideoItem(const QString &filePath, bool loadImagesNow)
-    : m_filePath(filePath),
-      m_fileSize(0),
-      m_imagesLoaded(false),
-      m_needsPosterGeneration(false)
+// 生成自然顺序的排序键：折叠大小写，数字串去掉前导零后在前面加上表示长度的字符，
+// 这样按字符比较时数字按数值大小排列（ABP-2 < ABP-10）
+static QString naturalSortKey(const QString &name)
 {
-    QFileInfo fileInfo(filePath);
-    m_fileName = fileInfo.fileName();
-    m_folderPath = fileInfo.path();
-    m_fileSize = fileInfo.size();
-    m_creationTime = fileInfo.birthTime();
-    m_modifiedTime = fileInfo.lastModified();
+    QString folded = name.toCaseFolded();
+    QString key;
+    key.reserve(folded.size() + 8);
+
+    int i = 0;
+    while (i < folded.size()) {
+        if (!folded.at(i).isDigit()) {
+            key.append(folded.at(i));
+            ++i;
+            continue;
+        }
 
-    // 只在需要时加载图片
-    if (loadImagesNow) {
-        loadImages();
+        int start = i;
+        while (i < folded.size() && folded.at(i).isDigit()) {
+            ++i;
+        }
+        // 去掉前导零（至少保留一位）
+        while (start < i - 1 && folded.at(start) == QLatin1Char('0')) {
+            ++start;
+        }
+        int length = qMin(i - start, 40);
+        key.append(QChar(u'0' + length));
+        key.append(QStringView(folded).mid(start, length));
     }
+    return key;
 }
 
-void VideoItem::loadImages()
+VideoItem::VideoItem(const QString &filePath)
+    : m_id(0),
+      m_hasPendingPoster(0),
+      m_needsPosterGeneration(false),
+      m_posterFailureAttempts(0)
 {
-    // 强制重新加载图片，不再检查m_imagesLoaded
-    // 这样可以确保在生成新封面后能够重新加载
-    m_imagesLoaded = false;
+    QFileInfo fileInfo(filePath);
+    initialize(fileInfo.path(), fileInfo.fileName(), fileInfo.size(),
+               fileInfo.birthTime().toMSecsSinceEpoch(),
+               fileInfo.lastModified().toMSecsSinceEpoch());
+}
 
-    QDir folder(m_folderPath);
+VideoItem::VideoItem(const QString &folderPath, const QString &fileName,
+                     qint64 fileSize, qint64 creationMs, qint64 modifiedMs)
+    : m_id(0),
+      m_hasPendingPoster(0),
+      m_needsPosterGeneration(false),
+      m_posterFailureAttempts(0)
+{
+    initialize(folderPath, fileName, fileSize, creationMs, modifiedMs);
+}
 
-    // 查找海报图片
-    QString posterPath = folder.filePath("poster.jpg");
-    if (QFileInfo::exists(posterPath)) {
-        m_posterImage = QPixmap(posterPath);
-        if (m_posterImage.isNull()) {
-            qDebug() << "无法加载海报图片:" << posterPath;
-            createDefaultPoster();
+void VideoItem::initialize(const QString &folderPath, const QString &fileName,
+                           qint64 fileSize, qint64 creationMs, qint64 modifiedMs)
+{
+    // 路径、大小和时间（毫秒，同时作为排序键）存入目录，条目下标即视频 ID
+    VideoCatalog *catalog = VideoCatalog::instance();
+    m_id = catalog->acquire(folderPath, fileName, fileSize, creationMs, modifiedMs);
+
+    // 预先计算排序键和搜索键，避免每次排序、搜索都重新折叠大小写和解析番号；
+    // 沿用 ID 的条目已经算过
+    if (!catalog->hasSearchKeys(m_id)) {
+        const QString codeKey = VideoSearchQuery::normalizeCode(QFileInfo(fileName).completeBaseName());
+        QString searchText = fileName.toCaseFolded();
+        if (!codeKey.isEmpty()) {
+            searchText += QLatin1Char('\n') + codeKey.toCaseFolded();
         }
-    } else {
-        // 先检查picture文件夹中是否有提取的封面图
-        QDir rootDir(QFileInfo(m_folderPath).absolutePath());
-        QString pictureDir = rootDir.filePath("picture");
-
-        if (QDir(pictureDir).exists()) {
-            QString baseName = QFileInfo(m_fileName).completeBaseName();
-            QString extractedPosterPath = QDir(pictureDir).filePath(baseName + ".jpg");
-
-            if (QFileInfo::exists(extractedPosterPath)) {
-                QPixmap extractedPoster(extractedPosterPath);
-                if (!extractedPoster.isNull()) {
-                    // 同时将提取的封面图设置为海报图和背景图
-                    m_posterImage = extractedPoster;
-                    m_fanartImage = extractedPoster;  // 同时用于背景图
-                    qDebug() << "加载提取的封面图(同时用于海报和背景):" << extractedPosterPath;
-                    m_imagesLoaded = true;
-                    return;
-                }
+        catalog->setSearchKeys(m_id, searchText, codeKey.size(), naturalSortKey(fileName));
+    }
+}
+
+VideoItem::~VideoItem()
+{
+    VideoCatalog::instance()->release(m_id);
+}
+
+QString VideoItem::filePath() const
+{
+    return VideoCatalog::instance()->filePath(m_id);
+}
+
+QString VideoItem::fileName() const
+{
+    return VideoCatalog::instance()->fileName(m_id);
+}
+
+QString VideoItem::folderPath() const
+{
+    return VideoCatalog::instance()->folderPath(m_id);
+}
+
+qint64 VideoItem::fileSize() const
+{
+    return VideoCatalog::instance()->fileSize(m_id);
+}
+
+QDateTime VideoItem::creationTime() const
+{
+    return QDateTime::fromMSecsSinceEpoch(creationSortKey());
+}
+
+QDateTime VideoItem::modifiedTime() const
+{
+    return QDateTime::fromMSecsSinceEpoch(modifiedSortKey());
+}
+
+VideoMetadata VideoItem::metadata() const
+{
+    return VideoCatalog::instance()->metadata(m_id);
+}
+
+QString VideoItem::title() const
+{
+    return VideoCatalog::instance()->title(m_id);
+}
+
+QString VideoItem::codeKey() const
+{
+    return VideoCatalog::instance()->codeKey(m_id);
+}
+
+QString VideoItem::searchText() const
+{
+    return VideoCatalog::instance()->searchText(m_id);
+}
+
+QString VideoItem::nameSortKey() const
+{
+    return VideoCatalog::instance()->nameSortKey(m_id);
+}
+
+qint64 VideoItem::creationSortKey() const
+{
+    return VideoCatalog::instance()->creationMs(m_id);
+}
+
+qint64 VideoItem::modifiedSortKey() const
+{
+    return VideoCatalog::instance()->modifiedMs(m_id);
+}
+
+// QString 数据块的堆内存：头部加上 UTF-16 内容和结尾的 0
+static qint64 stringHeapBytes(const QString &text)
+{
+    return text.isEmpty() ? 0 : 16 + (text.capacity() + 1) * qint64(sizeof(QChar));
+}
+
+qint64 VideoItem::heapBytes() const
+{
+    qint64 bytes = stringHeapBytes(m_posterFailureReason);
+    if (m_images) {
+        bytes += sizeof(Images);
+    }
+    return bytes;
+}
+
+VideoItem::Images& VideoItem::images()
+{
+    if (!m_images) {
+        m_images.reset(new Images);
+    }
+    return *m_images;
+}
+
+// 按长边不超过 maxSize 解码（JPEG 在解码时直接缩小），较小的图片保持原尺寸
+static QImage readScaledImage(const QString &path, int maxSize)
+{
+    QImageReader reader(path);
+    const QSize size = reader.size();
+    if (size.isValid() && (size.width() > maxSize || size.height() > maxSize)) {
+        reader.setScaledSize(size.scaled(maxSize, maxSize, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qDebug() << "无法加载封面图片:" << path << reader.errorString();
+    }
+    return image;
+}
+
+QImage VideoItem::readCover(const QString &folderPath, const QString &fileName, bool fanart, int maxSize)
+{
+    const QDir folder(folderPath);
+    const QString posterPath = folder.filePath("poster.jpg");
+    const bool hasPosterJpg = QFileInfo::exists(posterPath);
+    if (!fanart && hasPosterJpg) {
+        return readScaledImage(posterPath, maxSize);
+    }
+
+    // 没有 poster.jpg 时，picture 文件夹中提取的封面同时作为海报和背景图
+    if (!hasPosterJpg) {
+        const QString pictureDir = QDir(QFileInfo(folderPath).absolutePath()).filePath("picture");
+        const QString extractedPath = QDir(pictureDir).filePath(QFileInfo(fileName).completeBaseName() + ".jpg");
+        if (QFileInfo::exists(extractedPath)) {
+            QImage image = readScaledImage(extractedPath, maxSize);
+            if (!image.isNull()) {
+                return image;
             }
         }
+    }
 
-        // 如果没有提取的封面图，使用默认海报
-        m_posterImage = QPixmap(":/icons/default_poster.png");
-        if (m_posterImage.isNull()) {
-            qDebug() << "无法加载默认海报图片";
-            createDefaultPoster();
+    if (fanart) {
+        const QString fanartPath = folder.filePath("fanart.jpg");
+        if (QFileInfo::exists(fanartPath)) {
+            return readScaledImage(fanartPath, maxSize);
         }
     }
+    return QImage();
+}
 
-    // 查找背景图片
-    QString fanartPath = folder.filePath("fanart.jpg");
-    if (QFileInfo::exists(fanartPath)) {
-        m_fanartImage = QPixmap(fanartPath);
-        if (m_fanartImage.isNull()) {
-            qDebug() << "无法加载背景图片:" << fanartPath;
-            createDefaultFanart();
-        }
-    } else {
-        // 使用默认背景
-        m_fanartImage = QPixmap(":/icons/default_fanart.png");
-        if (m_fanartImage.isNull()) {
-            qDebug() << "无法加载默认背景图片";
+// 默认图片只从资源解码一次，各视频共享
+static QPixmap defaultImage(const QString &resource)
+{
+    QPixmap pixmap;
+    if (!QPixmapCache::find(resource, &pixmap)) {
+        pixmap.load(resource);
+        QPixmapCache::insert(resource, pixmap);
+    }
+    return pixmap;
+}
+
+void VideoItem::setCover(bool fanart, const QImage &image, int decodedSize)
+{
+    // 先交付生成的封面，解码期间生成的新封面不会被旧文件的结果覆盖
+    publishPendingPoster();
+
+    Images &images = this->images();
+    int &currentSize = fanart ? images.fanartSize : images.posterSize;
+    if (decodedSize <= currentSize) {
+        return;
+    }
+    currentSize = decodedSize;
+
+    QPixmap &target = fanart ? images.fanart : images.poster;
+    target = QPixmap::fromImage(image);
+    if (!target.isNull()) {
+        return;
+    }
+    target = defaultImage(fanart ? ":/icons/default_fanart.png" : ":/icons/default_poster.png");
+    if (target.isNull()) {
+        qDebug() << "无法加载默认图片";
+        if (fanart) {
             createDefaultFanart();
+        } else {
+            createDefaultPoster();
         }
     }
-
-    m_imagesLoaded = true;
 }
 
 void VideoItem::createDefaultPoster()
 {
     // 创建一个简单的默认海报图片
-    m_posterImage = QPixmap(120, 180);
-    m_posterImage.fill(Qt::lightGray);
+    QPixmap &poster = images().poster;
+    poster = QPixmap(120, 180);
+    poster.fill(Qt::lightGray);
 
-    QPainter painter(&m_posterImage);
+    QPainter painter(&poster);
     painter.setPen(Qt::black);
-    painter.drawRect(0, 0, m_posterImage.width()-1, m_posterImage.height()-1);
-    painter.drawText(m_posterImage.rect(), Qt::AlignCenter, m_fileName);
+    painter.drawRect(0, 0, poster.width()-1, poster.height()-1);
+    painter.drawText(poster.rect(), Qt::AlignCenter, fileName());
 }
 
 void VideoItem::createDefaultFanart()
 {
     // 创建一个简单的默认背景图片
-    m_fanartImage = QPixmap(320, 180);
-    m_fanartImage.fill(Qt::darkGray);
+    QPixmap &fanart = images().fanart;
+    fanart = QPixmap(320, 180);
+    fanart.fill(Qt::darkGray);
 
-    QPainter painter(&m_fanartImage);
+    QPainter painter(&fanart);
     painter.setPen(Qt::white);
-    painter.drawRect(0, 0, m_fanartImage.width()-1, m_fanartImage.height()-1);
+    painter.drawRect(0, 0, fanart.width()-1, fanart.height()-1);
+}
+
+QString VideoItem::spriteSheetPath() const
+{
+    // 与提取的封面图放在同一个 picture 缓存目录中
+    QString baseName = QFileInfo(fileName()).completeBaseName();
+    return QDir(folderPath()).filePath("picture/sprites/" + baseName + ".jpg");
 }
 
 bool VideoItem::play() const
 {
     // 使用系统默认程序打开视频
-    return QDesktopServices::openUrl(QUrl::fromLocalFile(m_filePath));
+    return QDesktopServices::openUrl(QUrl::fromLocalFile(filePath()));
 }
 
 const QPixmap& VideoItem::posterImage() const
 {
-    if (!m_imagesLoaded) {
-        const_cast<VideoItem*>(this)->loadImages();
-    }
-    return m_posterImage;
+    publishPendingPoster();
+    return const_cast<VideoItem*>(this)->images().poster;
 }
 
 const QPixmap& VideoItem::fanartImage() const
 {
-    if (!m_imagesLoaded) {
-        const_cast<VideoItem*>(this)->loadImages();
+    publishPendingPoster();
+    return const_cast<VideoItem*>(this)->images().fanart;
+}
+
+int VideoItem::coverSize(bool fanart) const
+{
+    publishPendingPoster();
+    if (!m_images) {
+        return 0;
     }
-    return m_fanartImage;
+    return fanart ? m_images->fanartSize : m_images->posterSize;
 }
 
 bool VideoItem::hasPoster() const
 {
-    QDir folder(m_folderPath);
+    return hasPosterFile(folderPath());
+}
+
+bool VideoItem::hasPosterFile(const QString &folderPath)
+{
+    QDir folder(folderPath);
 
     // 检查是否存在poster.jpg
     QString posterPath = folder.filePath("poster.jpg");
@@ -155,58 +344,100 @@ bool VideoItem::hasPoster() const
     return false;
 }
 
-bool VideoItem::checkExtractedPoster(const QString &pictureDir)
+QString VideoItem::coverFilePath(const QString &folderPath, const QString &fileName)
 {
-    if (pictureDir.isEmpty()) {
-        return false;
+    // 与 readCover() 的查找顺序一致
+    const QString posterPath = QDir(folderPath).filePath("poster.jpg");
+    if (QFileInfo::exists(posterPath)) {
+        return posterPath;
     }
+    const QString pictureDir = QDir(QFileInfo(folderPath).absolutePath()).filePath("picture");
+    const QString extractedPath = QDir(pictureDir).filePath(QFileInfo(fileName).completeBaseName() + ".jpg");
+    if (QFileInfo::exists(extractedPath)) {
+        return extractedPath;
+    }
+    return QString();
+}
 
-    // 根据视频文件名生成封面图路径
-    QString baseName = QFileInfo(m_fileName).completeBaseName();
-    QString extractedPosterPath = QDir(pictureDir).filePath(baseName + ".jpg");
-
-    qDebug() << "检查提取的封面图:" << extractedPosterPath;
+QStringList VideoItem::extractedPosterCandidates(const QString &pictureDir, const QString &fileName)
+{
+    // 依次尝试：去掉扩展名的文件名、完整文件名、完整文件名加 _poster 后缀
+    const QDir dir(pictureDir);
+    return {
+        dir.filePath(QFileInfo(fileName).completeBaseName() + ".jpg"),
+        dir.filePath(fileName + ".jpg"),
+        dir.filePath(fileName + "_poster.jpg")
+    };
+}
 
-    // 检查并加载提取的封面图
-    // 注意：提取的视频帧同时用于海报图(poster)和背景图(fanart)
-    bool result = loadExtractedPoster(extractedPosterPath);
+QImage VideoItem::readExtractedPoster(const QString &pictureDir) const
+{
+    if (pictureDir.isEmpty()) {
+        return QImage();
+    }
 
-    // 如果找不到，尝试其他可能的文件名格式
-    if (!result) {
-        // 尝试使用完整文件名（包括扩展名）
-        extractedPosterPath = QDir(pictureDir).filePath(m_fileName + ".jpg");
-        qDebug() << "尝试替代封面图路径:" << extractedPosterPath;
-        result = loadExtractedPoster(extractedPosterPath);
+    for (const QString &posterPath : extractedPosterCandidates(pictureDir, fileName())) {
+        if (!QFileInfo::exists(posterPath)) {
+            continue;
+        }
+        // QImage 可以在工作线程中解码，QPixmap 不行
+        QImage image(posterPath);
+        if (image.isNull()) {
+            qDebug() << "无法加载提取的封面图:" << posterPath;
+            continue;
+        }
+        return image;
+    }
+    return QImage();
+}
 
-        // 尝试使用完整文件名加_poster后缀
-        if (!result) {
-            extractedPosterPath = QDir(pictureDir).filePath(m_fileName + "_poster.jpg");
-            qDebug() << "尝试第二替代封面图路径:" << extractedPosterPath;
-            result = loadExtractedPoster(extractedPosterPath);
+bool VideoItem::hasExtractedPoster(const QString &pictureDir, const QString &fileName)
+{
+    if (pictureDir.isEmpty()) {
+        return false;
+    }
+    for (const QString &posterPath : extractedPosterCandidates(pictureDir, fileName)) {
+        if (QFileInfo::exists(posterPath)) {
+            return true;
         }
     }
+    return false;
+}
+
+// 保护各视频暂存的封面图；交付和转换都很少发生，共用一把锁即可
+static QMutex s_pendingLock;
 
-    return result;
+void VideoItem::setExtractedPoster(const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+    QMutexLocker locker(&s_pendingLock);
+    m_pendingPoster = image;
+    m_hasPendingPoster.storeRelease(1);
 }
 
-bool VideoItem::loadExtractedPoster(const QString &posterPath)
+void VideoItem::publishPendingPoster() const
 {
-    if (!QFileInfo::exists(posterPath)) {
-        return false;
+    if (!m_hasPendingPoster.loadAcquire()) {
+        return;
     }
 
-    QPixmap extractedPoster(posterPath);
-    if (extractedPoster.isNull()) {
-        qDebug() << "无法加载提取的封面图:" << posterPath;
-        return false;
+    QImage image;
+    {
+        QMutexLocker locker(&s_pendingLock);
+        image.swap(m_pendingPoster);
+        m_hasPendingPoster.storeRelease(0);
     }
 
-    // 同时将提取的封面图设置为海报图和背景图
-    m_posterImage = extractedPoster;
-    m_fanartImage = extractedPoster;  // 同时用于背景图
-    m_imagesLoaded = true;
-    qDebug() << "提取的封面图同时用于海报和背景:" << posterPath;
-    return true;
+    // 转换一次，海报和背景图共享同一份像素数据，原子地替换两张图
+    QPixmap poster = QPixmap::fromImage(std::move(image));
+    Images &images = const_cast<VideoItem*>(this)->images();
+    images.poster = poster;
+    images.fanart = poster;
+    // 原始尺寸，之后按缩略图尺寸解码的结果不会替换它
+    images.posterSize = std::numeric_limits<int>::max();
+    images.fanartSize = std::numeric_limits<int>::max();
 }
 
 // 新增：设置是否需要生成封面
@@ -220,3 +451,15 @@ bool VideoItem::needsPosterGeneration() const
 {
     return m_needsPosterGeneration;
 }
+
+void VideoItem::setPosterFailure(const QString &reason, int attempts)
+{
+    m_posterFailureReason = reason;
+    m_posterFailureAttempts = attempts;
+}
+
+void VideoItem::clearPosterFailure()
+{
+    m_posterFailureReason.clear();
+    m_posterFailureAttempts = 0;
+}
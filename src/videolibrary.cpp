@@ -1,7 +1,11 @@
 #include "videolibrary.h"
+#include "concurrencycontroller.h"
+#include "settingsstore.h"
+#include "videocatalog.h"
+#include "nforeader.h"
+#include "librarysnapshot.h"
 #include <QDir>
 #include <QFileInfo>
-#include <QSettings>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QtConcurrent/QtConcurrentMap>
 #include <algorithm>
@@ -13,6 +17,10 @@
 #include <QRandomGenerator>
 #include <QTemporaryDir>
 #include <QFuture>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QMutexLocker>
 
 // 支持的视频扩展名
 static const QStringList VIDEO_EXTENSIONS = {
@@ -20,11 +28,36 @@ static const QStringList VIDEO_EXTENSIONS = {
     "*.webm", "*.m4v", "*.mpg", "*.mpeg", "*.ts", "*.3gp", "*.rm"
 };
 
+// 将临时文件重命名为最终文件；同一卷上的重命名是原子的，
+// 读取方只会看到完整的图片或者不存在
+static bool commitTempFile(const QString &tempPath, const QString &finalPath, QString *errorReason)
+{
+    if (QFileInfo::exists(finalPath) && !QFile::remove(finalPath)) {
+        if (errorReason) *errorReason = QObject::tr("无法替换已有文件");
+        return false;
+    }
+    if (!QFile::rename(tempPath, finalPath)) {
+        if (errorReason) *errorReason = QObject::tr("无法重命名临时文件");
+        return false;
+    }
+    return true;
+}
+
 VideoLibrary::VideoLibrary(QObject *parent)
     : QObject(parent),
+      m_queueSaveTimer(new QTimer(this)),
+      m_videoCount(0),
       m_watcher(new QFutureWatcher<QVector<std::shared_ptr<VideoItem>>>(this)),
-      m_pendingScanCount(0)
+      m_pendingScanCount(0),
+      m_runningScanTasks(0)
 {
+    m_queueSaveTimer->setSingleShot(true);
+    m_queueSaveTimer->setInterval(1000);
+    connect(m_queueSaveTimer, &QTimer::timeout, this, [this]() {
+        m_posterQueue.save();
+        m_failureCache.save();
+    });
+
     // 这个构造函数不再需要连接 m_watcher 的信号
     // 现在我们为每个目录的扫描创建单独的 watcher 并在 lambda 中处理结果
 }
@@ -36,6 +69,21 @@ VideoLibrary::~VideoLibrary()
         m_watcher->cancel();
         m_watcher->waitForFinished();
     }
+
+    // 线程池比本对象活得久：丢弃排队中的封面和雪碧图任务，等执行中的任务写完队列和失败记录。
+    // 被丢弃的任务在队列中仍是“执行中”，下次启动时重新排队
+    ConcurrencyController *controller = ConcurrencyController::instance();
+    controller->cancel(this);
+    controller->waitFor(this);
+
+    // 写出最近完成的任务和失败记录，下次启动从这里继续
+    m_posterQueue.save();
+    m_failureCache.save();
+
+    // 扫描后计算的哈希和封面指纹也写入快照
+    if (m_scanCompleted) {
+        saveSnapshot(false);
+    }
 }
 
 void VideoLibrary::addDirectory(const QString &path)
@@ -61,17 +109,24 @@ void VideoLibrary::removeDirectory(const QString &path, bool removeFiles)
                     removeVideoFiles(video);
                 }
             }
+            for (const auto& video : videosInDir) {
+                unindexVideo(video);
+            }
             // 从哈希表中移除该目录及其视频
             m_videosByDirectory.remove(absPath);
         }
 
-        // 从待生成封面列表中移除相关视频
+        // 从待生成封面列表中移除相关视频（加上分隔符比较，不误删同名前缀的兄弟目录）
+        const QString prefix = absPath.endsWith(QLatin1Char('/')) ? absPath : absPath + QLatin1Char('/');
         auto it = std::remove_if(m_videosNeedingPoster.begin(), m_videosNeedingPoster.end(),
-                         [&absPath](const std::shared_ptr<VideoItem>& video) {
-                             return video->folderPath().startsWith(absPath);
+                         [&absPath, &prefix](const std::shared_ptr<VideoItem>& video) {
+                             const QString folder = video->folderPath();
+                             return folder == absPath || folder.startsWith(prefix);
                          });
         m_videosNeedingPoster.erase(it, m_videosNeedingPoster.end());
 
+        m_posterQueue.removeUnder(absPath);
+        m_posterQueue.save();
     }
 }
 
@@ -85,6 +140,26 @@ const QHash<QString, QVector<std::shared_ptr<VideoItem>>>& VideoLibrary::videosB
     return m_videosByDirectory;
 }
 
+VideoRange VideoLibrary::videos() const
+{
+    return VideoRange(m_videoById, m_videoCount);
+}
+
+std::shared_ptr<VideoItem> VideoLibrary::video(quint32 videoId) const
+{
+    return videoId < quint32(m_videoById.size()) ? m_videoById.at(videoId) : nullptr;
+}
+
+QVector<quint32> VideoLibrary::allIds() const
+{
+    QVector<quint32> ids;
+    ids.reserve(m_videoCount);
+    for (const auto &video : videos()) {
+        ids.append(video->id());
+    }
+    return ids;
+}
+
 void VideoLibrary::scanLibrary()
 {
     // 如果已经有扫描在进行中，取消它
@@ -93,10 +168,14 @@ void VideoLibrary::scanLibrary()
         m_watcher->waitForFinished();
     }
 
+    m_scanStarted = true;
     emit scanStarted();
 
-    // 清空视频哈希表
-    m_videosByDirectory.clear();
+    // 现有列表和索引保留到扫描结果合并时，界面在扫描期间继续显示上次的内容
+    m_lastQuery = VideoSearchQuery();
+    m_lastSearchIds.clear();
+    m_lastResultSet.clear();
+    m_hasLastResult = false;
 
     // 获取目录列表
     QStringList dirs = directories();
@@ -111,31 +190,32 @@ void VideoLibrary::scanLibrary()
     std::shared_ptr<int> completedCount = std::make_shared<int>(0);
 
     for (const QString &dir : dirs) {
+        // 该目录当前已有的视频 ID（来自快照或上次扫描），扫描线程据此跳过未变化的文件
+        QSet<quint32> knownIds;
+        const QVector<std::shared_ptr<VideoItem>> current = m_videosByDirectory.value(dir);
+        knownIds.reserve(current.size());
+        for (const auto &video : current) {
+            knownIds.insert(video->id());
+        }
+
         // 直接在 lambda 中捕获目录路径
-        auto futureWatcher = new QFutureWatcher<QVector<std::shared_ptr<VideoItem>>>(this);
-        QFuture<QVector<std::shared_ptr<VideoItem>>> future = QtConcurrent::run(
-            [this, dir]() {
-                return this->findVideosInDirectory(dir);
+        auto futureWatcher = new QFutureWatcher<ScanResult>(this);
+        ++m_runningScanTasks;
+        QFuture<ScanResult> future = QtConcurrent::run(
+            [this, dir, knownIds]() {
+                return this->findVideosInDirectory(dir, knownIds);
             }
         );
 
         // 连接 finished 信号
-        connect(futureWatcher, &QFutureWatcher<QVector<std::shared_ptr<VideoItem>>>::finished, this,
+        connect(futureWatcher, &QFutureWatcher<ScanResult>::finished, this,
             [this, dir, completedCount, futureWatcher]() {
                 // 使用 lambda 捕获的 dir 参数，而不是从 map 中查找
-                QVector<std::shared_ptr<VideoItem>> results = futureWatcher->result();
-
-                if (!m_videosByDirectory.contains(dir)) {
-                    m_videosByDirectory[dir] = QVector<std::shared_ptr<VideoItem>>();
-                }
+                const ScanResult result = futureWatcher->result();
 
-                for (const auto &video : results) {
-                    m_videosByDirectory[dir].append(video);
-                    emit videoAdded(dir, video);
-                    if (video->needsPosterGeneration()) {
-                        m_videosNeedingPoster.append(video);
-                    }
-                }
+                // 只把差异通知界面，模型一次归并到有序位置
+                mergeScanResults(dir, result);
+                --m_runningScanTasks;
 
                 // 增加完成计数
                 (*completedCount)++;
@@ -143,6 +223,13 @@ void VideoLibrary::scanLibrary()
 
                 // 所有目录都扫描完成时，发送完成信号并开始生成封面
                 if (*completedCount >= m_pendingScanCount) {
+                    // 扫描线程找到的已知 ID 不带引用，只有没有扫描在进行时才能回收条目
+                    if (m_runningScanTasks == 0) {
+                        reclaimUnusedVideos();
+                    }
+                    logMemoryFootprint();
+                    m_scanCompleted = true;
+                    saveSnapshot(true);
                     emit scanFinished();
                     startPosterGeneration();
                 }
@@ -157,35 +244,495 @@ void VideoLibrary::scanLibrary()
     }
 }
 
-QVector<std::shared_ptr<VideoItem>> VideoLibrary::findVideosInDirectory(const QString &path)
+void VideoLibrary::mergeScanResults(const QString &dir, const ScanResult &result)
 {
-    QVector<std::shared_ptr<VideoItem>> results;
-    QDir dir(path);
+    // 文件未变化的视频在 VideoCatalog 中得到同一个 ID，按 ID 找到上次的对象
+    const QVector<std::shared_ptr<VideoItem>> previous = m_videosByDirectory.value(dir);
+    QHash<quint32, int> previousRow;
+    previousRow.reserve(previous.size());
+    for (int i = 0; i < previous.size(); ++i) {
+        previousRow.insert(previous.at(i)->id(), i);
+    }
+
+    QVector<bool> kept(previous.size(), false);
+    QVector<std::shared_ptr<VideoItem>> added;
+    QMutexLocker locker(&m_changedMetadataLock);
+
+    // 沿用界面中已有的对象，封面状态以本次扫描为准
+    auto keep = [&](int row, bool needsPosterGeneration, const QString &failureReason, int failureAttempts) {
+        kept[row] = true;
+        const std::shared_ptr<VideoItem> &existing = previous.at(row);
+        existing->setNeedsPosterGeneration(needsPosterGeneration);
+        if (failureAttempts > 0) {
+            existing->setPosterFailure(failureReason, failureAttempts);
+        } else {
+            existing->clearPosterFailure();
+        }
+        if (existing->needsPosterGeneration()) {
+            m_videosNeedingPoster.append(existing);
+        }
+        // NFO 有变化时更新分面索引
+        if (m_changedMetadata.remove(existing->id())) {
+            m_facetIndex.insert(existing->id(), existing->metadata(), existing->fileSize());
+            m_lastQuery = VideoSearchQuery();
+            m_lastSearchIds.clear();
+        }
+    };
+
+    for (const KeptVideo &video : result.kept) {
+        auto found = previousRow.constFind(video.id);
+        if (found != previousRow.constEnd()) {
+            keep(found.value(), video.needsPosterGeneration, video.failureReason, video.failureAttempts);
+            continue;
+        }
+        // 扫描期间目录被移除又加入时，已知 ID 可能不在当前列表中：按目录中的信息重建（不访问磁盘）
+        VideoCatalog *catalog = VideoCatalog::instance();
+        auto item = std::make_shared<VideoItem>(catalog->folderPath(video.id), catalog->fileName(video.id),
+                                                catalog->fileSize(video.id), catalog->creationMs(video.id),
+                                                catalog->modifiedMs(video.id));
+        item->setNeedsPosterGeneration(video.needsPosterGeneration);
+        if (video.failureAttempts > 0) {
+            item->setPosterFailure(video.failureReason, video.failureAttempts);
+        }
+        m_changedMetadata.remove(item->id());
+        added.append(item);
+    }
+    for (const auto &video : result.added) {
+        auto found = previousRow.constFind(video->id());
+        if (found != previousRow.constEnd()) {
+            keep(found.value(), video->needsPosterGeneration(),
+                 video->posterFailureReason(), video->posterFailureAttempts());
+            continue;
+        }
+        m_changedMetadata.remove(video->id());
+        added.append(video);
+    }
+    locker.unlock();
+
+    QVector<std::shared_ptr<VideoItem>> merged;
+    merged.reserve(result.kept.size() + result.added.size());
+    QVector<quint32> removedIds;
+    for (int i = 0; i < previous.size(); ++i) {
+        if (kept.at(i)) {
+            merged.append(previous.at(i));
+        } else {
+            unindexVideo(previous.at(i));
+            removedIds.append(previous.at(i)->id());
+        }
+    }
+    for (const auto &video : added) {
+        merged.append(video);
+        indexVideo(video);
+        if (video->needsPosterGeneration()) {
+            m_videosNeedingPoster.append(video);
+        }
+    }
+    m_videosByDirectory[dir] = merged;
+
+    // previous 仍持有被移除的视频，接收方处理完通知后才释放
+    if (!removedIds.isEmpty()) {
+        emit videosRemoved(dir, removedIds);
+    }
+    QVector<quint32> addedIds;
+    addedIds.reserve(added.size());
+    for (const auto &video : added) {
+        addedIds.append(video->id());
+    }
+    emit videosAdded(dir, addedIds);
+    if (!added.isEmpty() || !removedIds.isEmpty()) {
+        qDebug() << "目录" << dir << "新增" << added.size() << "个视频，移除" << removedIds.size() << "个";
+    }
+}
+
+void VideoLibrary::loadSnapshot()
+{
+    const QString path = m_snapshotPath;
+    const QStringList dirs = directories();
+    if (path.isEmpty() || dirs.isEmpty()) {
+        QTimer::singleShot(0, this, [this]() {
+            emit snapshotLoaded(0);
+        });
+        return;
+    }
+
+    using Snapshot = QHash<QString, QVector<std::shared_ptr<VideoItem>>>;
+    auto watcher = new QFutureWatcher<Snapshot>(this);
+    connect(watcher, &QFutureWatcher<Snapshot>::finished, this, [this, watcher]() {
+        const Snapshot snapshot = watcher->result();
+        watcher->deleteLater();
+
+        // 读取期间已经开始扫描时以扫描结果为准，快照中可能有已删除的文件
+        int count = 0;
+        if (!m_scanStarted) {
+            QStringList snapshotDirs = snapshot.keys();
+            snapshotDirs.sort();
+            for (const QString &dir : snapshotDirs) {
+                const QVector<std::shared_ptr<VideoItem>> videos = snapshot.value(dir);
+                m_videosByDirectory[dir] = videos;
+                QVector<quint32> videoIds;
+                videoIds.reserve(videos.size());
+                for (const auto &video : videos) {
+                    indexVideo(video);
+                    videoIds.append(video->id());
+                }
+                count += videos.size();
+                emit videosAdded(dir, videoIds);
+            }
+        }
+        emit snapshotLoaded(count);
+    });
+    watcher->setFuture(QtConcurrent::run([path, dirs]() {
+        return LibrarySnapshot::load(path, dirs);
+    }));
+}
+
+void VideoLibrary::saveSnapshot(bool background)
+{
+    if (m_snapshotPath.isEmpty()) {
+        return;
+    }
+
+    // 条目不会从 VideoCatalog 中清除，只需复制 ID，写盘可以放到工作线程
+    QHash<QString, QVector<quint32>> videoIds;
+    for (auto it = m_videosByDirectory.constBegin(); it != m_videosByDirectory.constEnd(); ++it) {
+        QVector<quint32> &ids = videoIds[it.key()];
+        ids.reserve(it.value().size());
+        for (const auto &video : it.value()) {
+            ids.append(video->id());
+        }
+    }
+
+    const QString path = m_snapshotPath;
+    if (!background) {
+        LibrarySnapshot::save(path, videoIds);
+        return;
+    }
+    QThreadPool::globalInstance()->start([path, videoIds]() {
+        QElapsedTimer timer;
+        timer.start();
+        if (LibrarySnapshot::save(path, videoIds)) {
+            qDebug() << "媒体库快照已保存，耗时" << timer.elapsed() << "毫秒";
+        }
+    });
+}
+
+void VideoLibrary::logMemoryFootprint() const
+{
+    // make_shared 的控制块（两个引用计数加虚表指针）
+    const qint64 controlBlock = 16;
+
+    qint64 count = 0;
+    qint64 bytes = 0;
+    for (const auto &video : videos()) {
+        bytes += sizeof(VideoItem) + controlBlock + video->heapBytes();
+        ++count;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // 目录按已分配的块和容量统计，包括已回收、等待复用的条目
+    VideoCatalog::Stats stats = VideoCatalog::instance()->stats();
+    bytes += stats.bytes;
+    qInfo() << "视频目录：" << count << "个视频，" << stats.folders << "个文件夹，"
+            << stats.freeEntries << "个空闲条目，每个视频约" << bytes / count << "字节";
+}
+
+void VideoLibrary::reclaimUnusedVideos()
+{
+    // 回收的 ID 之后会分配给其他文件，以 ID 为键的状态一并清除
+    const QVector<quint32> reclaimed = VideoCatalog::instance()->reclaimUnused();
+    if (reclaimed.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_changedMetadataLock);
+    for (quint32 id : reclaimed) {
+        m_spriteRequests.remove(id);
+        m_changedMetadata.remove(id);
+    }
+    qDebug() << "回收了" << reclaimed.size() << "个不再使用的目录条目";
+}
+
+void VideoLibrary::indexVideo(const std::shared_ptr<VideoItem> &video)
+{
+    quint32 id = video->id();
+    m_searchIndex.insert(id, video->searchText());
+    if (id >= quint32(m_videoById.size())) {
+        m_videoById.resize(id + 1);
+    }
+    if (!m_videoById.at(id)) {
+        ++m_videoCount;
+    }
+    m_videoById[id] = video;
+    const QString codeKey = video->codeKey();
+    if (!codeKey.isEmpty()) {
+        m_codeIndex[codeKey].append(id);
+    }
+    // 元数据已在扫描线程中读入目录
+    m_facetIndex.insert(id, video->metadata(), video->fileSize());
+
+    // 新视频不在上次的结果中，下次搜索需要完整查找
+    m_lastQuery = VideoSearchQuery();
+    m_lastSearchIds.clear();
+}
+
+void VideoLibrary::unindexVideo(const std::shared_ptr<VideoItem> &video)
+{
+    quint32 id = video->id();
+    if (id >= quint32(m_videoById.size()) || !m_videoById.at(id)) {
+        return;
+    }
+    m_videoById[id].reset();
+    --m_videoCount;
+    m_searchIndex.remove(id);
+    m_facetIndex.remove(id);
+
+    auto codeIt = m_codeIndex.find(video->codeKey());
+    if (codeIt != m_codeIndex.end()) {
+        codeIt.value().removeOne(id);
+        if (codeIt.value().isEmpty()) {
+            m_codeIndex.erase(codeIt);
+        }
+    }
+
+    // 索引变化后上次的结果不再可靠
+    m_lastQuery = VideoSearchQuery();
+    m_lastSearchIds.clear();
+}
+
+void VideoLibrary::searchVideos(const VideoSearchQuery &query, QVector<SearchMatch> *matches)
+{
+    matches->clear();
+    m_lastResultSet.clear();
+    m_hasLastResult = false;
+    if (query.isEmpty()) {
+        m_lastQuery = VideoSearchQuery();
+        m_lastSearchIds.clear();
+        return;
+    }
+
+    VideoCatalog *catalog = VideoCatalog::instance();
+
+    // 过滤条件：在分面位图上求出候选集合，之后的文字匹配只接受候选
+    const bool filtered = !query.filters().isEmpty();
+    RoaringBitmap candidates;
+    QVector<quint32> candidateIds;
+    if (filtered) {
+        QElapsedTimer timer;
+        timer.start();
+        candidates = m_facetIndex.evaluate(query.filters());
+        qDebug() << "分面过滤：" << query.filters().size() << "个条件，"
+                 << candidates.cardinality() << "/" << m_videoCount << "个视频，"
+                 << timer.nsecsElapsed() / 1000 << "微秒";
+        candidateIds = candidates.toVector();
+    }
+    auto accepted = [&](quint32 id) {
+        return !filtered || candidates.contains(id);
+    };
+
+    QHash<quint32, int> ranks; // 文档 id -> 最佳排名
+
+    if (query.text().isEmpty()) {
+        // 只有过滤条件：候选全部匹配
+        for (quint32 id : qAsConst(candidateIds)) {
+            ranks.insert(id, SearchRankSubstring);
+        }
+    } else {
+        // 番号完全一致
+        if (!query.code().isEmpty()) {
+            for (quint32 id : m_codeIndex.value(query.code())) {
+                if (accepted(id)) {
+                    ranks.insert(id, SearchRankCode);
+                }
+            }
+        }
+
+        // 子串匹配：优先使用 trigram 索引，搜索词太短时线性查找（有过滤条件时只查候选）
+        QVector<quint32> ids;
+        if (m_searchIndex.search(query.text(), &ids)) {
+            for (quint32 id : qAsConst(ids)) {
+                if (!ranks.contains(id) && accepted(id)) {
+                    ranks.insert(id, SearchRankSubstring);
+                }
+            }
+        } else {
+            const QString text = query.text();
+            catalog->visitSearchText(filtered ? candidateIds : allIds(), [&](quint32 id, QStringView searchText) {
+                if (!ranks.contains(id) && searchText.contains(text)) {
+                    ranks.insert(id, SearchRankSubstring);
+                }
+            });
+        }
+    }
+
+    // 近似匹配需要逐个计算；搜索词是上次的扩展时只检查上次的结果
+    if (query.maxErrors() > 0) {
+        // 在目录的文字块上直接匹配，不为每个视频复制搜索文本
+        QVector<quint32> ids;
+        if (query.refines(m_lastQuery)) {
+            for (quint32 id : qAsConst(m_lastSearchIds)) {
+                if (m_videoById.value(id)) {
+                    ids.append(id);
+                }
+            }
+        } else {
+            ids = filtered ? candidateIds : allIds();
+        }
+        catalog->visitSearchText(ids, [&](quint32 id, QStringView searchText) {
+            if (ranks.contains(id)) {
+                return;
+            }
+            int distance = query.fuzzyDistance(searchText);
+            if (distance > 0) {
+                ranks.insert(id, SearchRankFuzzy + distance - 1);
+            }
+        });
+    }
+
+    m_lastQuery = query;
+    m_lastSearchIds.clear();
+    m_lastSearchIds.reserve(ranks.size());
+    matches->reserve(ranks.size());
+    for (auto it = ranks.constBegin(); it != ranks.constEnd(); ++it) {
+        m_lastSearchIds.append(it.key());
+        SearchMatch match;
+        match.video = m_videoById.at(it.key()).get();
+        match.rank = it.value();
+        matches->append(match);
+    }
+    m_lastResultSet = RoaringBitmap::fromValues(m_lastSearchIds.constData(), m_lastSearchIds.size());
+    m_hasLastResult = true;
+}
+
+QVector<FacetCount> VideoLibrary::facetCounts(FacetField field, int limit) const
+{
+    return m_facetIndex.counts(field, m_hasLastResult ? m_lastResultSet : m_facetIndex.all(), limit);
+}
+
+VideoLibrary::ScanResult VideoLibrary::findVideosInDirectory(const QString &path, const QSet<quint32> &knownIds)
+{
+    ScanResult result;
+    QVector<quint32> videoIds;
+    VideoCatalog *catalog = VideoCatalog::instance();
 
     // 确保picture文件夹存在
     QString pictureDir = ensurePictureDirectory(path);
 
-    // 使用QDirIterator进行递归扫描，更高效
-    QDirIterator it(path, VIDEO_EXTENSIONS, QDir::Files, QDirIterator::Subdirectories);
+    // 使用QDirIterator进行递归扫描，更高效；同一次遍历顺带收集 NFO 文件及其修改时间
+    QStringList nameFilters = VIDEO_EXTENSIONS;
+    nameFilters << "*.nfo";
+    QHash<QString, qint64> nfoModified;
+    QDirIterator it(path, nameFilters, QDir::Files, QDirIterator::Subdirectories);
     while (it.hasNext()) {
         QString filePath = it.next();
-        if (isVideoFile(filePath)) {
-            // 创建VideoItem时不立即加载图片
-            auto video = std::make_shared<VideoItem>(filePath, false);
-
-            // 检查视频是否有封面图
-            if (!video->hasPoster()) {
-                // 如果没有封面图，先检查是否有提取的封面图
-                if (!video->checkExtractedPoster(pictureDir)) {
-                    // 标记需要生成封面
-                    video->setNeedsPosterGeneration(true);
+        const QFileInfo fileInfo = it.fileInfo();
+        if (filePath.endsWith(QLatin1String(".nfo"), Qt::CaseInsensitive)) {
+            nfoModified.insert(filePath.chopped(4) + QLatin1String(".nfo"),
+                               fileInfo.lastModified().toMSecsSinceEpoch());
+            continue;
+        }
+        if (!isVideoFile(filePath)) {
+            continue;
+        }
+
+        const QString folderPath = fileInfo.path();
+        const QString fileName = fileInfo.fileName();
+        const qint64 fileSize = fileInfo.size();
+        const qint64 modifiedMs = fileInfo.lastModified().toMSecsSinceEpoch();
+
+        // 库中已有且文件未变化：沿用界面中的对象，只检查封面文件是否存在
+        quint32 id;
+        if (catalog->find(folderPath, fileName, fileSize, modifiedMs, &id) && knownIds.contains(id)) {
+            KeptVideo kept = { id, false, QString(), 0 };
+            if (!VideoItem::hasPosterFile(folderPath) && !VideoItem::hasExtractedPoster(pictureDir, fileName)) {
+                kept.needsPosterGeneration = true;
+                PosterFailure failure;
+                if (m_failureCache.lookup(filePath, fileSize, fileInfo.lastModified(), &failure)) {
+                    kept.failureReason = failure.reason;
+                    kept.failureAttempts = failure.attempts;
                 }
             }
-            results.append(video);
+            result.kept.append(kept);
+            videoIds.append(id);
+            continue;
+        }
+
+        // 新文件：创建VideoItem时不立即加载图片
+        auto video = std::make_shared<VideoItem>(folderPath, fileName, fileSize,
+                                                 fileInfo.birthTime().toMSecsSinceEpoch(), modifiedMs);
+
+        // 检查视频是否有封面图
+        if (!video->hasPoster()) {
+            // 如果没有封面图，先检查是否有提取的封面图（在本线程解码为 QImage，界面线程再转换）
+            QImage extractedPoster = video->readExtractedPoster(pictureDir);
+            if (!extractedPoster.isNull()) {
+                video->setExtractedPoster(extractedPoster);
+            } else {
+                // 标记需要生成封面
+                video->setNeedsPosterGeneration(true);
+
+                // 带上之前的失败记录，便于界面提示
+                PosterFailure failure;
+                if (m_failureCache.lookup(video->filePath(), video->fileSize(), video->modifiedTime(), &failure)) {
+                    video->setPosterFailure(failure.reason, failure.attempts);
+                }
+            }
+        }
+        result.added.append(video);
+        videoIds.append(video->id());
+    }
+
+    readChangedNfos(videoIds, nfoModified);
+    return result;
+}
+
+void VideoLibrary::readChangedNfos(const QVector<quint32> &videoIds,
+                                   const QHash<QString, qint64> &nfoModified)
+{
+    struct NfoTask {
+        quint32 videoId;
+        QString path;        // 为空表示 NFO 已被删除
+        qint64 modifiedMs;
+    };
+
+    // 只解析修改时间与上次读取时不同的 NFO；文件未变的视频沿用原 ID，元数据仍在目录中
+    VideoCatalog *catalog = VideoCatalog::instance();
+    QVector<NfoTask> tasks;
+    for (quint32 videoId : videoIds) {
+        NfoTask task = { videoId, QString(), 0 };
+        const QString folder = catalog->folderPath(videoId) + QLatin1Char('/');
+        for (const QString &name : NfoReader::candidateNames(catalog->fileName(videoId))) {
+            auto found = nfoModified.constFind(folder + name);
+            if (found != nfoModified.constEnd()) {
+                task.path = found.key();
+                task.modifiedMs = found.value();
+                break;
+            }
+        }
+        if (task.modifiedMs != catalog->nfoModifiedMs(task.videoId)) {
+            tasks.append(task);
         }
     }
+    if (tasks.isEmpty()) {
+        return;
+    }
+
+    // 并行解析；当前扫描线程也参与执行，不会因线程池被扫描任务占满而阻塞
+    QtConcurrent::blockingMap(tasks, [catalog](const NfoTask &task) {
+        VideoMetadata metadata;
+        QString errorReason;
+        if (!task.path.isEmpty() && !NfoReader::read(task.path, &metadata, &errorReason)) {
+            qDebug() << "无法读取 NFO:" << task.path << errorReason;
+        }
+        catalog->setMetadata(task.videoId, metadata, task.modifiedMs);
+    });
+    qDebug() << "读取了" << tasks.size() << "个有变化的 NFO";
 
-    return results;
+    // 沿用原 ID 的视频在合并时需要按新的元数据更新分面索引
+    QMutexLocker locker(&m_changedMetadataLock);
+    for (const NfoTask &task : tasks) {
+        m_changedMetadata.insert(task.videoId);
+    }
 }
 
 bool VideoLibrary::isVideoFile(const QString &filePath) const
@@ -202,21 +749,10 @@ bool VideoLibrary::isVideoFile(const QString &filePath) const
     return videoExtensions.contains(suffix);
 }
 
-void VideoLibrary::saveLibraryConfig(const QString &filePath)
+void VideoLibrary::saveLibraryConfig(SettingsStore *settings)
 {
-    QSettings settings(filePath, QSettings::IniFormat);
-    settings.clear();
-
-    // 保存视频库目录
-    settings.beginWriteArray("Directories");
-    QStringList dirs = directories();
-    for (int i = 0; i < dirs.size(); ++i) {
-        settings.setArrayIndex(i);
-        settings.setValue("Path", dirs.at(i));
-    }
-    settings.endArray();
-
-    settings.sync();
+    // 保存视频库目录（只更新内存中的配置，由配置存储在后台写盘）
+    settings->writeArray("Directories", "Path", directories());
 }
 
 QString VideoLibrary::ensurePictureDirectory(const QString &rootDir)
@@ -233,11 +769,12 @@ QString VideoLibrary::ensurePictureDirectory(const QString &rootDir)
     return pictureDirPath;
 }
 
-bool VideoLibrary::extractFrameFromVideo(const QString &videoPath, const QString &outputPath)
+bool VideoLibrary::extractFrameFromVideo(const QString &videoPath, const QString &outputPath, QString *errorReason)
 {
     // 检查视频文件是否存在
     if (!QFileInfo::exists(videoPath)) {
         qDebug() << "视频文件不存在:" << videoPath;
+        if (errorReason) *errorReason = tr("视频文件不存在");
         return false;
     }
 
@@ -246,6 +783,7 @@ bool VideoLibrary::extractFrameFromVideo(const QString &videoPath, const QString
     QDir outputDir = outputInfo.dir();
     if (!outputDir.exists()) {
         qDebug() << "输出目录不存在:" << outputDir.path();
+        if (errorReason) *errorReason = tr("输出目录不存在");
         return false;
     }
 
@@ -253,24 +791,8 @@ bool VideoLibrary::extractFrameFromVideo(const QString &videoPath, const QString
     QProcess process;
 
     // 首先获取视频时长
-    QStringList durationArgs;
-    durationArgs << "-v" << "error"
-                << "-show_entries" << "format=duration"
-                << "-of" << "default=noprint_wrappers=1:nokey=1"
-                << videoPath;
-
-    process.start("ffprobe", durationArgs);
-    if (!process.waitForFinished(5000)) {
-        qDebug() << "FFprobe执行超时";
-        return false;
-    }
-
-    QString durationStr = QString::fromUtf8(process.readAllStandardOutput()).trimmed();
-    bool ok;
-    double duration = durationStr.toDouble(&ok);
-
-    if (!ok || duration <= 0) {
-        qDebug() << "无法获取视频时长:" << durationStr;
+    double duration = probeVideoDuration(videoPath);
+    if (duration <= 0) {
         duration = 60.0; // 默认值
     }
 
@@ -304,6 +826,9 @@ bool VideoLibrary::extractFrameFromVideo(const QString &videoPath, const QString
     process.start("ffmpeg", args);
     if (!process.waitForFinished(10000)) { // 10秒超时
         qDebug() << "FFmpeg执行超时";
+        process.kill();
+        process.waitForFinished();
+        if (errorReason) *errorReason = tr("FFmpeg执行超时（跳转耗时过长）");
         return false;
     }
 
@@ -312,28 +837,172 @@ bool VideoLibrary::extractFrameFromVideo(const QString &videoPath, const QString
         qDebug() << "成功提取视频帧:" << outputPath;
         return true;
     } else {
-        qDebug() << "提取视频帧失败:" << process.readAllStandardError();
+        QString stdErr = QString::fromUtf8(process.readAllStandardError()).trimmed();
+        qDebug() << "提取视频帧失败:" << stdErr;
+        if (errorReason) {
+            // 只保留FFmpeg输出的最后一行，通常是实际的错误原因
+            QString lastLine = stdErr.section('\n', -1).trimmed();
+            *errorReason = lastLine.isEmpty() ? tr("FFmpeg未能输出图像") : lastLine;
+        }
+        return false;
+    }
+}
+
+double VideoLibrary::probeVideoDuration(const QString &videoPath)
+{
+    QProcess process;
+    QStringList durationArgs;
+    durationArgs << "-v" << "error"
+                << "-show_entries" << "format=duration"
+                << "-of" << "default=noprint_wrappers=1:nokey=1"
+                << videoPath;
+
+    process.start("ffprobe", durationArgs);
+    if (!process.waitForFinished(5000)) {
+        qDebug() << "FFprobe执行超时";
+        process.kill();
+        return -1;
+    }
+
+    QString durationStr = QString::fromUtf8(process.readAllStandardOutput()).trimmed();
+    bool ok;
+    double duration = durationStr.toDouble(&ok);
+
+    if (!ok || duration <= 0) {
+        qDebug() << "无法获取视频时长:" << durationStr;
+        return -1;
+    }
+    return duration;
+}
+
+bool VideoLibrary::extractSpriteSheet(const QString &videoPath, const QString &outputPath)
+{
+    if (!QFileInfo::exists(videoPath)) {
+        qDebug() << "视频文件不存在:" << videoPath;
         return false;
     }
+
+    double duration = probeVideoDuration(videoPath);
+    if (duration <= 0) {
+        duration = 60.0; // 默认值
+    }
+
+    // 只解码关键帧(-skip_frame nokey)，按时长均匀取 N 帧，
+    // 在同一次顺序解码中缩放并拼接成 N x 1 的雪碧图，避免 N 次随机跳转
+    QString filter = QString("fps=%1,scale=%2:-2,tile=%3x1")
+                         .arg(SPRITE_FRAME_COUNT / duration, 0, 'f', 6)
+                         .arg(SPRITE_FRAME_WIDTH)
+                         .arg(SPRITE_FRAME_COUNT);
+
+    QStringList args;
+    args << "-y"
+         << "-v" << "error"
+         << "-skip_frame" << "nokey"
+         << "-i" << videoPath
+         << "-an" << "-sn"
+         << "-vf" << filter
+         << "-frames:v" << "1"
+         << "-q:v" << "4"
+         << outputPath;
+
+    QProcess process;
+    process.start("ffmpeg", args);
+    // 需要顺序读完整个文件的关键帧，超时比单帧提取更长
+    if (!process.waitForFinished(60000)) {
+        qDebug() << "FFmpeg生成雪碧图超时:" << videoPath;
+        process.kill();
+        process.waitForFinished();
+        QFile::remove(outputPath);
+        return false;
+    }
+
+    if (process.exitCode() == 0 && QFileInfo::exists(outputPath)) {
+        qDebug() << "成功生成雪碧图:" << outputPath;
+        return true;
+    }
+
+    qDebug() << "生成雪碧图失败:" << process.readAllStandardError();
+    QFile::remove(outputPath);
+    return false;
+}
+
+void VideoLibrary::requestSpriteSheet(quint32 videoId)
+{
+    std::shared_ptr<VideoItem> video = this->video(videoId);
+    if (!video) {
+        return;
+    }
+
+    QString sheetPath = video->spriteSheetPath();
+    if (QFileInfo::exists(sheetPath)) {
+        emit videoSpriteSheetReady(videoId);
+        return;
+    }
+
+    // 同一视频只排队一次；生成失败的在本次运行中不再重试
+    if (m_spriteRequests.contains(videoId)) {
+        return;
+    }
+    m_spriteRequests.insert(videoId);
+
+    // FFmpeg 生成雪碧图与封面提取共用同一设备的并发控制
+    QString videoPath = video->filePath();
+    ConcurrencyController::instance()->submit(videoPath, WorkloadKind::PosterExtraction,
+                                              [this, videoId, videoPath, sheetPath]() {
+        QDir().mkpath(QFileInfo(sheetPath).path());
+        QString tempPath = PosterJobQueue::tempPathFor(sheetPath);
+        bool ok = extractSpriteSheet(videoPath, tempPath)
+                  && commitTempFile(tempPath, sheetPath, nullptr);
+        if (!ok) {
+            QFile::remove(tempPath);
+        }
+
+        // 回到主线程更新状态并通知UI
+        QMetaObject::invokeMethod(this, [this, videoId, ok]() {
+            if (ok) {
+                m_spriteRequests.remove(videoId);
+                emit videoSpriteSheetReady(videoId);
+            }
+        }, Qt::QueuedConnection);
+    }, this);
 }
 
-void VideoLibrary::loadLibraryConfig(const QString &filePath)
+void VideoLibrary::loadLibraryConfig(SettingsStore *settings)
 {
-    QSettings settings(filePath, QSettings::IniFormat);
+    const QString filePath = settings->filePath();
 
     // 加载视频库目录
     m_directories.clear();
-    int size = settings.beginReadArray("Directories");
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        QString dirPath = settings.value("Path").toString();
+    const QStringList dirs = settings->readArray("Directories", "Path");
+    for (const QString &dirPath : dirs) {
         if (!dirPath.isEmpty() && QDir(dirPath).exists()) {
             m_directories.insert(dirPath);
         } else {
              qWarning() << "配置文件中保存的目录无效或不存在:" << dirPath;
         }
     }
-    settings.endArray();
+
+    // 封面提取失败记录与配置文件放在同一目录
+    m_failureCache.setFilePath(QFileInfo(filePath).dir().filePath("poster_failures.ini"));
+    m_failureCache.load();
+
+    // 恢复上次未完成的封面提取任务，不必等待重新扫描
+    m_posterQueue.setFilePath(QFileInfo(filePath).dir().filePath("poster_queue.ini"));
+    m_posterQueue.load();
+    m_posterQueue.retainUnder(directories());
+    // 扫描入队时会检查失败记录，恢复的任务也要检查：仍在退避期内的视频不立即重试
+    const int skipped = m_posterQueue.removeIf([this](const QString &videoPath) {
+        QFileInfo info(videoPath);
+        return m_failureCache.shouldSkip(videoPath, info.size(), info.lastModified());
+    });
+    if (skipped > 0) {
+        qInfo() << "跳过" << skipped << "个仍在失败退避期内的封面提取任务";
+        m_posterQueue.save();
+    }
+    QTimer::singleShot(0, this, &VideoLibrary::runPendingPosterJobs);
+
+    // 媒体库快照，启动时由调用者通过 loadSnapshot() 读取
+    m_snapshotPath = QFileInfo(filePath).dir().filePath("library_snapshot.dat");
 
     // 加载后可以触发一次扫描
     // scanLibrary(); // 或者由调用者决定何时扫描
@@ -399,45 +1068,130 @@ void VideoLibrary::removeDirectoryCovers(const QString &dirPath)
     }
 }
 
-// 将视频添加到 m_videosByDirectory 而不是 m_videos
+// 将需要封面的视频加入持久化队列并开始执行
 void VideoLibrary::startPosterGeneration()
 {
-    if (m_videosNeedingPoster.isEmpty()) {
-        return;
+    // 跳过仍处于退避期且文件未变化的失败视频
+    int skipped = 0;
+    auto skipIt = std::remove_if(m_videosNeedingPoster.begin(), m_videosNeedingPoster.end(),
+                                 [this, &skipped](const std::shared_ptr<VideoItem>& video) {
+                                     bool skip = m_failureCache.shouldSkip(video->filePath(), video->fileSize(),
+                                                                           video->modifiedTime());
+                                     if (skip) {
+                                         skipped++;
+                                     }
+                                     return skip;
+                                 });
+    m_videosNeedingPoster.erase(skipIt, m_videosNeedingPoster.end());
+    if (skipped > 0) {
+        qInfo() << "跳过" << skipped << "个处于退避期的封面提取失败视频";
     }
 
-    qInfo() << "开始异步生成" << m_videosNeedingPoster.size() << "个视频的封面...";
-
-    // 使用 QtConcurrent::map 进行异步处理
-    QFuture<void> future = QtConcurrent::map(m_videosNeedingPoster, [this](std::shared_ptr<VideoItem> video) {
+    for (const auto &video : m_videosNeedingPoster) {
         QString pictureDir = ensurePictureDirectory(video->folderPath());
-        // 使用与VideoItem::checkExtractedPoster相同的文件名格式
+        // 使用与VideoItem::readExtractedPoster相同的文件名格式
         QString baseName = QFileInfo(video->fileName()).completeBaseName();
         QString posterPath = QDir(pictureDir).filePath(baseName + ".jpg");
 
-        if (!QFileInfo::exists(posterPath)) { // 再次检查，以防万一
-             if (extractFrameFromVideo(video->filePath(), posterPath)) {
-                // 使用 VideoItem 提供的公有方法加载生成的封面图片
-                bool loaded = video->checkExtractedPoster(pictureDir);
-                qDebug() << "封面生成完成，加载状态:" << loaded << "路径:" << posterPath;
+        // 记录任务对应的视频对象，完成后用于通知UI；
+        // 启动时已恢复的同一任务不会重复入队
+        m_posterJobVideos.insert(video->filePath(), video->id());
+        m_posterQueue.enqueue(video->filePath(), posterPath);
+    }
+
+    // 清空待处理列表，之后以持久化队列为准
+    m_videosNeedingPoster.clear();
+    m_posterQueue.save();
+
+    runPendingPosterJobs();
+}
+
+void VideoLibrary::runPendingPosterJobs()
+{
+    QVector<PosterJob> jobs = m_posterQueue.takePending();
+    if (jobs.isEmpty()) {
+        return;
+    }
+
+    // 先持久化“执行中”状态，异常退出后据此清理临时文件并重新排队
+    m_posterQueue.save();
 
-                 // 在主线程中处理UI更新或信号发射
-                 QMetaObject::invokeMethod(this, "processGeneratedPoster", Qt::QueuedConnection,
-                                         Q_ARG(std::shared_ptr<VideoItem>, video));
-             } else {
-                 qWarning() << "无法为视频生成封面:" << video->filePath();
-             }
+    qInfo() << "开始异步生成" << jobs.size() << "个视频的封面...";
+
+    // 按视频所在的存储设备分配到各自的自适应线程池
+    for (const PosterJob &job : jobs) {
+        ConcurrencyController::instance()->submit(job.videoPath, WorkloadKind::PosterExtraction, [this, job]() {
+            runPosterJob(job);
+        }, this);
+    }
+}
+
+// 在工作线程中执行单个封面提取任务
+void VideoLibrary::runPosterJob(const PosterJob &job)
+{
+    QString errorReason;
+    bool ok = QFileInfo::exists(job.outputPath); // 已存在则视为完成
+    if (!ok) {
+        // 先写入临时文件再重命名，FFmpeg被中断时不会留下不完整的封面
+        QString tempPath = PosterJobQueue::tempPathFor(job.outputPath);
+        ok = extractFrameFromVideo(job.videoPath, tempPath, &errorReason)
+             && commitTempFile(tempPath, job.outputPath, &errorReason);
+        if (!ok) {
+            QFile::remove(tempPath);
         }
-    });
+    }
 
-    // 可以选择性地添加一个 QFutureWatcher 来监视封面生成的完成
-    // 但目前只在完成后处理单个视频
+    PosterFailure failure;
+    QImage poster;
+    if (ok) {
+        qDebug() << "封面生成完成:" << job.outputPath;
+        m_failureCache.clear(job.videoPath);
+        // 在工作线程中解码一次，界面线程只需转换
+        poster = QImage(job.outputPath);
+    } else {
+        qWarning() << "无法为视频生成封面:" << job.videoPath;
+        QFileInfo videoInfo(job.videoPath);
+        failure = m_failureCache.recordFailure(job.videoPath, videoInfo.size(),
+                                               videoInfo.lastModified(), errorReason);
+    }
+    m_posterQueue.finish(job.videoPath);
 
-    // 清空待处理列表
-    m_videosNeedingPoster.clear();
+    // 在主线程中处理UI更新或信号发射
+    QString videoPath = job.videoPath;
+    QMetaObject::invokeMethod(this, [this, videoPath, ok, failure, poster]() {
+        onPosterJobFinished(videoPath, ok, failure, poster);
+    }, Qt::QueuedConnection);
+}
+
+void VideoLibrary::onPosterJobFinished(const QString &videoPath, bool ok, const PosterFailure &failure,
+                                       const QImage &poster)
+{
+    // 合并短时间内的多次完成（队列和失败记录），避免频繁写盘
+    m_queueSaveTimer->start();
+
+    // 按 ID 取当前的视频对象：任务期间重新扫描过时，文件未变的视频仍是同一 ID
+    // 任务期间视频被移除、其 ID 又分配给其他文件时，按路径核对
+    std::shared_ptr<VideoItem> video;
+    if (m_posterJobVideos.contains(videoPath)) {
+        video = this->video(m_posterJobVideos.take(videoPath));
+        if (video && video->filePath() != videoPath) {
+            video.reset();
+        }
+    }
+    if (!video) {
+        // 启动时恢复的任务，扫描时会直接读取已生成的封面
+        return;
+    }
+
+    if (ok) {
+        processGeneratedPoster(video, poster);
+    } else {
+        video->setPosterFailure(failure.reason, failure.attempts);
+        emit videoPosterFailed(video->id());
+    }
 }
 
-void VideoLibrary::processGeneratedPoster(std::shared_ptr<VideoItem> video)
+void VideoLibrary::processGeneratedPoster(std::shared_ptr<VideoItem> video, const QImage &poster)
 {
     if (!video) {
         qWarning() << "处理生成的封面时收到空视频对象";
@@ -448,20 +1202,19 @@ void VideoLibrary::processGeneratedPoster(std::shared_ptr<VideoItem> video)
     // 因为封面可能已经生成但没有被正确检测到
     qDebug() << "封面已生成并准备就绪:" << video->fileName();
 
-    // 强制重新加载图片
-    QString pictureDir = ensurePictureDirectory(video->folderPath());
-    video->checkExtractedPoster(pictureDir);
+    // 使用工作线程已解码的封面，不再重新读取文件
+    if (poster.isNull()) {
+        qWarning() << "无法解码生成的封面:" << video->fileName();
+    }
+    video->setExtractedPoster(poster);
+    video->setNeedsPosterGeneration(false);
+    video->clearPosterFailure();
 
     // 发送信号更新UI
-    emit videoPosterReady(video);
+    emit videoPosterReady(video->id());
 }
 
-// 添加获取所有视频列表的实现
-QVector<std::shared_ptr<VideoItem>> VideoLibrary::allVideosFlattened() const
+int VideoLibrary::posterFailureCount() const
 {
-    QVector<std::shared_ptr<VideoItem>> allVideos;
-    for (const auto& videoList : m_videosByDirectory.values()) {
-        allVideos.append(videoList);
-    }
-    return allVideos;
-}
\ No newline at end of file
+    return m_failureCache.count();
+}
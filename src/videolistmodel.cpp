@@ -0,0 +1,515 @@
+#include "videolistmodel.h"
+#include "videocatalog.h"
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <numeric>
+
+// 视频数达到该值时分块并行排序，每块至少 PARALLEL_SORT_MIN_CHUNK 个
+static const int PARALLEL_SORT_THRESHOLD = 20000;
+static const int PARALLEL_SORT_MIN_CHUNK = 5000;
+
+// 对下标数组排序：小数组直接排序，大数组分块并行排序后两两归并
+template <typename Compare>
+static void sortIndices(QVector<int> &indices, Compare compare)
+{
+    const int count = indices.size();
+    const int chunkCount = std::min(QThread::idealThreadCount(), count / PARALLEL_SORT_MIN_CHUNK);
+    if (count < PARALLEL_SORT_THRESHOLD || chunkCount < 2) {
+        std::sort(indices.begin(), indices.end(), compare);
+        return;
+    }
+
+    // 分块边界
+    QVector<int> bounds;
+    bounds.reserve(chunkCount + 1);
+    for (int i = 0; i <= chunkCount; ++i) {
+        bounds.append(static_cast<int>(qint64(count) * i / chunkCount));
+    }
+
+    // 先取得数据指针，工作线程中不再调用可能分离（detach）的 begin()
+    int *data = indices.data();
+    QVector<int> chunks(chunkCount);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    QtConcurrent::blockingMap(chunks, [&](int chunk) {
+        std::sort(data + bounds.at(chunk), data + bounds.at(chunk + 1), compare);
+    });
+
+    // 相邻有序段两两归并，每一轮的归并互不重叠，可以并行
+    while (bounds.size() > 2) {
+        QVector<int> merges;
+        for (int i = 0; i + 2 < bounds.size(); i += 2) {
+            merges.append(i);
+        }
+        QtConcurrent::blockingMap(merges, [&](int i) {
+            std::inplace_merge(data + bounds.at(i),
+                               data + bounds.at(i + 1),
+                               data + bounds.at(i + 2),
+                               compare);
+        });
+
+        QVector<int> merged;
+        for (int i = 0; i < bounds.size(); i += 2) {
+            merged.append(bounds.at(i));
+        }
+        if (merged.last() != bounds.last()) {
+            merged.append(bounds.last());
+        }
+        bounds.swap(merged);
+    }
+}
+
+VideoListModel::VideoListModel(const QString &directory, QObject *parent)
+    : AbstractVideoModel(parent),
+      m_directory(directory),
+      m_sortOrder(SortOrder::NameAsc),
+      m_visibleRowOfDirty(true)
+{
+}
+
+int VideoListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rows.size();
+}
+
+QVariant VideoListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const std::shared_ptr<VideoItem> &video = m_videos.at(m_rows.at(index.row()).source);
+    switch (role) {
+        case Qt::DisplayRole:
+            return video->fileName();
+        case Qt::ToolTipRole: {
+            QString toolTip = video->fileName();
+            const VideoMetadata metadata = video->metadata();
+            if (!metadata.title.isEmpty()) {
+                toolTip += QLatin1Char('\n') + metadata.title;
+            }
+            if (!metadata.actors.isEmpty()) {
+                toolTip += QLatin1Char('\n') + tr("演员：%1").arg(metadata.actors.join(QLatin1String("、")));
+            }
+            if (video->hasPosterFailure()) {
+                toolTip += QLatin1Char('\n') + tr("封面提取失败（第 %1 次）：%2")
+                    .arg(video->posterFailureAttempts())
+                    .arg(video->posterFailureReason());
+            }
+            return toolTip;
+        }
+        default:
+            return QVariant();
+    }
+}
+
+std::shared_ptr<VideoItem> VideoListModel::videoAt(int row) const
+{
+    if (row < 0 || row >= m_rows.size()) {
+        return nullptr;
+    }
+    return m_videos.at(m_rows.at(row).source);
+}
+
+int VideoListModel::rowOf(const std::shared_ptr<VideoItem> &video) const
+{
+    return video ? rowOf(video->id()) : -1;
+}
+
+int VideoListModel::rowOf(quint32 videoId) const
+{
+    int sourceRow = m_sourceRowOf.value(videoId, -1);
+    if (sourceRow < 0) {
+        return -1;
+    }
+
+    // 可见行变化后按需重建 m_videos 下标 -> 可见行 的映射，之后每次查找都是 O(1)
+    if (m_visibleRowOfDirty) {
+        m_visibleRowOf.fill(-1, m_videos.size());
+        for (int row = 0; row < m_rows.size(); ++row) {
+            m_visibleRowOf[m_rows.at(row).source] = row;
+        }
+        m_visibleRowOfDirty = false;
+    }
+    return m_visibleRowOf.at(sourceRow);
+}
+
+void VideoListModel::appendVideo(std::shared_ptr<VideoItem> video)
+{
+    insertVideos(QVector<std::shared_ptr<VideoItem>>{video});
+}
+
+void VideoListModel::insertVideos(const QVector<std::shared_ptr<VideoItem>> &videos)
+{
+    if (videos.isEmpty()) {
+        return;
+    }
+
+    const int first = m_videos.size();
+    m_videos.reserve(first + videos.size());
+    m_ranks.reserve(first + videos.size());
+    for (const auto &video : videos) {
+        m_sourceRowOf.insert(video->id(), m_videos.size());
+        m_videos.append(video);
+        m_ranks.append(m_query.rank(*video));
+    }
+    invalidateSortCache();
+
+    // 新视频先单独排序，再与已有的有序排列归并：O(n + k log k)，
+    // 逐个到达时退化为二分插入
+    QVector<int> added(videos.size());
+    std::iota(added.begin(), added.end(), first);
+    auto less = [this](int a, int b) { return sourceLess(a, b); };
+    if (added.size() == 1) {
+        m_order.insert(std::upper_bound(m_order.begin(), m_order.end(), first, less), first);
+    } else {
+        sortIndices(added, less);
+        QVector<int> merged;
+        merged.reserve(m_order.size() + added.size());
+        std::merge(m_order.constBegin(), m_order.constEnd(), added.constBegin(), added.constEnd(),
+                   std::back_inserter(merged), less);
+        m_order.swap(merged);
+    }
+
+    // 已有的可见行不变，只插入新视频所在的行
+    applyVisibleRows(visibleRowsFromRanks());
+}
+
+void VideoListModel::removeVideos(const QVector<quint32> &videoIds)
+{
+    QVector<bool> removed(m_videos.size(), false);
+    bool any = false;
+    for (quint32 videoId : videoIds) {
+        int source = m_sourceRowOf.value(videoId, -1);
+        if (source >= 0) {
+            removed[source] = true;
+            m_ranks[source] = -1;
+            any = true;
+        }
+    }
+    if (!any) {
+        return;
+    }
+
+    // 先按不匹配处理，只通知被移除的可见行
+    applyVisibleRows(visibleRowsFromRanks());
+
+    // 再压缩视频表；下标单调重映射，m_order 和可见行的顺序不变
+    QVector<int> newSource(m_videos.size(), -1);
+    int count = 0;
+    for (int i = 0; i < m_videos.size(); ++i) {
+        if (!removed.at(i)) {
+            newSource[i] = count;
+            m_videos[count] = m_videos.at(i);
+            m_ranks[count] = m_ranks.at(i);
+            ++count;
+        }
+    }
+    m_videos.resize(count);
+    m_ranks.resize(count);
+
+    QVector<int> order;
+    order.reserve(count);
+    for (int source : qAsConst(m_order)) {
+        if (newSource.at(source) >= 0) {
+            order.append(newSource.at(source));
+        }
+    }
+    m_order.swap(order);
+    for (VisibleRow &row : m_rows) {
+        row.source = newSource.at(row.source);
+    }
+
+    m_sourceRowOf.clear();
+    m_sourceRowOf.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        m_sourceRowOf.insert(m_videos.at(i)->id(), i);
+    }
+    m_visibleRowOfDirty = true;
+    invalidateSortCache();
+}
+
+void VideoListModel::setVideos(const QVector<std::shared_ptr<VideoItem>> &videos)
+{
+    beginResetModel();
+    m_videos = videos;
+    m_ranks.resize(m_videos.size());
+    m_sourceRowOf.clear();
+    m_sourceRowOf.reserve(m_videos.size());
+    for (int i = 0; i < m_videos.size(); ++i) {
+        m_ranks[i] = m_query.rank(*m_videos.at(i));
+        m_sourceRowOf.insert(m_videos.at(i)->id(), i);
+    }
+    invalidateSortCache();
+    SortKeyKind kind = keyKindOf(m_sortOrder);
+    m_sortCache[kind] = ascendingPermutation(kind);
+    m_order = m_sortCache[kind];
+    if (isDescending(m_sortOrder)) {
+        std::reverse(m_order.begin(), m_order.end());
+    }
+    m_rows = visibleRowsFromRanks();
+    m_visibleRowOfDirty = true;
+    endResetModel();
+}
+
+void VideoListModel::clear()
+{
+    if (m_videos.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    m_videos.clear();
+    m_ranks.clear();
+    m_order.clear();
+    m_rows.clear();
+    m_sourceRowOf.clear();
+    m_visibleRowOfDirty = true;
+    invalidateSortCache();
+    endResetModel();
+}
+
+void VideoListModel::sortBy(SortOrder order)
+{
+    // m_order 始终按 m_sortOrder 有序，排序方式不变时无需任何操作
+    if (order == m_sortOrder) {
+        return;
+    }
+    if (m_videos.size() < 2) {
+        m_sortOrder = order;
+        return;
+    }
+
+    // 升序排列按排序键缓存，降序直接反转，切换排序方式时通常无需重新排序
+    SortKeyKind kind = keyKindOf(order);
+    if (m_sortCache[kind].size() != m_videos.size()) {
+        m_sortCache[kind] = ascendingPermutation(kind);
+    }
+
+    emit layoutAboutToBeChanged();
+
+    // 记录持久索引对应的视频，排序后映射到新行
+    const QModelIndexList persistent = persistentIndexList();
+    QVector<std::shared_ptr<VideoItem>> persistentVideos;
+    persistentVideos.reserve(persistent.size());
+    for (const QModelIndex &index : persistent) {
+        persistentVideos.append(videoAt(index.row()));
+    }
+
+    m_sortOrder = order;
+    m_order = m_sortCache[kind];
+    if (isDescending(order)) {
+        std::reverse(m_order.begin(), m_order.end());
+    }
+    m_rows = visibleRowsFromRanks();
+    m_visibleRowOfDirty = true;
+
+    if (!persistent.isEmpty()) {
+        QModelIndexList updated;
+        updated.reserve(persistent.size());
+        for (const std::shared_ptr<VideoItem> &video : persistentVideos) {
+            int row = rowOf(video);
+            updated.append(row >= 0 ? index(row) : QModelIndex());
+        }
+        changePersistentIndexList(persistent, updated);
+    }
+
+    emit layoutChanged();
+}
+
+int VideoListModel::compareVideos(const VideoItem &a, const VideoItem &b, SortOrder order)
+{
+    int result = 0;
+    switch (keyKindOf(order)) {
+        case SortKeyName:
+            result = VideoCatalog::instance()->compareNameSortKeys(a.id(), b.id());
+            break;
+        case SortKeyCreation:
+            result = a.creationSortKey() < b.creationSortKey() ? -1
+                   : (a.creationSortKey() > b.creationSortKey() ? 1 : 0);
+            break;
+        case SortKeyModified:
+            result = a.modifiedSortKey() < b.modifiedSortKey() ? -1
+                   : (a.modifiedSortKey() > b.modifiedSortKey() ? 1 : 0);
+            break;
+        default:
+            break;
+    }
+    return isDescending(order) ? -result : result;
+}
+
+bool VideoListModel::sourceLess(int a, int b) const
+{
+    int result = compareVideos(*m_videos.at(a), *m_videos.at(b), m_sortOrder);
+
+    // 与“升序排列反转得到降序”保持一致：键相同时升序按下标递增，降序按下标递减
+    if (result == 0) {
+        return isDescending(m_sortOrder) ? a > b : a < b;
+    }
+    return result < 0;
+}
+
+bool VideoListModel::rowLess(const VisibleRow &a, const VisibleRow &b) const
+{
+    if (a.rank != b.rank) {
+        return a.rank < b.rank;
+    }
+    return sourceLess(a.source, b.source);
+}
+
+VideoListModel::SortKeyKind VideoListModel::keyKindOf(SortOrder order)
+{
+    switch (order) {
+        case SortOrder::CreationTimeAsc:
+        case SortOrder::CreationTimeDesc:
+            return SortKeyCreation;
+        case SortOrder::ModifiedTimeAsc:
+        case SortOrder::ModifiedTimeDesc:
+            return SortKeyModified;
+        default:
+            return SortKeyName;
+    }
+}
+
+bool VideoListModel::isDescending(SortOrder order)
+{
+    return order == SortOrder::NameDesc
+        || order == SortOrder::CreationTimeDesc
+        || order == SortOrder::ModifiedTimeDesc;
+}
+
+QVector<int> VideoListModel::ascendingPermutation(SortKeyKind kind) const
+{
+    QVector<int> indices(m_videos.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    // 把排序键复制到紧凑数组中，比较时不再经过 shared_ptr 和虚函数/分配；
+    // 键相同时按下标比较，保证顺序确定，降序可以直接反转
+    if (kind == SortKeyName) {
+        QVector<QString> keys;
+        keys.reserve(m_videos.size());
+        for (const auto &video : m_videos) {
+            keys.append(video->nameSortKey());
+        }
+        sortIndices(indices, [&keys](int a, int b) {
+            int result = keys.at(a).compare(keys.at(b));
+            return result != 0 ? result < 0 : a < b;
+        });
+    } else {
+        QVector<qint64> keys;
+        keys.reserve(m_videos.size());
+        for (const auto &video : m_videos) {
+            keys.append(kind == SortKeyCreation ? video->creationSortKey() : video->modifiedSortKey());
+        }
+        sortIndices(indices, [&keys](int a, int b) {
+            return keys.at(a) != keys.at(b) ? keys.at(a) < keys.at(b) : a < b;
+        });
+    }
+    return indices;
+}
+
+void VideoListModel::invalidateSortCache()
+{
+    for (QVector<int> &cache : m_sortCache) {
+        cache.clear();
+    }
+}
+
+void VideoListModel::setSearch(const VideoSearchQuery &query, const QVector<SearchMatch> &matches)
+{
+    m_query = query;
+
+    // 索引已给出全库的匹配结果，只需映射到本模型的行
+    if (query.isEmpty()) {
+        m_ranks.fill(SearchRankSubstring);
+    } else {
+        m_ranks.fill(-1);
+        for (const SearchMatch &match : matches) {
+            int sourceRow = m_sourceRowOf.value(match.video->id(), -1);
+            if (sourceRow >= 0) {
+                m_ranks[sourceRow] = match.rank;
+            }
+        }
+    }
+    applyVisibleRows(visibleRowsFromRanks());
+}
+
+QVector<VideoListModel::VisibleRow> VideoListModel::visibleRowsFromRanks() const
+{
+    // 按 m_order 遍历，同一排名内自然有序；排名只有几个取值，按排名分桶后拼接
+    int maxRank = -1;
+    for (int rank : m_ranks) {
+        maxRank = std::max(maxRank, rank);
+    }
+
+    QVector<QVector<VisibleRow>> buckets(maxRank + 1);
+    for (int source : m_order) {
+        int rank = m_ranks.at(source);
+        if (rank >= 0) {
+            buckets[rank].append(VisibleRow{rank, source});
+        }
+    }
+
+    if (buckets.size() == 1) {
+        return buckets.first();
+    }
+    QVector<VisibleRow> rows;
+    rows.reserve(m_order.size());
+    for (const QVector<VisibleRow> &bucket : qAsConst(buckets)) {
+        rows += bucket;
+    }
+    return rows;
+}
+
+void VideoListModel::applyVisibleRows(const QVector<VisibleRow> &rows)
+{
+    // 新旧可见行按同一顺序排列，合并遍历一次即可得到差异，
+    // 连续的移除/插入合并为一次通知，未变化的行保持不动；
+    // 排名变化的视频表现为一次移除和一次插入
+    int pos = 0;
+    int next = 0;
+    while (pos < m_rows.size() || next < rows.size()) {
+        if (pos < m_rows.size() && next < rows.size() && m_rows.at(pos) == rows.at(next)) {
+            ++pos;
+            ++next;
+            continue;
+        }
+
+        if (pos < m_rows.size() && (next >= rows.size() || rowLess(m_rows.at(pos), rows.at(next)))) {
+            // 移除不再匹配的连续区间
+            int end = pos;
+            while (end < m_rows.size() && (next >= rows.size() || rowLess(m_rows.at(end), rows.at(next)))) {
+                ++end;
+            }
+            beginRemoveRows(QModelIndex(), pos, end - 1);
+            m_rows.remove(pos, end - pos);
+            m_visibleRowOfDirty = true;
+            endRemoveRows();
+            continue;
+        }
+
+        // 插入新匹配的连续区间
+        int end = next;
+        while (end < rows.size() && (pos >= m_rows.size() || rowLess(rows.at(end), m_rows.at(pos)))) {
+            ++end;
+        }
+        beginInsertRows(QModelIndex(), pos, pos + (end - next) - 1);
+        m_rows.insert(pos, end - next, VisibleRow{0, 0});
+        m_visibleRowOfDirty = true;
+        std::copy(rows.constBegin() + next, rows.constBegin() + end, m_rows.begin() + pos);
+        endInsertRows();
+        pos += end - next;
+        next = end;
+    }
+}
+
+void AbstractVideoModel::videoChanged(quint32 videoId)
+{
+    int row = rowOf(videoId);
+    if (row >= 0) {
+        QModelIndex changed = index(row);
+        emit dataChanged(changed, changed);
+    }
+}
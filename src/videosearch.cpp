@@ -0,0 +1,351 @@
+#include "videosearch.h"
+#include "videoitem.h"
+#include <QRegularExpression>
+#include <QDate>
+
+// Bitap 使用64位状态字，更长的搜索词只做精确匹配
+static const int MAX_FUZZY_PATTERN_LENGTH = 64;
+
+// 搜索词长度到允许错误数的映射，短词不做近似匹配以免结果过多
+static int maxErrorsForLength(int length)
+{
+    if (length >= 10) return 2;
+    if (length >= 6) return 1;
+    return 0;
+}
+
+// 按空白切分搜索框文字，双引号内的空白不切分
+static QStringList tokenize(const QString &text)
+{
+    QStringList tokens;
+    QString current;
+    bool quoted = false;
+    for (QChar c : text) {
+        if (c == QLatin1Char('"')) {
+            quoted = !quoted;
+        } else if (c.isSpace() && !quoted) {
+            if (!current.isEmpty()) {
+                tokens.append(current);
+                current.clear();
+            }
+            continue;
+        }
+        current.append(c);
+    }
+    if (!current.isEmpty()) {
+        tokens.append(current);
+    }
+    return tokens;
+}
+
+// 解析 2G、500M、1.5GB、123456 这样的大小（按 1024 进位），失败返回 -1
+static qint64 parseSize(const QString &text)
+{
+    static const QRegularExpression sizePattern(QStringLiteral("^(\\d+(?:\\.\\d+)?)\\s*([kmgt]?)i?b?$"),
+                                                QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch match = sizePattern.match(text);
+    if (!match.hasMatch()) {
+        return -1;
+    }
+    double size = match.captured(1).toDouble();
+    const QString unit = match.captured(2).toLower();
+    const int power = unit.isEmpty() ? 0 : QStringLiteral("kmgt").indexOf(unit) + 1;
+    for (int i = 0; i < power; ++i) {
+        size *= 1024;
+    }
+    return qint64(size);
+}
+
+bool VideoSearchQuery::parseFilter(const QString &token, FacetFilter *filter)
+{
+    // [-]键 比较符 值；键可以是英文或中文
+    static const QRegularExpression filterPattern(QStringLiteral("^(-?)(\\w+)(>=|<=|:|=|>|<)(.+)$"),
+                                                  QRegularExpression::UseUnicodePropertiesOption);
+    static const QHash<QString, FacetField> fields = {
+        { QStringLiteral("actor"), FacetField::Actor }, { QStringLiteral("演员"), FacetField::Actor },
+        { QStringLiteral("genre"), FacetField::Genre }, { QStringLiteral("tag"), FacetField::Genre },
+        { QStringLiteral("类别"), FacetField::Genre },
+        { QStringLiteral("studio"), FacetField::Studio }, { QStringLiteral("maker"), FacetField::Studio },
+        { QStringLiteral("片商"), FacetField::Studio },
+        { QStringLiteral("year"), FacetField::Date }, { QStringLiteral("年份"), FacetField::Date },
+        { QStringLiteral("date"), FacetField::Date }, { QStringLiteral("日期"), FacetField::Date },
+        { QStringLiteral("size"), FacetField::Size }, { QStringLiteral("大小"), FacetField::Size },
+        { QStringLiteral("rating"), FacetField::Rating }, { QStringLiteral("评分"), FacetField::Rating }
+    };
+
+    QRegularExpressionMatch match = filterPattern.match(token);
+    if (!match.hasMatch()) {
+        return false;
+    }
+    const QString key = match.captured(2).toCaseFolded();
+    auto field = fields.constFind(key);
+    if (field == fields.constEnd()) {
+        return false;
+    }
+    const QString op = match.captured(3);
+    const QString value = match.captured(4).remove(QLatin1Char('"')).trimmed();
+
+    FacetFilter result;
+    result.field = field.value();
+    result.negated = !match.captured(1).isEmpty();
+
+    if (!result.isRange()) {
+        if (op != QLatin1String(":") && op != QLatin1String("=")) {
+            return false;
+        }
+        for (const QString &part : value.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+            const QString folded = part.trimmed().toCaseFolded();
+            if (!folded.isEmpty()) {
+                result.values.append(folded);
+            }
+        }
+        if (result.values.isEmpty()) {
+            return false;
+        }
+        *filter = result;
+        return true;
+    }
+
+    // 先把值解析为区间 [low, high]，再按比较符确定范围
+    qint64 low = 0;
+    qint64 high = 0;
+    if (key == QLatin1String("year") || key == QStringLiteral("年份")) {
+        bool ok = false;
+        const int year = value.toInt(&ok);
+        if (!ok || !QDate(year, 1, 1).isValid()) {
+            return false;
+        }
+        low = QDate(year, 1, 1).toJulianDay();
+        high = QDate(year, 12, 31).toJulianDay();
+    } else if (result.field == FacetField::Date) {
+        const QDate date = QDate::fromString(value, Qt::ISODate);
+        if (!date.isValid()) {
+            return false;
+        }
+        low = high = date.toJulianDay();
+    } else if (result.field == FacetField::Size) {
+        low = high = parseSize(value);
+        if (low < 0) {
+            return false;
+        }
+    } else {
+        bool ok = false;
+        const double rating = value.toDouble(&ok);
+        if (!ok) {
+            return false;
+        }
+        low = high = qRound(rating * 10);
+    }
+
+    if (op == QLatin1String(">=")) {
+        result.min = low;
+    } else if (op == QLatin1String(">")) {
+        result.min = high + 1;
+    } else if (op == QLatin1String("<=")) {
+        result.max = high;
+    } else if (op == QLatin1String("<")) {
+        result.max = low - 1;
+    } else {
+        result.min = low;
+        result.max = high;
+    }
+    *filter = result;
+    return true;
+}
+
+VideoSearchQuery::VideoSearchQuery(const QString &rawText)
+{
+    // 不含比较符时整段都是搜索词，不必切分
+    QString text = rawText;
+    static const QRegularExpression operatorPattern(QStringLiteral("[:=<>]"));
+    if (text.contains(operatorPattern)) {
+        QStringList words;
+        for (const QString &token : tokenize(rawText)) {
+            FacetFilter filter;
+            if (parseFilter(token, &filter)) {
+                m_filters.append(filter);
+            } else {
+                words.append(token);
+            }
+        }
+        text = words.join(QLatin1Char(' '));
+    }
+
+    m_text = text.trimmed().toCaseFolded();
+    m_code = normalizeCode(text);
+    if (m_text.size() > MAX_FUZZY_PATTERN_LENGTH) {
+        return;
+    }
+
+    m_maxErrors = maxErrorsForLength(m_text.size());
+    for (int i = 0; i < m_text.size(); ++i) {
+        ushort c = m_text.at(i).unicode();
+        if (c < 128) {
+            m_asciiMasks[c] |= quint64(1) << i;
+        } else {
+            m_otherMasks[c] |= quint64(1) << i;
+        }
+    }
+}
+
+quint64 VideoSearchQuery::maskFor(QChar c) const
+{
+    ushort code = c.unicode();
+    if (code < 128) {
+        return m_asciiMasks[code];
+    }
+    return m_otherMasks.value(code, 0);
+}
+
+QString VideoSearchQuery::normalizeCode(const QString &text)
+{
+    // 字母前缀 + 可选分隔符 + 数字，例如 ABP-123 / abp_00123 / SSIS123
+    static const QRegularExpression codePattern(
+        QStringLiteral("(?<![A-Za-z])([A-Za-z]{2,6})[-_ ]?(\\d{2,6})(?!\\d)"));
+
+    QRegularExpressionMatch match = codePattern.match(text);
+    if (!match.hasMatch()) {
+        return QString();
+    }
+
+    QString digits = match.captured(2);
+    int firstNonZero = 0;
+    while (firstNonZero < digits.size() - 1 && digits.at(firstNonZero) == QLatin1Char('0')) {
+        ++firstNonZero;
+    }
+    return match.captured(1).toUpper() + digits.mid(firstNonZero);
+}
+
+// 视频的某个取值分面是否包含过滤条件中的任一值（子串匹配，与 FacetIndex 一致）
+static bool anyValueMatches(const QStringList &videoValues, const QStringList &filterValues)
+{
+    for (const QString &videoValue : videoValues) {
+        const QString folded = videoValue.toCaseFolded();
+        for (const QString &value : filterValues) {
+            if (folded.contains(value)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool inRange(qint64 value, const FacetFilter &filter)
+{
+    return value >= filter.min && value <= filter.max;
+}
+
+bool VideoSearchQuery::matchesFilters(const VideoItem &video) const
+{
+    if (m_filters.isEmpty()) {
+        return true;
+    }
+
+    const VideoMetadata metadata = video.metadata();
+    for (const FacetFilter &filter : m_filters) {
+        bool matched = false;
+        switch (filter.field) {
+            case FacetField::Actor:
+                matched = anyValueMatches(metadata.actors, filter.values);
+                break;
+            case FacetField::Genre:
+                matched = anyValueMatches(metadata.genres, filter.values);
+                break;
+            case FacetField::Studio:
+                matched = !metadata.studio.isEmpty() && anyValueMatches(QStringList{metadata.studio}, filter.values);
+                break;
+            case FacetField::Date:
+                matched = metadata.releaseDate.isValid() && inRange(metadata.releaseDate.toJulianDay(), filter);
+                break;
+            case FacetField::Size:
+                matched = inRange(video.fileSize(), filter);
+                break;
+            case FacetField::Rating:
+                matched = metadata.rating > 0 && inRange(qRound(metadata.rating * 10), filter);
+                break;
+        }
+        if (matched == filter.negated) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int VideoSearchQuery::rank(const VideoItem &video) const
+{
+    if (!matchesFilters(video)) {
+        return -1;
+    }
+    if (m_text.isEmpty()) {
+        return SearchRankSubstring;
+    }
+    if (!m_code.isEmpty() && video.codeKey() == m_code) {
+        return SearchRankCode;
+    }
+    const QString searchText = video.searchText();
+    if (searchText.contains(m_text)) {
+        return SearchRankSubstring;
+    }
+    int distance = fuzzyDistance(searchText);
+    if (distance > 0) {
+        return SearchRankFuzzy + distance - 1;
+    }
+    return -1;
+}
+
+int VideoSearchQuery::fuzzyDistance(QStringView searchText) const
+{
+    if (m_maxErrors <= 0 || m_text.isEmpty()) {
+        return -1;
+    }
+
+    // Wu-Manber 的 Bitap 近似匹配：state[d] 的第 i 位表示搜索词前 i+1 个字符
+    // 在不超过 d 个错误（替换/插入/删除）下与当前位置之前的文本匹配
+    const int k = m_maxErrors;
+    const quint64 accept = quint64(1) << (m_text.size() - 1);
+    quint64 state[3];
+    for (int d = 0; d <= k; ++d) {
+        state[d] = (quint64(1) << d) - 1; // 开头删除 d 个字符
+    }
+
+    int best = -1;
+    for (int pos = 0; pos < searchText.size(); ++pos) {
+        const quint64 mask = maskFor(searchText.at(pos));
+        quint64 previousOld = state[0];
+        state[0] = ((state[0] << 1) | 1) & mask;
+        for (int d = 1; d <= k; ++d) {
+            quint64 old = state[d];
+            state[d] = (((old << 1) | 1) & mask)   // 匹配
+                     | previousOld                 // 文本多出一个字符
+                     | ((previousOld << 1) | 1)    // 替换
+                     | ((state[d - 1] << 1) | 1);  // 搜索词多出一个字符
+            previousOld = old;
+        }
+
+        for (int d = 0; d <= k; ++d) {
+            if (state[d] & accept) {
+                if (best == -1 || d < best) {
+                    best = d;
+                }
+                break;
+            }
+        }
+        if (best == 0) {
+            break;
+        }
+    }
+
+    // 0 个错误即精确子串，由调用方按子串匹配处理
+    return best > 0 ? best : -1;
+}
+
+bool VideoSearchQuery::refines(const VideoSearchQuery &previous) const
+{
+    // 搜索词是上次的扩展且允许的错误数不变时，能近似匹配本次搜索词的文本
+    // 一定也能近似匹配上次的搜索词
+    // 过滤条件不同时上次的结果不能复用
+    return !previous.m_text.isEmpty()
+        && m_filters == previous.m_filters
+        && m_text.contains(previous.m_text)
+        && m_maxErrors == previous.m_maxErrors;
+}
@@ -0,0 +1,129 @@
+#include "xxhash64.h"
+#include <QtEndian>
+#include <cstring>
+
+static const quint64 PRIME1 = 0x9E3779B185EBCA87ULL;
+static const quint64 PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const quint64 PRIME3 = 0x165667B19E3779F9ULL;
+static const quint64 PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const quint64 PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline quint64 rotl(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64 round64(quint64 acc, quint64 input)
+{
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline quint64 mergeRound(quint64 acc, quint64 value)
+{
+    acc ^= round64(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+static inline quint64 read64(const unsigned char *p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+static inline quint32 read32(const unsigned char *p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+XxHash64::XxHash64(quint64 seed)
+    : m_totalLength(0),
+      m_bufferSize(0)
+{
+    m_acc[0] = seed + PRIME1 + PRIME2;
+    m_acc[1] = seed + PRIME2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - PRIME1;
+}
+
+void XxHash64::update(const void *data, qsizetype length)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const unsigned char *end = p + length;
+    m_totalLength += quint64(length);
+
+    // 先补满上次剩下的半组
+    if (m_bufferSize + length < 32) {
+        std::memcpy(m_buffer + m_bufferSize, p, size_t(length));
+        m_bufferSize += int(length);
+        return;
+    }
+    if (m_bufferSize > 0) {
+        const int fill = 32 - m_bufferSize;
+        std::memcpy(m_buffer + m_bufferSize, p, size_t(fill));
+        for (int i = 0; i < 4; ++i) {
+            m_acc[i] = round64(m_acc[i], read64(m_buffer + i * 8));
+        }
+        p += fill;
+        m_bufferSize = 0;
+    }
+
+    // 整组处理
+    while (end - p >= 32) {
+        m_acc[0] = round64(m_acc[0], read64(p));
+        m_acc[1] = round64(m_acc[1], read64(p + 8));
+        m_acc[2] = round64(m_acc[2], read64(p + 16));
+        m_acc[3] = round64(m_acc[3], read64(p + 24));
+        p += 32;
+    }
+
+    m_bufferSize = int(end - p);
+    std::memcpy(m_buffer, p, size_t(m_bufferSize));
+}
+
+quint64 XxHash64::digest() const
+{
+    quint64 h;
+    if (m_totalLength >= 32) {
+        h = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            h = mergeRound(h, m_acc[i]);
+        }
+    } else {
+        // 不足一组时 m_acc[2] 仍是种子
+        h = m_acc[2] + PRIME5;
+    }
+    h += m_totalLength;
+
+    const unsigned char *p = m_buffer;
+    const unsigned char *end = m_buffer + m_bufferSize;
+    while (end - p >= 8) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        h ^= quint64(read32(p)) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= quint64(*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+quint64 XxHash64::hash(const void *data, qsizetype length, quint64 seed)
+{
+    XxHash64 hasher(seed);
+    hasher.update(data, length);
+    return hasher.digest();
+}